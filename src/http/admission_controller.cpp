@@ -0,0 +1,78 @@
+#include "admission_controller.hpp"
+#include <cmath>
+#include <limits>
+
+namespace Gecko {
+
+namespace {
+
+/* Episodes that restart within this many intervals keep their drop rate */
+constexpr int64_t RESUME_INTERVALS = 16;
+
+} // namespace
+
+AdmissionController::AdmissionController(Clock::duration target, Clock::duration interval)
+    : target_(target), interval_(interval) {}
+
+bool AdmissionController::admit(size_t queued, Clock::time_point now) {
+    if (queued == 0 || !shedding(now)) {
+        return true;
+    }
+    int64_t current = ticks(now);
+    int64_t drop_next = drop_next_.load(std::memory_order_relaxed);
+    /* One IO thread wins each rejection; the rest admit until the next one is due */
+    if (current < drop_next ||
+        !drop_next_.compare_exchange_strong(drop_next, std::numeric_limits<int64_t>::max(),
+                                            std::memory_order_relaxed)) {
+        return true;
+    }
+    uint32_t count = count_.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto spacing = static_cast<int64_t>(static_cast<double>(interval_.count()) / std::sqrt(count));
+    drop_next_.store(current + spacing, std::memory_order_relaxed);
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void AdmissionController::record(Clock::duration sojourn, Clock::time_point now) {
+    if (sojourn < target_) {
+        /* The queue drained at least once: not a standing queue */
+        if (first_above_.load(std::memory_order_relaxed) != 0) {
+            first_above_.store(0, std::memory_order_relaxed);
+        }
+        if (shed_until_.load(std::memory_order_relaxed) != 0) {
+            shed_until_.store(0, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    int64_t current = ticks(now);
+    int64_t first_above = first_above_.load(std::memory_order_relaxed);
+    if (first_above == 0) {
+        first_above_.compare_exchange_strong(first_above, current, std::memory_order_relaxed);
+        return;
+    }
+    if (current - first_above >= interval_.count()) {
+        if (current >= shed_until_.load(std::memory_order_relaxed)) {
+            start_shedding(current);
+        }
+        shed_until_.store(current + interval_.count(), std::memory_order_relaxed);
+    }
+}
+
+void AdmissionController::start_shedding(int64_t current) {
+    uint32_t count = count_.load(std::memory_order_relaxed);
+    uint32_t last_count = last_count_.load(std::memory_order_relaxed);
+    int64_t since_last = current - drop_next_.load(std::memory_order_relaxed);
+    uint32_t delta = count > last_count ? count - last_count : 0;
+    /* The last episode's rate is a good guess for this one if it was recent */
+    uint32_t resume = delta > 1 && since_last < RESUME_INTERVALS * interval_.count() ? delta : 1;
+    last_count_.store(resume, std::memory_order_relaxed);
+    count_.store(resume - 1, std::memory_order_relaxed);
+    drop_next_.store(current, std::memory_order_relaxed);
+}
+
+bool AdmissionController::shedding(Clock::time_point now) const {
+    return ticks(now) < shed_until_.load(std::memory_order_relaxed);
+}
+
+} /* namespace Gecko */
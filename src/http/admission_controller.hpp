@@ -0,0 +1,63 @@
+#ifndef ADMISSION_CONTROLLER_HPP
+#define ADMISSION_CONTROLLER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Gecko {
+
+/*
+ * CoDel admission control. Workers report how long each request sat in the
+ * queue (its sojourn time). Once every sample has stayed above target for a
+ * whole interval the queue is standing rather than bursting and shedding
+ * starts: admit() turns one request away at once, then the next after
+ * interval/sqrt(count), so the rejection rate climbs until the delay comes
+ * down. A shedding episode that restarts soon after the last one resumes
+ * near its rate. The first sample back under target ends shedding, and
+ * nothing is shed while the queue is empty or once an interval passes
+ * without samples.
+ *
+ * Lock-free: admit() runs on the IO threads for every request, record() on
+ * the workers.
+ */
+class AdmissionController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds DEFAULT_TARGET{5};
+    static constexpr std::chrono::milliseconds DEFAULT_INTERVAL{100};
+
+    explicit AdmissionController(Clock::duration target = DEFAULT_TARGET,
+                                 Clock::duration interval = DEFAULT_INTERVAL);
+
+    /* False when the request should be shed; queued is the current backlog. Counts rejections */
+    bool admit(size_t queued, Clock::time_point now = Clock::now());
+
+    /* Queue delay of a request a worker has just picked up */
+    void record(Clock::duration sojourn, Clock::time_point now = Clock::now());
+
+    bool shedding(Clock::time_point now = Clock::now()) const;
+    size_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+    Clock::duration target() const { return target_; }
+    Clock::duration interval() const { return interval_; }
+
+private:
+    static int64_t ticks(Clock::time_point point) { return point.time_since_epoch().count(); }
+    void start_shedding(int64_t current);
+
+    Clock::duration target_;
+    Clock::duration interval_;
+    std::atomic<int64_t> first_above_{0};  /* When sojourn went above target; 0 when below */
+    std::atomic<int64_t> shed_until_{0};   /* Shedding lapses here unless refreshed */
+    std::atomic<int64_t> drop_next_{0};    /* Earliest time admit() may reject again */
+    std::atomic<uint32_t> count_{0};       /* Rejections in this episode */
+    std::atomic<uint32_t> last_count_{0};  /* count_ just after the previous episode's first rejection */
+    std::atomic<size_t> rejected_{0};
+};
+
+} /* namespace Gecko */
+
+#endif /* ADMISSION_CONTROLLER_HPP */
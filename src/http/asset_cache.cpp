@@ -0,0 +1,224 @@
+#include "asset_cache.hpp"
+#include <array>
+#include <cerrno>
+#include <iterator>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace Gecko {
+
+namespace {
+
+constexpr int WATCH_POLL_MS = 100;
+constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+/* Encoded siblings invalidate their source's entry */
+constexpr std::array<std::string_view, 3> VARIANT_SUFFIXES = {".gz", ".br", ".zst"};
+
+std::string_view directoryOf(std::string_view path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string_view::npos) return ".";
+    return slash == 0 ? std::string_view("/") : path.substr(0, slash);
+}
+
+} // namespace
+
+size_t CachedAsset::bytes() const {
+    size_t total = 0;
+    for (const auto& variant : variants) {
+        total += variant.body ? variant.body->size() : 0;
+        total += variant.headers ? variant.headers->size() : 0;
+    }
+    return total;
+}
+
+AssetCache::AssetCache(size_t byte_budget) : byte_budget_(byte_budget), hand_(ring_.end()) {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0) {
+        watcher_ = std::thread([this] { watch_loop(); });
+    }
+}
+
+AssetCache::~AssetCache() {
+    running_ = false;
+    if (watcher_.joinable()) {
+        watcher_.join();
+    }
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+}
+
+std::shared_ptr<const CachedAsset> AssetCache::find(const std::string& path) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(path);
+    if (it == entries_.end()) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (!it->second.referenced.load(std::memory_order_relaxed)) {
+        it->second.referenced.store(true, std::memory_order_relaxed);
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second.asset;
+}
+
+bool AssetCache::watch(const std::string& path) {
+    if (!enabled()) return false;
+    std::string dir(directoryOf(path));
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (watched_dirs_.count(dir)) return true;
+
+    int wd = inotify_add_watch(inotify_fd_, dir.c_str(), WATCH_MASK);
+    if (wd < 0) return false;
+    watched_dirs_[dir] = wd;
+    watch_paths_[wd] = dir;
+    return true;
+}
+
+bool AssetCache::insert(const std::string& path, std::shared_ptr<const CachedAsset> asset, uint64_t epoch) {
+    size_t bytes = asset->bytes();
+    if (!enabled() || bytes > byte_budget_) return false;
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (epoch != epoch_.load(std::memory_order_acquire)) {
+        return false;  /* The file changed while it was being read */
+    }
+    if (!watched_dirs_.count(std::string(directoryOf(path)))) {
+        return false;
+    }
+    auto existing = entries_.find(path);
+    if (existing != entries_.end()) {
+        erase_locked(existing);
+    }
+    while (bytes_ + bytes > byte_budget_ && !ring_.empty()) {
+        evict_one_locked();
+    }
+    /* Behind the hand: a full sweep passes before the new entry is a candidate */
+    auto position = ring_.insert(hand_, path);
+    if (hand_ == ring_.end()) {
+        hand_ = position;
+    }
+    entries_.try_emplace(path, std::move(asset), position, bytes);
+    bytes_ += bytes;
+    return true;
+}
+
+void AssetCache::invalidate(const std::string& path) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    epoch_.fetch_add(1, std::memory_order_acq_rel);
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+        erase_locked(it);
+    }
+}
+
+void AssetCache::clear() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    epoch_.fetch_add(1, std::memory_order_acq_rel);
+    entries_.clear();
+    ring_.clear();
+    hand_ = ring_.end();
+    bytes_ = 0;
+}
+
+size_t AssetCache::size_bytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return bytes_;
+}
+
+size_t AssetCache::entry_count() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void AssetCache::erase_locked(std::unordered_map<std::string, Slot>::iterator it) {
+    bytes_ -= it->second.bytes;
+    if (hand_ == it->second.ring) {
+        ++hand_;
+    }
+    ring_.erase(it->second.ring);
+    if (hand_ == ring_.end()) {
+        hand_ = ring_.begin();
+    }
+    entries_.erase(it);
+}
+
+/* Advance the hand, clearing referenced bits, until an unreferenced entry comes up */
+void AssetCache::evict_one_locked() {
+    while (true) {
+        auto it = entries_.find(*hand_);
+        if (it->second.referenced.exchange(false, std::memory_order_relaxed)) {
+            if (++hand_ == ring_.end()) {
+                hand_ = ring_.begin();
+            }
+            continue;
+        }
+        erase_locked(it);
+        return;
+    }
+}
+
+void AssetCache::watch_loop() {
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    while (running_) {
+        struct pollfd pfd{inotify_fd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, WATCH_POLL_MS);
+        if (ready <= 0) continue;
+
+        ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+        if (length <= 0) continue;
+        for (char* ptr = buffer; ptr < buffer + length;) {
+            auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+            std::string_view name = event->len ? std::string_view(event->name) : std::string_view();
+            handle_event(event->wd, event->mask, name);
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+void AssetCache::handle_event(int wd, uint32_t mask, std::string_view name) {
+    if (mask & IN_Q_OVERFLOW) {
+        clear();
+        return;
+    }
+
+    std::string dir;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = watch_paths_.find(wd);
+        if (it == watch_paths_.end()) return;
+        dir = it->second;
+
+        if (mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+            /* The directory itself is gone: drop its watch and every entry under it */
+            watched_dirs_.erase(dir);
+            watch_paths_.erase(it);
+            epoch_.fetch_add(1, std::memory_order_acq_rel);
+            std::string prefix = dir == "/" ? dir : dir + "/";
+            for (auto entry = entries_.begin(); entry != entries_.end();) {
+                auto next = std::next(entry);
+                if (entry->first.compare(0, prefix.size(), prefix) == 0) {
+                    erase_locked(entry);
+                }
+                entry = next;
+            }
+            return;
+        }
+    }
+    if (name.empty()) return;
+
+    std::string path = dir == "/" ? dir : dir + "/";
+    path.append(name);
+    invalidate(path);
+    for (std::string_view suffix : VARIANT_SUFFIXES) {
+        if (path.size() > suffix.size() &&
+            path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            invalidate(path.substr(0, path.size() - suffix.size()));
+        }
+    }
+}
+
+} /* namespace Gecko */
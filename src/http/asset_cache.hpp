@@ -0,0 +1,110 @@
+#ifndef ASSET_CACHE_HPP
+#define ASSET_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Gecko {
+
+/* One file held in memory, with every encoded variant that exists for it */
+struct CachedAsset {
+    struct Variant {
+        std::string encoding;                        /* Empty for identity */
+        std::string etag;
+        std::shared_ptr<const std::string> body;
+        std::shared_ptr<const std::string> headers;  /* Pre-serialized, Content-Type line first */
+    };
+
+    std::string content_type;
+    time_t last_modified = 0;
+    std::vector<Variant> variants;  /* Identity first */
+
+    size_t bytes() const;
+};
+
+/*
+ * Hot static assets keyed by filesystem path, bounded by a byte budget with
+ * CLOCK (second-chance) eviction: a hit only sets the entry's referenced
+ * bit under a shared lock, so concurrent hits never serialize; the sweep
+ * that skips referenced entries runs on insert, under the exclusive lock.
+ * Directories of cached files are watched with inotify and any
+ * change to a file (or to one of its .gz/.br/.zst siblings) drops its entry,
+ * so a hit never touches the filesystem.
+ *
+ * Loaders snapshot epoch() before reading a file and pass it to insert(),
+ * which refuses the entry if an invalidation raced with the read.
+ */
+class AssetCache {
+public:
+    explicit AssetCache(size_t byte_budget);
+    ~AssetCache();
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    /* False when inotify is unavailable; nothing is cached then */
+    bool enabled() const { return inotify_fd_ >= 0; }
+
+    std::shared_ptr<const CachedAsset> find(const std::string& path);
+
+    uint64_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+    /* Watch the directory holding path; call before reading the file */
+    bool watch(const std::string& path);
+    bool insert(const std::string& path, std::shared_ptr<const CachedAsset> asset, uint64_t epoch);
+    void invalidate(const std::string& path);
+    void clear();
+
+    size_t byte_budget() const { return byte_budget_; }
+    size_t size_bytes() const;
+    size_t entry_count() const;
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        Slot(std::shared_ptr<const CachedAsset> asset, std::list<std::string>::iterator ring, size_t bytes)
+            : asset(std::move(asset)), ring(ring), bytes(bytes) {}
+
+        std::shared_ptr<const CachedAsset> asset;
+        std::list<std::string>::iterator ring;
+        size_t bytes;
+        mutable std::atomic<bool> referenced{false};  /* Set by hits, cleared as the hand passes */
+    };
+
+    void watch_loop();
+    void handle_event(int wd, uint32_t mask, std::string_view name);
+    void erase_locked(std::unordered_map<std::string, Slot>::iterator it);
+    void evict_one_locked();
+
+    size_t byte_budget_;
+    int inotify_fd_ = -1;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Slot> entries_;
+    std::list<std::string> ring_;             /* Clock order; new entries go just behind the hand */
+    std::list<std::string>::iterator hand_;   /* Next eviction candidate; ring_.end() when empty */
+    size_t bytes_ = 0;
+    std::unordered_map<std::string, int> watched_dirs_;
+    std::unordered_map<int, std::string> watch_paths_;
+
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<bool> running_{true};
+    std::thread watcher_;
+};
+
+} /* namespace Gecko */
+
+#endif /* ASSET_CACHE_HPP */
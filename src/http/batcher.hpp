@@ -0,0 +1,309 @@
+#ifndef BATCHER_HPP
+#define BATCHER_HPP
+
+#include "context.hpp"
+#include "thread_pool.hpp"
+#include "timer_service.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Gecko {
+
+struct BatchOptions {
+    size_t max_keys = 64;                       /* Flush once this many distinct keys wait */
+    std::chrono::microseconds max_delay{1000};  /* Flush this long after the batch's first key at the latest */
+};
+
+/*
+ * Coalesces single-key lookups from concurrent requests into one call to a
+ * batched backend. Keys wait in an open batch until it holds max_keys
+ * distinct keys or max_delay has passed since its first key (TimerService),
+ * then the loader runs once for the whole batch and every waiter is called
+ * back with its own value. Duplicate keys in a batch are loaded once.
+ *
+ * The loader runs on pool when given, else on the pool of the worker that
+ * opened the batch, else on a one-thread executor the Batcher keeps for
+ * itself; never on the TimerService thread or the caller of load(). It
+ * returns one value per key, in order; if it throws or returns the wrong
+ * count, every waiter of the batch gets the error, as they do when the
+ * batch's pool is already stopping.
+ *
+ *   Batcher<int, User> users(loadUsers);
+ *   app.GET("/users/:id", [&](Context& ctx) {
+ *       users.load(std::stoi(ctx.param("id")), ctx.defer(),
+ *                  [](Context& ctx, const User& user) { ctx.json(user.toJson()); });
+ *   });
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class Batcher {
+public:
+    using Loader = std::function<std::vector<Value>(const std::vector<Key>&)>;
+
+    struct Result {
+        std::optional<Value> value;
+        std::exception_ptr error;  /* Set when the batch failed */
+        bool ok() const { return value.has_value(); }
+    };
+    using Callback = std::function<void(Result)>;
+    using Respond = std::function<void(Context&, const Value&)>;
+
+    explicit Batcher(Loader loader, BatchOptions options = BatchOptions(), ThreadPool* pool = nullptr)
+        : state_(std::make_shared<State>(std::move(loader), options, pool)) {
+        if (!state_->loader) {
+            throw std::invalid_argument("Batcher needs a loader");
+        }
+        if (state_->options.max_keys == 0) {
+            state_->options.max_keys = 1;
+        }
+        if (!pool) {
+            executor_ = std::make_unique<ThreadPool>(1);
+            state_->fallback = executor_.get();
+        }
+    }
+
+    /*
+     * Waiters of the open batch are still served; in-flight batches keep the
+     * shared state alive. The executor drains before it goes, and closing
+     * under the lock keeps a firing timer from posting to it afterwards.
+     */
+    ~Batcher() {
+        std::optional<Batch> failed;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->closed = true;
+            if (!state_->open.keys.empty()) {
+                failed = postLocked(state_, take(*state_));
+            }
+        }
+        if (failed) {
+            fail(std::move(*failed));
+        }
+        executor_.reset();
+    }
+
+    Batcher(const Batcher&) = delete;
+    Batcher& operator=(const Batcher&) = delete;
+
+    /* done runs on the thread that ran the loader */
+    void load(Key key, Callback done) {
+        std::optional<Batch> failed;
+        bool opened = false;
+        std::uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            Batch& batch = state_->open;
+            if (batch.keys.empty()) {
+                batch.pool = state_->pool ? state_->pool : ThreadPool::current();
+                if (!batch.pool) {
+                    batch.pool = state_->fallback;
+                }
+                opened = true;
+                generation = state_->generation;
+            }
+            auto found = batch.index.find(key);
+            if (found == batch.index.end()) {
+                batch.index.emplace(key, batch.keys.size());
+                batch.keys.push_back(std::move(key));
+                batch.waiters.emplace_back();
+                batch.waiters.back().push_back(std::move(done));
+            } else {
+                batch.waiters[found->second].push_back(std::move(done));
+            }
+            state_->requests++;
+            if (batch.keys.size() >= state_->options.max_keys) {
+                failed = postLocked(state_, take(*state_));
+                opened = false;
+            }
+        }
+        if (opened) {
+            std::weak_ptr<State> weak = state_;
+            TimerService::TimerId timer = TimerService::instance().scheduleAfter(
+                state_->options.max_delay, [weak, generation]() {
+                    if (auto state = weak.lock()) {
+                        flushGeneration(state, generation);
+                    }
+                });
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->generation == generation) {
+                state_->timer = timer;
+            }
+        }
+        if (failed) {
+            fail(std::move(*failed));
+        }
+    }
+
+    /*
+     * Finish a deferred request with the key's value: respond fills the
+     * response, then it is sent. A failed batch or a throwing respond
+     * answers 500.
+     */
+    void load(Key key, Responder responder, Respond respond) {
+        auto held = std::make_shared<Responder>(std::move(responder));
+        load(std::move(key), [held, respond = std::move(respond)](Result result) {
+            try {
+                if (result.error) {
+                    std::rethrow_exception(result.error);
+                }
+                respond(held->context(), *result.value);
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Batched lookup failed: " << e.what() << std::endl;
+                held->response().reset();
+                held->context().status(500).string("Internal Server Error");
+            }
+            held->send();
+        });
+    }
+
+    /* Dispatch the open batch now; it still runs on its pool */
+    void flush() {
+        std::optional<Batch> failed;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->open.keys.empty()) {
+                failed = postLocked(state_, take(*state_));
+            }
+        }
+        if (failed) {
+            fail(std::move(*failed));
+        }
+    }
+
+    /* Loader calls so far */
+    std::uint64_t batches() const { return state_->batches.load(std::memory_order_relaxed); }
+    /* Keys passed to the loader so far; fewer than requests() when keys repeat */
+    std::uint64_t loadedKeys() const { return state_->loaded_keys.load(std::memory_order_relaxed); }
+    std::uint64_t requests() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->requests;
+    }
+
+private:
+    struct Batch {
+        std::vector<Key> keys;
+        std::vector<std::vector<Callback>> waiters;  /* Parallel to keys */
+        std::unordered_map<Key, size_t, Hash> index;
+        ThreadPool* pool = nullptr;
+    };
+
+    struct State {
+        State(Loader loader, BatchOptions options, ThreadPool* pool)
+            : loader(std::move(loader)), options(options), pool(pool) {}
+
+        Loader loader;
+        BatchOptions options;
+        ThreadPool* pool;
+        ThreadPool* fallback = nullptr;  /* The Batcher's own executor when no pool was given */
+
+        mutable std::mutex mutex;
+        bool closed = false;  /* The Batcher is gone: timers no longer flush */
+        Batch open;
+        std::uint64_t generation = 0;  /* Bumped on every flush; stale timers see a different value */
+        TimerService::TimerId timer = 0;
+        std::uint64_t requests = 0;
+
+        std::atomic<std::uint64_t> batches{0};
+        std::atomic<std::uint64_t> loaded_keys{0};
+    };
+
+    /* Caller holds state.mutex */
+    static Batch take(State& state) {
+        Batch batch = std::move(state.open);
+        state.open = Batch();
+        state.generation++;
+        if (state.timer != 0) {
+            TimerService::instance().cancel(state.timer);
+            state.timer = 0;
+        }
+        return batch;
+    }
+
+    /* Runs on the timer thread: only hands the batch to its pool */
+    static void flushGeneration(const std::shared_ptr<State>& state, std::uint64_t generation) {
+        std::optional<Batch> failed;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->closed || state->generation != generation || state->open.keys.empty()) {
+                return;
+            }
+            state->timer = 0;  /* Firing now; nothing to cancel */
+            failed = postLocked(state, take(*state));
+        }
+        if (failed) {
+            fail(std::move(*failed));
+        }
+    }
+
+    /* Caller holds state->mutex, so the pool cannot be torn down mid-post. Returns the batch if it was refused */
+    static std::optional<Batch> postLocked(const std::shared_ptr<State>& state, Batch batch) {
+        auto shared = std::make_shared<Batch>(std::move(batch));
+        try {
+            shared->pool->post([state, shared]() { run(*state, *shared); });
+            return std::nullopt;
+        } catch (const std::runtime_error&) {
+            /* Pool is stopping: the waiters get an error rather than a loader call on this thread */
+            return std::move(*shared);
+        }
+    }
+
+    static void fail(Batch batch) {
+        answer(batch, {}, std::make_exception_ptr(std::runtime_error("Batch pool is stopping")));
+    }
+
+    static void run(State& state, Batch& batch) {
+        std::vector<Value> values;
+        std::exception_ptr error;
+        try {
+            values = state.loader(batch.keys);
+            if (values.size() != batch.keys.size()) {
+                throw std::runtime_error("Batch loader returned " + std::to_string(values.size()) +
+                                         " values for " + std::to_string(batch.keys.size()) + " keys");
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        state.batches.fetch_add(1, std::memory_order_relaxed);
+        state.loaded_keys.fetch_add(batch.keys.size(), std::memory_order_relaxed);
+        answer(batch, std::move(values), error);
+    }
+
+    static void answer(Batch& batch, std::vector<Value> values, std::exception_ptr error) {
+        for (size_t i = 0; i < batch.waiters.size(); ++i) {
+            auto& waiters = batch.waiters[i];
+            for (size_t w = 0; w < waiters.size(); ++w) {
+                Result result;
+                if (error) {
+                    result.error = error;
+                } else if (w + 1 == waiters.size()) {
+                    result.value = std::move(values[i]);
+                } else {
+                    result.value = values[i];
+                }
+                try {
+                    waiters[w](std::move(result));
+                } catch (const std::exception& e) {
+                    std::cerr << "[ERROR] Batch callback threw: " << e.what() << std::endl;
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<State> state_;
+    std::unique_ptr<ThreadPool> executor_;  /* Only without a pool */
+};
+
+} /* namespace Gecko */
+
+#endif /* BATCHER_HPP */
@@ -0,0 +1,73 @@
+#include "body_segment.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Gecko {
+
+std::shared_ptr<const FileHandle> FileHandle::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved_errno = errno;
+        ::close(fd);
+        throw std::runtime_error("Failed to stat " + path + ": " + strerror(saved_errno));
+    }
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw std::runtime_error("Not a regular file: " + path);
+    }
+    return std::make_shared<const FileHandle>(fd, static_cast<size_t>(st.st_size), st.st_mtime);
+}
+
+FileHandle::~FileHandle() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+size_t segmentLength(const BodySegment& segment) {
+    if (const auto* file = std::get_if<FileSegment>(&segment)) {
+        return file->length;
+    }
+    return segmentView(segment).size();
+}
+
+std::string_view segmentView(const BodySegment& segment) {
+    if (const auto* owned = std::get_if<std::string>(&segment)) {
+        return *owned;
+    }
+    if (const auto* shared = std::get_if<std::shared_ptr<const std::string>>(&segment)) {
+        return *shared ? std::string_view(**shared) : std::string_view();
+    }
+    return {};
+}
+
+char* copySegment(const BodySegment& segment, char* out) {
+    const auto* file = std::get_if<FileSegment>(&segment);
+    if (!file) {
+        std::string_view view = segmentView(segment);
+        std::memcpy(out, view.data(), view.size());
+        return out + view.size();
+    }
+
+    size_t copied = 0;
+    while (copied < file->length) {
+        ssize_t n = pread(file->file->fd(), out + copied, file->length - copied,
+                          file->offset + static_cast<off_t>(copied));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            throw std::runtime_error("Failed to read file segment");
+        }
+        copied += static_cast<size_t>(n);
+    }
+    return out + copied;
+}
+
+} /* namespace Gecko */
@@ -0,0 +1,63 @@
+#ifndef BODY_SEGMENT_HPP
+#define BODY_SEGMENT_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <ctime>
+#include <sys/types.h>
+#include <variant>
+
+namespace Gecko {
+
+/* Read-only file descriptor shared by every response that sends from it */
+class FileHandle {
+public:
+    /* Throws std::runtime_error if path cannot be opened or is not a regular file */
+    static std::shared_ptr<const FileHandle> open(const std::string& path);
+
+    explicit FileHandle(int fd, size_t size, time_t mtime = 0) : fd_(fd), size_(size), mtime_(mtime) {}
+    ~FileHandle();
+
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+
+    int fd() const { return fd_; }
+    size_t size() const { return size_; }
+    time_t mtime() const { return mtime_; }
+
+private:
+    int fd_;
+    size_t size_;
+    time_t mtime_;
+};
+
+/* Byte range of a file, sent with sendfile */
+struct FileSegment {
+    std::shared_ptr<const FileHandle> file;
+    off_t offset = 0;
+    size_t length = 0;
+};
+
+/*
+ * One piece of a response body: an owned string, an immutable buffer shared
+ * across responses (e.g. a cached document), or a file range.
+ */
+using BodySegment = std::variant<std::string, std::shared_ptr<const std::string>, FileSegment>;
+
+size_t segmentLength(const BodySegment& segment);
+
+/* Bytes of an in-memory segment; empty for file segments */
+std::string_view segmentView(const BodySegment& segment);
+
+inline bool isFileSegment(const BodySegment& segment) {
+    return std::holds_alternative<FileSegment>(segment);
+}
+
+/* Copy segment bytes to out (pread for files); returns the end */
+char* copySegment(const BodySegment& segment, char* out);
+
+} /* namespace Gecko */
+
+#endif /* BODY_SEGMENT_HPP */
@@ -0,0 +1,115 @@
+#include "buffer_pool.hpp"
+
+namespace Gecko {
+
+namespace {
+thread_local BufferPool* t_current_pool = nullptr;
+}
+
+/* PooledBuffer implementation */
+PooledBuffer::~PooledBuffer() {
+    give_back();
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept {
+    if (this != &other) {
+        give_back();
+        data_ = std::move(other.data_);
+        origin_ = std::move(other.origin_);
+    }
+    return *this;
+}
+
+void PooledBuffer::give_back() {
+    if (origin_) {
+        origin_->release(std::move(data_));
+        origin_.reset();
+    }
+}
+
+/* BufferPool implementation */
+BufferPool& BufferPool::local() {
+    /* Held by shared_ptr so buffers still in flight keep it alive after thread exit */
+    thread_local std::shared_ptr<BufferPool> pool = [] {
+        auto created = std::make_shared<BufferPool>();
+        t_current_pool = created.get();
+        return created;
+    }();
+    return *pool;
+}
+
+int BufferPool::class_for_request(size_t size) {
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        if (size <= CLASS_SIZES[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int BufferPool::class_for_capacity(size_t capacity) {
+    for (size_t i = CLASS_COUNT; i-- > 0;) {
+        if (capacity >= CLASS_SIZES[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+PooledBuffer BufferPool::acquire(size_t size) {
+    int cls = class_for_request(size);
+    if (cls < 0) {
+        pool_misses_++;
+        return PooledBuffer(std::string(size, '\0'));  /* Oversized: not pooled */
+    }
+
+    auto& free_list = free_[cls];
+    if (free_list.empty()) {
+        std::lock_guard<std::mutex> lock(returned_mutex_);
+        for (size_t i = 0; i < CLASS_COUNT; ++i) {
+            for (auto& data : returned_[i]) {
+                free_[i].push_back(std::move(data));
+            }
+            returned_[i].clear();
+        }
+    }
+
+    std::string data;
+    if (free_list.empty()) {
+        pool_misses_++;
+        data.reserve(CLASS_SIZES[cls]);
+    } else {
+        data = std::move(free_list.back());
+        free_list.pop_back();
+    }
+    data.resize(size);  /* Within capacity: no reallocation */
+    return PooledBuffer(std::move(data), shared_from_this());
+}
+
+void BufferPool::release(std::string&& data) {
+    int cls = class_for_capacity(data.capacity());
+    if (cls < 0) return;  /* Too small to be worth keeping */
+    data.clear();
+
+    if (t_current_pool == this) {
+        if (free_[cls].size() < MAX_CACHED[cls]) {
+            free_[cls].push_back(std::move(data));
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(returned_mutex_);
+    if (returned_[cls].size() < MAX_CACHED[cls]) {
+        returned_[cls].push_back(std::move(data));
+    }
+}
+
+size_t BufferPool::available_count() const {
+    size_t count = 0;
+    for (const auto& free_list : free_) {
+        count += free_list.size();
+    }
+    std::lock_guard<std::mutex> lock(returned_mutex_);
+    for (const auto& returned : returned_) {
+        count += returned.size();
+    }
+    return count;
+}
+
+} /* namespace Gecko */
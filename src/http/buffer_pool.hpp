@@ -0,0 +1,94 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gecko {
+
+class BufferPool;
+
+/*
+ * Move-only output buffer. Moving it hands the bytes to another thread
+ * without a copy; destroying it returns the storage to the freelist of the
+ * thread that acquired it, whichever thread the destructor runs on.
+ */
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    /* Adopt an existing string; it is freed normally instead of pooled */
+    explicit PooledBuffer(std::string data) : data_(std::move(data)) {}
+    ~PooledBuffer();
+
+    PooledBuffer(PooledBuffer&& other) noexcept = default;
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    char* data() { return data_.data(); }
+    const char* data() const { return data_.data(); }
+    size_t size() const { return data_.size(); }
+    bool empty() const { return data_.empty(); }
+    std::string_view view() const { return data_; }
+    std::string& str() { return data_; }
+    const std::string& str() const { return data_; }
+
+private:
+    friend class BufferPool;
+    PooledBuffer(std::string data, std::shared_ptr<BufferPool> origin)
+        : data_(std::move(data)), origin_(std::move(origin)) {}
+    void give_back();
+
+    std::string data_;
+    std::shared_ptr<BufferPool> origin_;
+};
+
+/*
+ * Size-classed freelists of response buffers, one pool per thread.
+ *
+ * The owning thread acquires without locking. Buffers released on other
+ * threads (typically the IO thread after a write completes) go to a
+ * mutex-guarded return list that the owner drains when a class runs dry.
+ * Requests larger than the biggest class get a plain, unpooled string.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+public:
+    static constexpr size_t CLASS_COUNT = 5;
+    static constexpr std::array<size_t, CLASS_COUNT> CLASS_SIZES = {
+        1024, 4096, 16384, 65536, 262144
+    };
+    static constexpr std::array<size_t, CLASS_COUNT> MAX_CACHED = {
+        256, 128, 64, 16, 4
+    };
+
+    /* Pool bound to the calling thread */
+    static BufferPool& local();
+
+    /* Buffer with size() == size; capacity rounded up to its size class */
+    PooledBuffer acquire(size_t size);
+
+    /* Statistics */
+    size_t available_count() const;
+    size_t pool_misses() const { return pool_misses_; }
+
+private:
+    friend class PooledBuffer;
+    static int class_for_request(size_t size);
+    static int class_for_capacity(size_t capacity);
+    void release(std::string&& data);
+
+    std::array<std::vector<std::string>, CLASS_COUNT> free_;  /* Owner thread only */
+    size_t pool_misses_ = 0;
+
+    mutable std::mutex returned_mutex_;
+    std::array<std::vector<std::string>, CLASS_COUNT> returned_;
+};
+
+} /* namespace Gecko */
+
+#endif /* BUFFER_POOL_HPP */
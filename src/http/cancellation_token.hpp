@@ -0,0 +1,41 @@
+#ifndef CANCELLATION_TOKEN_HPP
+#define CANCELLATION_TOKEN_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+namespace Gecko {
+
+/*
+ * Tells a request's worker that nobody is waiting for the answer any more:
+ * the client hung up (the owning reactor saw EPOLLRDHUP, HUP or EOF and
+ * cleared the connection's flag) or the request's deadline passed. Cheap to
+ * copy and safe to poll from any thread, so handlers can hand it to
+ * long-running or asynchronous work. A default token is never cancelled.
+ */
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CancellationToken() = default;
+    /* connected stays true while the peer is there; its owner is kept alive */
+    CancellationToken(std::shared_ptr<const std::atomic<bool>> connected, Clock::time_point deadline)
+        : connected_(std::move(connected)), deadline_(deadline) {}
+
+    bool disconnected() const { return connected_ && !connected_->load(std::memory_order_relaxed); }
+    bool expired(Clock::time_point now = Clock::now()) const { return now >= deadline_; }
+    bool cancelled() const { return disconnected() || expired(); }
+
+    /* time_point::max() when the request has no deadline */
+    Clock::time_point deadline() const { return deadline_; }
+
+private:
+    std::shared_ptr<const std::atomic<bool>> connected_;
+    Clock::time_point deadline_ = Clock::time_point::max();
+};
+
+} /* namespace Gecko */
+
+#endif /* CANCELLATION_TOKEN_HPP */
@@ -0,0 +1,196 @@
+#include "compression.hpp"
+#include "header_text.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+
+#ifdef GECKO_ENABLE_COMPRESSION
+#include <zlib.h>
+#endif
+
+namespace Gecko {
+
+namespace {
+
+using detail::equalsIgnoreCase;
+using detail::trim;
+
+constexpr int MIN_ZLIB_LEVEL = 1;
+constexpr int MAX_ZLIB_LEVEL = 9;
+
+/* q-value of one Accept-Encoding element ("gzip;q=0.5"); 1 when absent */
+double qualityOf(std::string_view params) {
+    size_t q = params.find("q=");
+    if (q == std::string_view::npos) return 1.0;
+    std::string value(trim(params.substr(q + 2)));
+    return std::strtod(value.c_str(), nullptr);
+}
+
+#ifdef GECKO_ENABLE_COMPRESSION
+/* One deflate stream per encoding and level, kept for the thread's lifetime */
+class DeflateStreams {
+public:
+    ~DeflateStreams() {
+        for (auto& per_encoding : streams_) {
+            for (auto& stream : per_encoding) {
+                if (stream) deflateEnd(stream.get());
+            }
+        }
+    }
+
+    z_stream* get(ContentEncoding encoding, int level) {
+        size_t index = encoding == ContentEncoding::GZIP ? 0 : 1;
+        auto& slot = streams_[index][level];
+        if (slot) {
+            deflateReset(slot.get());
+            return slot.get();
+        }
+        auto stream = std::make_unique<z_stream>();
+        int window_bits = encoding == ContentEncoding::GZIP ? 15 + 16 : 15;
+        if (deflateInit2(stream.get(), level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return nullptr;
+        }
+        slot = std::move(stream);
+        return slot.get();
+    }
+
+private:
+    std::array<std::array<std::unique_ptr<z_stream>, MAX_ZLIB_LEVEL + 1>, 2> streams_;
+};
+#endif
+
+} // namespace
+
+bool compressionAvailable() {
+#ifdef GECKO_ENABLE_COMPRESSION
+    return true;
+#else
+    return false;
+#endif
+}
+
+double encodingQuality(std::string_view accept_encoding, std::string_view coding) {
+    double wildcard_q = 0.0;
+    while (!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view element = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view() : accept_encoding.substr(comma + 1);
+
+        size_t semicolon = element.find(';');
+        std::string_view name = trim(element.substr(0, semicolon));
+        double q = semicolon == std::string_view::npos ? 1.0 : qualityOf(element.substr(semicolon + 1));
+        if (equalsIgnoreCase(name, coding) || (coding == "gzip" && equalsIgnoreCase(name, "x-gzip"))) {
+            return q;
+        }
+        if (name == "*") wildcard_q = q;
+    }
+    return wildcard_q;
+}
+
+ContentEncoding negotiateEncoding(std::string_view accept_encoding) {
+    double gzip_q = encodingQuality(accept_encoding, "gzip");
+    double deflate_q = encodingQuality(accept_encoding, "deflate");
+    if (gzip_q <= 0.0 && deflate_q <= 0.0) return ContentEncoding::IDENTITY;
+    return gzip_q >= deflate_q ? ContentEncoding::GZIP : ContentEncoding::DEFLATE;
+}
+
+/* Worth compressing: text formats, not images or archives */
+bool isCompressibleType(std::string_view content_type) {
+    if (content_type.empty()) return false;
+    std::string type(content_type);
+    std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) { return std::tolower(c); });
+    return type.rfind("text/", 0) == 0 || type.find("json") != std::string::npos ||
+        type.find("javascript") != std::string::npos || type.find("xml") != std::string::npos ||
+        type.find("svg") != std::string::npos;
+}
+
+std::string_view contentEncodingName(ContentEncoding encoding) {
+    switch (encoding) {
+        case ContentEncoding::GZIP: return "gzip";
+        case ContentEncoding::DEFLATE: return "deflate";
+        default: return "identity";
+    }
+}
+
+int adaptiveLevel(const CompressionOptions& options, size_t queue_depth) {
+    int floor = std::clamp(options.min_level, MIN_ZLIB_LEVEL, MAX_ZLIB_LEVEL);
+    int level = std::clamp(options.level, floor, MAX_ZLIB_LEVEL);
+    size_t step = std::max<size_t>(options.backlog_per_level, 1);
+    size_t drop = std::min<size_t>(queue_depth / step, static_cast<size_t>(level - floor));
+    return level - static_cast<int>(drop);
+}
+
+bool compressBody(ContentEncoding encoding, int level, std::string_view input, std::string& output) {
+#ifdef GECKO_ENABLE_COMPRESSION
+    if (encoding == ContentEncoding::IDENTITY) return false;
+    thread_local DeflateStreams streams;
+    z_stream* stream = streams.get(encoding, std::clamp(level, MIN_ZLIB_LEVEL, MAX_ZLIB_LEVEL));
+    if (!stream) return false;
+
+    /* deflateBound makes a single Z_FINISH call sufficient */
+    output.resize(deflateBound(stream, static_cast<uLong>(input.size())));
+    stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream->avail_in = static_cast<uInt>(input.size());
+    stream->next_out = reinterpret_cast<Bytef*>(output.data());
+    stream->avail_out = static_cast<uInt>(output.size());
+    if (deflate(stream, Z_FINISH) != Z_STREAM_END) {
+        return false;
+    }
+    output.resize(stream->total_out);
+    return true;
+#else
+    (void)encoding;
+    (void)level;
+    (void)input;
+    (void)output;
+    return false;
+#endif
+}
+
+bool compressResponse(const HttpRequest& request, HttpResponse& response,
+                      const CompressionOptions& options, int level) {
+    if (!compressionAvailable()) return false;
+
+    int status = response.getStatusCode();
+    if (status < 200 || status == 204 || status == 304) return false;
+    if (response.getBodyLength() < options.min_size) return false;
+    for (const auto& segment : response.getBodySegments()) {
+        if (isFileSegment(segment)) return false;
+    }
+
+    const auto& headers = response.getHeaders();
+    if (headers.count("Content-Encoding") || headers.count("Transfer-Encoding")) return false;
+    auto type_it = headers.find("Content-Type");
+    if (type_it == headers.end() || !isCompressibleType(type_it->second)) return false;
+
+    auto accept_it = request.getHeaders().find("Accept-Encoding");
+    if (accept_it == request.getHeaders().end()) return false;
+    ContentEncoding encoding = negotiateEncoding(accept_it->second);
+    if (encoding == ContentEncoding::IDENTITY) return false;
+
+    /* In-memory segments are joined for the encoder; file segments were refused above */
+    std::string compressed;
+    if (!compressBody(encoding, level, response.flattenBody(), compressed) ||
+        compressed.size() >= response.getBodyLength()) {
+        return false;
+    }
+
+    response.setBody(std::move(compressed));
+    response.addHeader("Content-Encoding", std::string(contentEncodingName(encoding)));
+    auto vary_it = headers.find("Vary");
+    if (vary_it == headers.end()) {
+        response.addHeader("Vary", "Accept-Encoding");
+    } else if (vary_it->second.find("Accept-Encoding") == std::string::npos) {
+        response.addHeader("Vary", std::string(vary_it->second) + ", Accept-Encoding");
+    }
+    /* Different bytes than the identity representation: a strong validator no longer holds */
+    auto etag_it = headers.find("ETag");
+    if (etag_it != headers.end() && etag_it->second.rfind("W/", 0) != 0) {
+        response.addHeader("ETag", "W/" + std::string(etag_it->second));
+    }
+    return true;
+}
+
+} /* namespace Gecko */
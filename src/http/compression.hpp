@@ -0,0 +1,55 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Gecko {
+
+enum class ContentEncoding { IDENTITY, GZIP, DEFLATE };
+
+struct CompressionOptions {
+    int level = 6;                  /* zlib level while workers keep up */
+    int min_level = 1;              /* Floor under load */
+    size_t min_size = 1024;         /* Smaller bodies are sent as is */
+    size_t backlog_per_level = 16;  /* Queued worker tasks that cost one level */
+};
+
+/* False when built without zlib; compression is then a no-op */
+bool compressionAvailable();
+
+/* q-value an Accept-Encoding value gives coding (wildcard included); 0 when refused */
+double encodingQuality(std::string_view accept_encoding, std::string_view coding);
+
+/* Preferred encoding allowed by an Accept-Encoding value (q-values honoured) */
+ContentEncoding negotiateEncoding(std::string_view accept_encoding);
+std::string_view contentEncodingName(ContentEncoding encoding);
+
+/* Text-like media types that are worth compressing */
+bool isCompressibleType(std::string_view content_type);
+
+/* Level for the current worker backlog, stepping down towards min_level */
+int adaptiveLevel(const CompressionOptions& options, size_t queue_depth);
+
+/*
+ * Compress input with a thread-local zlib stream for (encoding, level),
+ * reset rather than rebuilt between calls. Returns false if the encoding
+ * is unavailable or fails.
+ */
+bool compressBody(ContentEncoding encoding, int level, std::string_view input, std::string& output);
+
+/*
+ * Compress response in place when the request allows it and it is worth it.
+ * A strong ETag is weakened (W/) since the encoded bytes differ. Bodies with
+ * file segments are left for sendfile; serve precompressed variants for
+ * those instead.
+ */
+bool compressResponse(const HttpRequest& request, HttpResponse& response,
+                      const CompressionOptions& options, int level);
+
+} /* namespace Gecko */
+
+#endif /* COMPRESSION_HPP */
@@ -1,8 +1,171 @@
 #include "context.hpp"
-#include "shared_mutex"
+#include "file_response.hpp"
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
 
 namespace Gecko {
 
+namespace {
+
+/*
+ * Append-only: a row is fully written before count publishes it and is
+ * never modified afterwards, so readers scan the published prefix without
+ * a lock. Only registration serializes on the mutex.
+ */
+struct KeyTable {
+    struct Row {
+        std::string name;
+        ContextKeyRegistry::Entry entry{0, std::type_index(typeid(void)), nullptr};
+    };
+    std::mutex mutex;
+    std::array<Row, ContextKeyRegistry::MAX_SLOTS> rows;
+    std::atomic<size_t> count{0};
+};
+
+KeyTable &keyTable() {
+    static KeyTable table;
+    return table;
+}
+
+} // namespace
+
+size_t ContextKeyRegistry::add(const std::string &name, std::type_index type, AnyAssigner assign_from_any) {
+    auto &table = keyTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    size_t count = table.count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        if (table.rows[i].name == name) {
+            if (table.rows[i].entry.type != type) {
+                throw std::logic_error("Context key registered twice with different types: " + name);
+            }
+            return i;
+        }
+    }
+    if (count >= MAX_SLOTS) {
+        throw std::length_error("Too many context keys registered (max " + std::to_string(MAX_SLOTS) + ")");
+    }
+    table.rows[count].name = name;
+    table.rows[count].entry = Entry{count, type, assign_from_any};
+    table.count.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+auto ContextKeyRegistry::find(std::string_view name) -> const Entry * {
+    auto &table = keyTable();
+    size_t count = table.count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        if (table.rows[i].name == name) {
+            return &table.rows[i].entry;
+        }
+    }
+    return nullptr;
+}
+
+void Context::clearSlots() {
+    while (used_slots_ != 0) {
+        size_t index = static_cast<size_t>(__builtin_ctz(used_slots_));
+        Slot &slot = slots_[index];
+        slot.destroy(slot.object);
+        slot.object = nullptr;
+        slot.destroy = nullptr;
+        used_slots_ &= used_slots_ - 1;
+    }
+}
+
+void Context::reset() {
+    request_ = nullptr;
+    request_storage_.reset();
+    response_.reset();
+    router_params_.clear();
+    context_data_.clear();
+    clearSlots();
+    stream_producer_ = nullptr;
+    before_send_.clear();
+    deferred_ = false;
+    lent_responder_ = nullptr;
+    completion_state_.store(0, std::memory_order_relaxed);
+    completion_.reset();
+    cancellation_ = CancellationToken();
+    /* Containers are empty, so the arena can be rewound in one step */
+    arena_.reset();
+}
+
+Responder &Responder::operator=(Responder &&other) noexcept {
+    if (this != &other) {
+        Responder abandoned(std::move(*this));
+        ctx_ = std::exchange(other.ctx_, nullptr);
+    }
+    return *this;
+}
+
+Responder::~Responder() {
+    if (ctx_) {
+        ctx_->response().reset();
+        ctx_->status(500).string("Internal Server Error");
+        send();
+    }
+}
+
+HttpResponse &Responder::response() {
+    return ctx_->response();
+}
+
+void Responder::send() {
+    /* The context may be recycled as soon as it completes */
+    Context *ctx = std::exchange(ctx_, nullptr);
+    if (ctx) {
+        ctx->finalizeResponse();
+        ctx->complete();
+    }
+}
+
+Responder Context::defer() {
+    if (lent_responder_) {
+        return std::move(*std::exchange(lent_responder_, nullptr));
+    }
+    if (deferred_) {
+        throw std::logic_error("Response already deferred");
+    }
+    deferred_ = true;
+    return Responder(*this);
+}
+
+void Context::finalizeResponse() {
+    /* Last registered first; a hook may register another, which then runs next */
+    while (!before_send_.empty()) {
+        TaskSlot hook = std::move(before_send_.back());
+        before_send_.pop_back();
+        try {
+            hook();
+        } catch (const std::exception &e) {
+            std::cerr << "[ERROR] Response hook failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+/* Whichever of complete() and onComplete() comes second runs the completion */
+void Context::complete() {
+    if (completion_state_.fetch_or(COMPLETION_DONE, std::memory_order_acq_rel) & COMPLETION_ARMED) {
+        runCompletion();
+    }
+}
+
+void Context::onComplete(TaskSlot finish) {
+    completion_ = std::move(finish);
+    if (completion_state_.fetch_or(COMPLETION_ARMED, std::memory_order_acq_rel) & COMPLETION_DONE) {
+        runCompletion();
+    }
+}
+
+void Context::runCompletion() {
+    /* The completion usually owns this context; nothing may touch it afterwards */
+    TaskSlot finish = std::move(completion_);
+    finish();
+}
+
 auto Context::param(const std::string &key) const -> const std::string & {
     static const std::string empty;
     auto it = router_params_.find(key);
@@ -10,27 +173,40 @@ auto Context::param(const std::string &key) const -> const std::string & {
 }
 
 void Context::setParams(const std::map<std::string, std::string> &params) {
-    router_params_ = params;
+    router_params_.clear();
+    router_params_.insert(params.begin(), params.end());
 }
 
 std::string Context::query(const std::string &key) const {
-    return request_.getQueryParam(key);
+    return request_->getQueryParam(key);
 }
 
 std::string Context::header(const std::string& key) const {
-    auto headers = request_.getHeaders();
+    const auto& headers = request_->getHeaders();
     auto it = headers.find(key);
-    return it != headers.end() ? it->second : "";
+    return it != headers.end() ? std::string(it->second) : std::string();
 }
 
 void Context::set(const std::string& key, const std::any& value) {
+    /* Names registered as typed keys land in their slot when the type matches; anything else stays string-keyed */
+    if (const auto* entry = ContextKeyRegistry::find(key)) {
+        if (std::type_index(value.type()) == entry->type) {
+            entry->assign_from_any(*this, entry->index, value);
+            return;
+        }
+    }
     std::lock_guard<std::shared_mutex> lock(context_data_mutex_);
-    context_data_[key] = value;
+    context_data_.insert_or_assign(decltype(context_data_)::key_type(key, context_data_.get_allocator()), value);
 }
 
 bool Context::has(const std::string& key) const {
+    if (const auto* entry = ContextKeyRegistry::find(key)) {
+        if (slots_[entry->index].object) {
+            return true;
+        }
+    }
     std::shared_lock<std::shared_mutex> lock(context_data_mutex_);
-    return context_data_.find(key) != context_data_.end();
+    return context_data_.find(std::string_view(key)) != context_data_.end();
 }
 
 HttpResponse& Context::response() {
@@ -57,6 +233,28 @@ void Context::html(const std::string& html) {
     response_.setBody(html);
 }
 
+void Context::data(const std::string& contentType, std::shared_ptr<const std::string> data) {
+    response_.addHeader("Content-Type", contentType);
+    response_.setBody(std::string());
+    response_.appendBody(std::move(data));
+}
+
+void Context::file(const std::string& path) {
+    std::shared_ptr<const FileHandle> handle;
+    try {
+        handle = FileHandle::open(path);
+    } catch (const std::exception&) {
+        status(404).string("404 Not Found");
+        return;
+    }
+    file(std::move(handle), std::string(mimeType(path)));
+}
+
+void Context::file(std::shared_ptr<const FileHandle> file, const std::string& contentType) {
+    response_.setBody(std::string());
+    sendFile(request(), response_, std::move(file), contentType);
+}
+
 Context& Context::header(const std::string& key, const std::string& value) {
     response_.addHeader(key, value);
     return *this;
@@ -1,23 +1,126 @@
 #ifndef CONTEXT_HPP
 #define CONTEXT_HPP
 
+#include "cancellation_token.hpp"
 #include "http_request.hpp"
 #include "http_response.hpp"
+#include "request_arena.hpp"
+#include "task_slot.hpp"
 #include <any>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <map>
+#include <memory_resource>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 namespace Gecko {
 
+class Context;
+class ResponseWriter;
+
+/*
+ * Detached response of a deferred request, from Context::defer(). Fill in
+ * the response, then send() from any thread; the server writes it on the
+ * connection's IO reactor. A responder dropped without send() answers 500
+ * so the connection never hangs.
+ */
+class Responder {
+public:
+    Responder() = default;
+    Responder(Responder &&other) noexcept : ctx_(std::exchange(other.ctx_, nullptr)) {}
+    Responder &operator=(Responder &&other) noexcept;
+    Responder(const Responder &) = delete;
+    Responder &operator=(const Responder &) = delete;
+    ~Responder();
+
+    explicit operator bool() const { return ctx_ != nullptr; }
+
+    /* Valid until send() */
+    Context &context() { return *ctx_; }
+    HttpResponse &response();
+
+    void send();
+
+private:
+    friend class Context;
+    explicit Responder(Context &ctx) : ctx_(&ctx) {}
+
+    Context *ctx_ = nullptr;
+};
+
+/* Produces a streamed response body through a ResponseWriter */
+using StreamProducer = std::function<void(ResponseWriter &)>;
+
+/*
+ * Process-wide table of typed context keys. Keys are registered once at
+ * startup and each one owns a fixed slot index in every Context; the
+ * string-keyed Context API consults this table so both views agree on
+ * values of the key's type. Lookups take no lock.
+ */
+class ContextKeyRegistry {
+public:
+    static constexpr size_t MAX_SLOTS = 16;
+
+    using AnyAssigner = void (*)(Context &, size_t, const std::any &);
+
+    struct Entry {
+        size_t index;
+        std::type_index type;
+        AnyAssigner assign_from_any;
+    };
+
+    /* Returns the slot for name; re-registering a name with the same type shares it */
+    static size_t add(const std::string &name, std::type_index type, AnyAssigner assign_from_any);
+
+    /* Used by the string-keyed API; nullptr when name is not a typed key */
+    static const Entry *find(std::string_view name);
+};
+
+/* Typed per-request key, e.g. `inline const ContextKey<std::string> UserId{"user_id"};` */
+template <typename T>
+class ContextKey {
+public:
+    explicit ContextKey(const std::string &name);
+
+    size_t index() const { return index_; }
+    const std::string &name() const { return name_; }
+
+private:
+    std::string name_;
+    size_t index_;
+};
+
 class Context {
 public:
-    Context(const HttpRequest &req)
-    : request_(req), response_(HttpResponse::stockResponse(200)) {}
-    const HttpRequest &request() const { return request_; }
+    Context()
+    : request_(nullptr), request_storage_(arena_.resource()), response_(arena_.resource()),
+      router_params_(arena_.resource()), context_data_(arena_.resource()) {}
+    Context(const HttpRequest &req) : Context() { request_ = &req; }
+    ~Context() { clearSlots(); }
+    const HttpRequest &request() const { return *request_; }
+
+    /* Bind a (pooled) context to the request it serves */
+    void setRequest(const HttpRequest &req) { request_ = &req; }
+
+    /* Arena-backed request owned by this context, filled by the server */
+    HttpRequest &requestStorage() { return request_storage_; }
+
+    /* Request-scoped memory; released in bulk when the context is reset */
+    std::pmr::memory_resource *arena() { return arena_.resource(); }
+
+    /* Clear per-request state and release the arena for reuse by ObjectPool */
+    void reset();
 
     /* Get router params */
     const std::string &param(const std::string &key) const;
@@ -30,8 +133,14 @@ public:
     void set(const std::string &key, const std::any &value);
 
     template <typename T> T get(const std::string &key) const {
+        if (const auto *entry = ContextKeyRegistry::find(key)) {
+            const Slot &slot = slots_[entry->index];
+            if (slot.object && entry->type == std::type_index(typeid(T))) {
+                return *static_cast<const T *>(slot.object);
+            }
+        }
         std::shared_lock<std::shared_mutex> lock(context_data_mutex_);
-        auto it = context_data_.find(key);
+        auto it = context_data_.find(std::string_view(key));
         if (it != context_data_.end()) {
             try {
                 return std::any_cast<T>(it->second);
@@ -44,6 +153,36 @@ public:
 
     bool has(const std::string &key) const;
 
+    /* Typed slot access: no lock, no hashing, values stored inline when small */
+    template <typename T, typename V> void set(const ContextKey<T> &key, V &&value) {
+        Slot &slot = slots_[key.index()];
+        if (slot.object) {
+            *static_cast<T *>(slot.object) = std::forward<V>(value);
+            return;
+        }
+        emplaceSlot<T>(key.index(), std::forward<V>(value));
+    }
+
+    template <typename T> T *find(const ContextKey<T> &key) {
+        return static_cast<T *>(slots_[key.index()].object);
+    }
+
+    template <typename T> const T *find(const ContextKey<T> &key) const {
+        return static_cast<const T *>(slots_[key.index()].object);
+    }
+
+    template <typename T> const T &get(const ContextKey<T> &key) const {
+        const T *value = find(key);
+        if (!value) {
+            throw std::runtime_error("Context data not found for key: " + key.name());
+        }
+        return *value;
+    }
+
+    template <typename T> bool has(const ContextKey<T> &key) const {
+        return slots_[key.index()].object != nullptr;
+    }
+
     HttpResponse &response();
 
     Context &status(int code);
@@ -54,18 +193,130 @@ public:
 
     void html(const std::string &html);
 
+    /* Send a shared immutable buffer (e.g. a cached document) without copying it */
+    void data(const std::string &contentType, std::shared_ptr<const std::string> data);
+
+    /* Send a file with sendfile, answering If-None-Match, If-Modified-Since, Range and If-Range */
+    void file(const std::string &path);
+    void file(std::shared_ptr<const FileHandle> file, const std::string &contentType);
+
+    /* Stream the body: producer runs after the handler chain with status and headers as set */
+    void stream(StreamProducer producer) { stream_producer_ = std::move(producer); }
+    bool isStreaming() const { return static_cast<bool>(stream_producer_); }
+    StreamProducer takeStreamProducer() { return std::move(stream_producer_); }
+
     Context &header(const std::string &key, const std::string &value);
 
+    /*
+     * Detach the response: the handler may return before it is ready (a
+     * coroutine waiting on a timer, an upstream call) and the request stays
+     * alive until the responder is sent. Middlewares that look at the
+     * response after next() see it before it is complete; they post-process
+     * through beforeSend() instead. Throws if the
+     * response is already deferred, unless its responder was lent back with
+     * lendResponder(): then that one is handed out.
+     */
+    Responder defer();
+    bool isDeferred() const { return deferred_; }
+    /*
+     * Engine side: while set, defer() moves *outstanding out instead of
+     * throwing, so a handler running on an executor can defer on its own.
+     * The lender checks *outstanding afterwards and clears this if unclaimed.
+     */
+    void lendResponder(Responder *outstanding) { lent_responder_ = outstanding; }
+    /* Server side: finish runs once the handler has returned and the responder was sent */
+    void onComplete(TaskSlot finish);
+
+    /*
+     * Post-process the final response: hook runs before serialization, once
+     * the handler chain has returned for an immediate answer or in
+     * Responder::send() for a deferred one, on the thread that owns the
+     * response then. Hooks run innermost first, like code after next().
+     */
+    void beforeSend(TaskSlot hook) { before_send_.push_back(std::move(hook)); }
+    /* Engine and Responder side: run the hooks and drop them */
+    void finalizeResponse();
+
     void setParams(const std::map<std::string, std::string> &params);
 
+    /* Poll in long handlers: true once the client is gone or the request deadline passed */
+    bool cancelled() const { return cancellation_.cancelled(); }
+    /* Copyable handle for work that outlives the handler call */
+    const CancellationToken &cancellation() const { return cancellation_; }
+    void setCancellation(CancellationToken token) { cancellation_ = std::move(token); }
+
 private:
-    const HttpRequest &request_;
+    template <typename T> friend class ContextKey;
+    friend class Responder;
+
+    static constexpr size_t SLOT_INLINE_SIZE = 32;
+    static_assert(ContextKeyRegistry::MAX_SLOTS <= 32, "used_slots_ is a 32-bit mask");
+
+    struct Slot {
+        alignas(std::max_align_t) unsigned char storage[SLOT_INLINE_SIZE];
+        void *object = nullptr; /* Points into storage, or into the arena for large types */
+        void (*destroy)(void *) = nullptr;
+    };
+
+    template <typename T, typename V> void emplaceSlot(size_t index, V &&value) {
+        Slot &slot = slots_[index];
+        void *where = slot.storage;
+        if constexpr (sizeof(T) > SLOT_INLINE_SIZE || alignof(T) > alignof(std::max_align_t)) {
+            where = arena_.resource()->allocate(sizeof(T), alignof(T));
+        }
+        slot.object = ::new (where) T(std::forward<V>(value));
+        slot.destroy = [](void *object) { static_cast<T *>(object)->~T(); };
+        used_slots_ |= (std::uint32_t{1} << index);
+    }
+
+    template <typename T> static void assignSlotFromAny(Context &ctx, size_t index, const std::any &value) {
+        const T &typed = std::any_cast<const T &>(value);
+        Slot &slot = ctx.slots_[index];
+        if (slot.object) {
+            *static_cast<T *>(slot.object) = typed;
+        } else {
+            ctx.emplaceSlot<T>(index, typed);
+        }
+    }
+
+    void clearSlots();
+    void complete();
+    void runCompletion();
+
+    static constexpr std::uint8_t COMPLETION_ARMED = 1;
+    static constexpr std::uint8_t COMPLETION_DONE = 2;
+
+    /* Declared first: everything below allocates from it */
+    RequestArena arena_;
+    const HttpRequest *request_;
+    HttpRequest request_storage_;
     HttpResponse response_;
-    std::map<std::string, std::string> router_params_;
+    std::pmr::map<std::string, std::string> router_params_;
     mutable std::shared_mutex context_data_mutex_;
-    std::map<std::string, std::any> context_data_;
+    /* Keys live on the arena; std::any keeps large payloads on the heap (ContextKey slots do not) */
+    std::pmr::map<std::pmr::string, std::any, std::less<>> context_data_;
+    std::array<Slot, ContextKeyRegistry::MAX_SLOTS> slots_{};
+    std::uint32_t used_slots_ = 0;
+    StreamProducer stream_producer_;
+    std::vector<TaskSlot> before_send_;  /* Capacity survives reset() */
+    bool deferred_ = false;
+    Responder *lent_responder_ = nullptr;
+    std::atomic<std::uint8_t> completion_state_{0};
+    TaskSlot completion_;
+    CancellationToken cancellation_;
 };
 
+template <typename T>
+ContextKey<T>::ContextKey(const std::string &name)
+    : name_(name),
+      index_(ContextKeyRegistry::add(name, std::type_index(typeid(T)), &Context::assignSlotFromAny<T>)) {}
+
+/* Keys used by the built-in middlewares */
+namespace ContextKeys {
+inline const ContextKey<std::string> RequestId{"request_id"};
+inline const ContextKey<std::string> TraceId{"trace_id"};
+} // namespace ContextKeys
+
 using HandlerFunc = std::function<void(Context &)>;
 
 } // namespace Gecko
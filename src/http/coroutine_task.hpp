@@ -0,0 +1,309 @@
+#ifndef COROUTINE_TASK_HPP
+#define COROUTINE_TASK_HPP
+
+/*
+ * Coroutine request handlers. Requires C++20; the library itself builds as
+ * C++17 and this header is empty there, so only translation units compiled
+ * with coroutine support see Task, asyncHandler() and the awaitables.
+ *
+ *   engine.GET("/slow", Gecko::asyncHandler([](Gecko::Context& ctx) -> Gecko::Task<> {
+ *       co_await Gecko::sleepFor(std::chrono::milliseconds(50));
+ *       ctx.string("done");
+ *   }));
+ *
+ * A suspended handler holds no worker thread. It resumes on the pool it was
+ * running on, so the pool must outlive pending timers (the server's does).
+ */
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include "context.hpp"
+#include "thread_pool.hpp"
+#include "timer_service.hpp"
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Gecko {
+
+/*
+ * Coroutine frames from per-thread size-class freelists. A frame freed on
+ * another thread joins that thread's lists, as with ObjectPool.
+ */
+class FramePool {
+public:
+    static constexpr size_t CLASS_COUNT = 5;
+    static constexpr std::array<size_t, CLASS_COUNT> CLASS_SIZES = {256, 512, 1024, 2048, 4096};
+    static constexpr size_t MAX_CACHED = 64;
+
+    static void* allocate(size_t size) {
+        size_t index = classFor(size);
+        if (index == CLASS_COUNT) {
+            return ::operator new(size);
+        }
+        auto& free = local().free[index];
+        if (free.empty()) {
+            return ::operator new(CLASS_SIZES[index]);
+        }
+        void* frame = free.back();
+        free.pop_back();
+        return frame;
+    }
+
+    static void deallocate(void* frame, size_t size) noexcept {
+        size_t index = classFor(size);
+        if (index == CLASS_COUNT) {
+            ::operator delete(frame);
+            return;
+        }
+        auto& free = local().free[index];
+        if (free.size() >= MAX_CACHED) {
+            ::operator delete(frame);
+            return;
+        }
+        free.push_back(frame);
+    }
+
+private:
+    struct Lists {
+        std::array<std::vector<void*>, CLASS_COUNT> free;
+        ~Lists() {
+            for (auto& list : free) {
+                for (void* frame : list) {
+                    ::operator delete(frame);
+                }
+            }
+        }
+    };
+
+    static Lists& local() {
+        thread_local Lists lists;
+        return lists;
+    }
+
+    static size_t classFor(size_t size) {
+        size_t index = 0;
+        while (index < CLASS_COUNT && CLASS_SIZES[index] < size) {
+            ++index;
+        }
+        return index;
+    }
+};
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    static void* operator new(size_t size) { return FramePool::allocate(size); }
+    static void operator delete(void* frame, size_t size) noexcept { FramePool::deallocate(frame, size); }
+
+    /* Lazy: the body starts when the task is awaited */
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    /* Resume the awaiting coroutine directly instead of nesting a call */
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+    T result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() noexcept {}
+
+    void result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace detail
+
+/* Lazily started coroutine producing T; awaiting it runs it and yields its result */
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { destroy(); }
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+    auto operator co_await() noexcept {
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    void destroy() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+/* Continue a suspended coroutine on pool, or right here when there is none */
+inline void resumeOn(ThreadPool* pool, std::coroutine_handle<> handle) {
+    if (pool) {
+        try {
+            pool->post([handle]() { handle.resume(); });
+            return;
+        } catch (const std::exception&) {
+            /* Pool is stopping: finish the coroutine on this thread rather than leak it */
+        }
+    }
+    handle.resume();
+}
+
+/* Eagerly started, self-destroying coroutine that drives a handler to completion */
+struct Detached {
+    struct promise_type {
+        static void* operator new(size_t size) { return FramePool::allocate(size); }
+        static void operator delete(void* frame, size_t size) noexcept { FramePool::deallocate(frame, size); }
+
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+inline Detached driveHandler(Task<void> task, Responder responder) {
+    try {
+        co_await task;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Coroutine handler failed: " << e.what() << std::endl;
+        responder.response().reset();
+        responder.context().status(500).string("Internal Server Error");
+    }
+    responder.send();
+}
+
+} // namespace detail
+
+/* Give up the worker and continue behind whatever is queued on the same pool */
+inline auto yield() noexcept {
+    struct Awaiter {
+        ThreadPool* pool = ThreadPool::current();
+        bool await_ready() const noexcept { return pool == nullptr; }
+        void await_suspend(std::coroutine_handle<> handle) { pool->post([handle]() { handle.resume(); }); }
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{};
+}
+
+/* Suspend without holding a thread; resumes on the current pool after the deadline */
+inline auto sleepUntil(std::chrono::steady_clock::time_point deadline) noexcept {
+    struct Awaiter {
+        std::chrono::steady_clock::time_point deadline;
+        bool await_ready() const noexcept { return std::chrono::steady_clock::now() >= deadline; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            ThreadPool* pool = ThreadPool::current();
+            TimerService::instance().schedule(deadline, [pool, handle]() {
+                detail::resumeOn(pool, handle);
+            });
+        }
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{deadline};
+}
+
+template <typename Rep, typename Period>
+auto sleepFor(std::chrono::duration<Rep, Period> delay) noexcept {
+    return sleepUntil(std::chrono::steady_clock::now() +
+                      std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay));
+}
+
+using CoroutineHandlerFunc = std::function<Task<void>(Context&)>;
+
+/*
+ * Adapt a coroutine handler to a route handler. The response is deferred
+ * (Context::defer): the server writes it when the coroutine finishes, and
+ * an exception escaping the coroutine becomes a 500.
+ */
+inline HandlerFunc asyncHandler(CoroutineHandlerFunc handler) {
+    return [handler = std::move(handler)](Context& ctx) {
+        Responder responder = ctx.defer();
+        detail::driveHandler(handler(ctx), std::move(responder));
+    };
+}
+
+} // namespace Gecko
+
+#endif /* __cpp_impl_coroutine */
+
+#endif /* COROUTINE_TASK_HPP */
@@ -0,0 +1,144 @@
+#include "cpu_affinity.hpp"
+#include <pthread.h>
+#include <sched.h>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace Gecko {
+
+namespace {
+
+int parse_cpu(std::string_view text, std::string_view list) {
+    int value = -1;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size() || value < 0) {
+        throw std::invalid_argument("Invalid CPU list: " + std::string(list));
+    }
+    return value;
+}
+
+/* cpu -> node, read once; machines without the node directory map nothing */
+const std::unordered_map<int, int>& cpu_nodes() {
+    static const std::unordered_map<int, int> nodes = [] {
+        std::unordered_map<int, int> map;
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("node", 0) != 0 || name.size() == 4) {
+                continue;
+            }
+            int node = 0;
+            auto digits = std::string_view(name).substr(4);
+            auto parsed = std::from_chars(digits.data(), digits.data() + digits.size(), node);
+            if (parsed.ec != std::errc() || parsed.ptr != digits.data() + digits.size()) {
+                continue;
+            }
+            std::ifstream file(entry.path() / "cpulist");
+            std::string list;
+            if (!std::getline(file, list) || list.empty()) {
+                continue;  /* Memory-only node */
+            }
+            try {
+                for (int cpu : parse_cpu_list(list)) {
+                    map[cpu] = node;
+                }
+            } catch (const std::invalid_argument&) {
+                continue;
+            }
+        }
+        return map;
+    }();
+    return nodes;
+}
+
+} // namespace
+
+std::vector<int> parse_cpu_list(std::string_view list) {
+    std::vector<int> cpus;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        std::string_view item = list.substr(start, comma == std::string_view::npos ? std::string_view::npos
+                                                                                  : comma - start);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t' || item.back() == '\n')) {
+            item.remove_suffix(1);
+        }
+        size_t dash = item.find('-');
+        if (dash == std::string_view::npos) {
+            cpus.push_back(parse_cpu(item, list));
+        } else {
+            int first = parse_cpu(item.substr(0, dash), list);
+            int last = parse_cpu(item.substr(dash + 1), list);
+            if (last < first) {
+                throw std::invalid_argument("Invalid CPU list: " + std::string(list));
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return cpus;
+}
+
+int numa_node_of(int cpu) {
+    const auto& nodes = cpu_nodes();
+    auto it = nodes.find(cpu);
+    return it == nodes.end() ? 0 : it->second;
+}
+
+bool pin_current_thread(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+std::vector<int> pair_with_reactors(const std::vector<int>& worker_cpus, const std::vector<int>& io_cpus,
+                                    const std::function<int(int)>& node_of) {
+    if (io_cpus.empty()) {
+        return worker_cpus;
+    }
+    /* Worker CPUs per node, in the order given */
+    std::map<int, std::vector<int>> by_node;
+    for (int cpu : worker_cpus) {
+        by_node[node_of(cpu)].push_back(cpu);
+    }
+    std::map<int, size_t> taken;
+
+    std::vector<int> paired;
+    paired.reserve(worker_cpus.size());
+    for (size_t i = 0; i < worker_cpus.size(); ++i) {
+        int node = node_of(io_cpus[i % io_cpus.size()]);
+        auto it = by_node.find(node);
+        if (it == by_node.end() || taken[node] == it->second.size()) {
+            /* No worker CPU left on the reactor's node: take from the node with the most left */
+            it = by_node.end();
+            size_t most = 0;
+            for (auto candidate = by_node.begin(); candidate != by_node.end(); ++candidate) {
+                size_t left = candidate->second.size() - taken[candidate->first];
+                if (left > most) {
+                    most = left;
+                    it = candidate;
+                }
+            }
+        }
+        paired.push_back(it->second[taken[it->first]++]);
+    }
+    return paired;
+}
+
+} /* namespace Gecko */
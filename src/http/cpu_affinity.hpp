@@ -0,0 +1,29 @@
+#ifndef CPU_AFFINITY_HPP
+#define CPU_AFFINITY_HPP
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+namespace Gecko {
+
+/* CPU ids of a kernel-style list such as "0-3,8,10-11"; throws std::invalid_argument when malformed */
+std::vector<int> parse_cpu_list(std::string_view list);
+
+/* NUMA node of a CPU as reported under /sys/devices/system/node; 0 when unknown */
+int numa_node_of(int cpu);
+
+/* Pin the calling thread to one CPU; false when the kernel refuses (offline CPU, cgroup limits) */
+bool pin_current_thread(int cpu);
+
+/*
+ * Reorder worker CPUs so that worker i runs on the NUMA node of reactor
+ * i % io_cpus.size(), as far as the worker set has CPUs on that node.
+ * Returns a permutation of worker_cpus.
+ */
+std::vector<int> pair_with_reactors(const std::vector<int>& worker_cpus, const std::vector<int>& io_cpus,
+                                    const std::function<int(int)>& node_of = numa_node_of);
+
+} /* namespace Gecko */
+
+#endif /* CPU_AFFINITY_HPP */
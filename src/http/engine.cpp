@@ -2,19 +2,144 @@
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 
 namespace Gecko {
 
-auto Engine::Static(const std::string &relativePath,
-                    const std::string &root) -> Engine & {
-    /* TODO: implement static file service */
+RouteGroup &RouteGroup::GET(const std::string &path, HandlerFunc handler) {
+    return AddRoute(HttpMethod::GET, path, std::move(handler));
+}
+
+RouteGroup &RouteGroup::POST(const std::string &path, HandlerFunc handler) {
+    return AddRoute(HttpMethod::POST, path, std::move(handler));
+}
+
+RouteGroup &RouteGroup::PUT(const std::string &path, HandlerFunc handler) {
+    return AddRoute(HttpMethod::PUT, path, std::move(handler));
+}
+
+RouteGroup &RouteGroup::DELETE(const std::string &path, HandlerFunc handler) {
+    return AddRoute(HttpMethod::DELETE, path, std::move(handler));
+}
+
+RouteGroup &RouteGroup::PATCH(const std::string &path, HandlerFunc handler) {
+    return AddRoute(HttpMethod::PATCH, path, std::move(handler));
+}
+
+RouteGroup &RouteGroup::OPTIONS(const std::string &path, HandlerFunc handler) {
+    return AddRoute(HttpMethod::OPTIONS, path, std::move(handler));
+}
+
+RouteGroup &RouteGroup::HEAD(const std::string &path, HandlerFunc handler) {
+    return AddRoute(HttpMethod::HEAD, path, std::move(handler));
+}
+
+RouteGroup &RouteGroup::AddRoute(HttpMethod method, const std::string &path, HandlerFunc handler) {
+    engine_->router_.insert(method, prefix_ + path, std::move(handler), executor_);
+    return *this;
+}
+
+RouteGroup RouteGroup::Group(const std::string &prefix) const {
+    return RouteGroup(*engine_, prefix_ + prefix, executor_);
+}
+
+RouteGroup &RouteGroup::Executor(const std::string &name) {
+    executor_ = engine_->executorId(name);
+    return *this;
+}
+
+auto Engine::Executor(const std::string &name, size_t threads, size_t queue_limit) -> Engine & {
+    for (const auto &executor : executors_) {
+        if (executor.name == name) {
+            throw std::invalid_argument("Executor already declared: " + name);
+        }
+    }
+    executors_.push_back(ExecutorPool{name, threads, queue_limit, nullptr});
+    return *this;
+}
+
+size_t Engine::executorId(const std::string &name) const {
+    for (size_t i = 0; i < executors_.size(); ++i) {
+        if (executors_[i].name == name) {
+            return i + 1;
+        }
+    }
+    throw std::invalid_argument("Unknown executor: " + name);
+}
+
+auto Engine::Static(const std::string &relativePath, const std::string &root,
+                    StaticOptions options) -> Engine & {
+    auto files = std::make_shared<const StaticFiles>(root, std::move(options));
+    std::string prefix = relativePath;
+    while (!prefix.empty() && prefix.back() == '/') {
+        prefix.pop_back();
+    }
+    HandlerFunc handler = [files](Context &ctx) { files->serve(ctx, ctx.param("filepath")); };
+    router_.insert(HttpMethod::GET, prefix + "/*filepath", handler);
+    router_.insert(HttpMethod::HEAD, prefix + "/*filepath", handler);
+    return *this;
+}
+
+auto Engine::Precomputed(const std::string &path, const HttpResponse &response) -> Engine & {
+    response_cache_->put(HttpMethod::GET, path, response);
+    routePrecomputed(path);
+    return *this;
+}
+
+auto Engine::Precomputed(const std::string &path, ResponseCache::Generator generator) -> Engine & {
+    response_cache_->put(HttpMethod::GET, path, std::move(generator));
+    routePrecomputed(path);
     return *this;
 }
 
+/* Routed fallback for requests the IO thread does not match (e.g. with a body) */
+void Engine::routePrecomputed(const std::string &path) {
+    router_.insert(HttpMethod::GET, path, [cache = response_cache_, path](Context &ctx) {
+        if (auto entry = cache->find(HttpMethod::GET, path)) {
+            ctx.response() = entry->source;
+        } else {
+            ctx.status(404).string("404 Not Found");
+        }
+    });
+}
+
+void Engine::Serve(Context &ctx) {
+    startExecutors();
+    handleRequest(ctx);
+    /* A deferred response is finalized by its Responder when sent */
+    if (!ctx.isDeferred()) {
+        ctx.finalizeResponse();
+    }
+}
+
 void Engine::Run(const ServerConfig &config) {
     printServerInfo(config);
+    startExecutors();
     Server server(config);
-    server.run([this](Context &ctx) -> void { this->handleRequest(ctx); });
+    /* Executor responders finish through the server, so the pools drain first */
+    struct ExecutorDrain {
+        Engine *engine;
+        ~ExecutorDrain() { engine->stopExecutors(); }
+    } drain{this};
+    if (!response_cache_->empty()) {
+        server.set_response_cache(response_cache_);
+    }
+    server.run([this](Context &ctx) -> void { this->Serve(ctx); });
+}
+
+void Engine::startExecutors() {
+    std::call_once(executors_started_, [this] {
+        for (auto &executor : executors_) {
+            executor.pool = std::make_unique<ThreadPool>(executor.threads);
+        }
+    });
+}
+
+void Engine::stopExecutors() {
+    /* ThreadPool's destructor runs what is queued before joining */
+    for (auto &executor : executors_) {
+        executor.pool.reset();
+    }
 }
 
 void Engine::handleRequest(Context &ctx) {
@@ -25,9 +150,42 @@ void Engine::handleRequest(Context &ctx) {
     }
     ctx.setParams(result->params);
     HandlerFunc finalHandler = result->handler;
+    if (result->executor != 0) {
+        ExecutorPool &executor = executors_[result->executor - 1];
+        if (executor.pool && ThreadPool::current() != executor.pool.get()) {
+            runOnExecutor(executor, ctx, std::move(finalHandler));
+            return;
+        }
+    }
     executeMiddlewares(ctx, finalHandler);
 }
 
+void Engine::runOnExecutor(ExecutorPool &executor, Context &ctx, HandlerFunc handler) {
+    /* Bulkhead is full: refuse here rather than let the queue grow */
+    if (executor.queue_limit != 0 && executor.pool->pending_tasks() >= executor.queue_limit) {
+        ctx.status(503).header("Retry-After", "1").string("Service Unavailable");
+        return;
+    }
+    executor.pool->post([this, handler = std::move(handler), responder = ctx.defer()]() mutable {
+        Context &deferred = responder.context();
+        /* A handler that defers itself takes this responder; after that ctx is not ours to touch */
+        deferred.lendResponder(&responder);
+        try {
+            executeMiddlewares(deferred, handler);
+        } catch (const std::exception &e) {
+            std::cerr << "[ERROR] Handler on executor failed: " << e.what() << std::endl;
+            if (responder) {
+                responder.response().reset();
+                deferred.status(500).string("Internal Server Error");
+            }
+        }
+        if (responder) {
+            deferred.lendResponder(nullptr);
+            responder.send();
+        }
+    });
+}
+
 void Engine::executeMiddlewares(Context &ctx, HandlerFunc finalHandler) {
     if (middlewares_.empty()) {
         finalHandler(ctx);
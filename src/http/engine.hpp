@@ -2,9 +2,16 @@
 #define ENGINE_HPP
 
 #include "context.hpp"
+#include "response_cache.hpp"
 #include "router.hpp"
 #include "server.hpp"
 #include "server_config.hpp"
+#include "static_files.hpp"
+#include "thread_pool.hpp"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <functional>
 
@@ -12,6 +19,42 @@ namespace Gecko {
 
 using MiddlewareFunc = std::function<void(Context&, std::function<void()>)>;
 
+class Engine;
+
+/*
+ * Routes registered under a common path prefix. A group bound to an
+ * executor (a bulkhead pool from Engine::Executor) runs its requests there
+ * from right after routing, middlewares included, so slow endpoints queue
+ * on their own threads instead of the shared workers. A handler there that
+ * calls defer() (async, fiber or batched handlers) takes over the response
+ * the executor deferred.
+ */
+class RouteGroup {
+public:
+    RouteGroup& GET(const std::string& path, HandlerFunc handler);
+    RouteGroup& POST(const std::string& path, HandlerFunc handler);
+    RouteGroup& PUT(const std::string& path, HandlerFunc handler);
+    RouteGroup& DELETE(const std::string& path, HandlerFunc handler);
+    RouteGroup& PATCH(const std::string& path, HandlerFunc handler);
+    RouteGroup& OPTIONS(const std::string& path, HandlerFunc handler);
+    RouteGroup& HEAD(const std::string& path, HandlerFunc handler);
+    RouteGroup& AddRoute(HttpMethod method, const std::string& path, HandlerFunc handler);
+
+    /* Nested group; inherits the executor */
+    RouteGroup Group(const std::string& prefix) const;
+    /* Run routes added from now on on a named executor; throws std::invalid_argument if undeclared */
+    RouteGroup& Executor(const std::string& name);
+
+private:
+    friend class Engine;
+    RouteGroup(Engine& engine, std::string prefix, size_t executor)
+        : engine_(&engine), prefix_(std::move(prefix)), executor_(executor) {}
+
+    Engine* engine_;
+    std::string prefix_;
+    size_t executor_;
+};
+
 class Engine {
 public:
     Engine() = default;
@@ -56,14 +99,35 @@ public:
         return *this;
     }
 
+    /* Routes under a common prefix, optionally bound to an executor */
+    RouteGroup Group(const std::string& prefix) { return RouteGroup(*this, prefix, 0); }
+
+    /*
+     * Declare a bulkhead executor: threads of its own, and with queue_limit
+     * a 503 for requests arriving while that many are already queued on it
+     * (0 = unbounded). The threads start with Run() or the first Serve(),
+     * and Run() drains them before its server goes away.
+     */
+    Engine& Executor(const std::string& name, size_t threads, size_t queue_limit = 0);
+
     /* Middleware support */
     Engine& Use(MiddlewareFunc middleware) {
         middlewares_.push_back(middleware);
         return *this;
     }
 
-    /* Static file service */
-    Engine& Static(const std::string& relativePath, const std::string& root); 
+    /* Immutable GET route: serialized once and answered on the IO thread, bypassing middlewares */
+    Engine& Precomputed(const std::string& path, const HttpResponse& response);
+    /* Same, regenerated and re-published by Responses().refresh(HttpMethod::GET, path) */
+    Engine& Precomputed(const std::string& path, ResponseCache::Generator generator);
+    ResponseCache& Responses() { return *response_cache_; }
+
+    /* Files under root at relativePath/..., GET and HEAD, with precompressed variants */
+    Engine& Static(const std::string& relativePath, const std::string& root,
+                   StaticOptions options = StaticOptions());
+
+    /* Route and answer ctx as the server would, without a socket; may leave it deferred */
+    void Serve(Context& ctx);
 
     void Run(const ServerConfig& config);
     void Run(int port = 8080) {
@@ -84,12 +148,29 @@ public:
     }
 
 private:
+    friend class RouteGroup;
+
+    struct ExecutorPool {
+        std::string name;
+        size_t threads;
+        size_t queue_limit;
+        std::unique_ptr<ThreadPool> pool;
+    };
+
     Router router_;
+    std::vector<ExecutorPool> executors_;  /* Route executor ids are index + 1 */
+    std::once_flag executors_started_;
     std::vector<MiddlewareFunc> middlewares_;
+    std::shared_ptr<ResponseCache> response_cache_ = std::make_shared<ResponseCache>();
 
     void handleRequest(Context& ctx); 
+    void runOnExecutor(ExecutorPool& executor, Context& ctx, HandlerFunc handler);
+    size_t executorId(const std::string& name) const;
+    void startExecutors();
+    void stopExecutors();
     void executeMiddlewares(Context& ctx, HandlerFunc finalHandler); 
     void printServerInfo(const ServerConfig& config); 
+    void routePrecomputed(const std::string& path);
 };
 
 } // namespace Gecko
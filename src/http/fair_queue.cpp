@@ -0,0 +1,163 @@
+#include "fair_queue.hpp"
+#include "header_text.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace Gecko {
+
+RequestView::RequestView(std::string_view raw, std::string_view peer) {
+    size_t line_end = raw.find("\r\n");
+    std::string_view request_line = raw.substr(0, line_end);
+    if (line_end != std::string_view::npos) {
+        size_t headers_end = raw.find("\r\n\r\n", line_end);
+        headers_ = raw.substr(line_end + 2, headers_end == std::string_view::npos ? std::string_view::npos
+                                                                                  : headers_end - line_end);
+    }
+
+    /* METHOD SP target SP version */
+    size_t method_end = request_line.find(' ');
+    method_ = request_line.substr(0, method_end);
+    if (method_end != std::string_view::npos) {
+        size_t target_end = request_line.find_first_of(" ?", method_end + 1);
+        path_ = request_line.substr(method_end + 1, target_end == std::string_view::npos
+                                                        ? std::string_view::npos
+                                                        : target_end - method_end - 1);
+        size_t version_start = request_line.rfind(' ');
+        if (version_start > method_end) {
+            version_ = request_line.substr(version_start + 1);
+        }
+    }
+
+    size_t port = peer.rfind(':');
+    peer_ = peer.substr(0, port);
+}
+
+std::string_view RequestView::header(std::string_view name) const {
+    size_t line = 0;
+    while (line < headers_.size()) {
+        size_t next = headers_.find("\r\n", line);
+        std::string_view field = headers_.substr(line, next == std::string_view::npos ? std::string_view::npos
+                                                                                      : next - line);
+        if (field.size() > name.size() && field[name.size()] == ':' &&
+            detail::equalsIgnoreCase(field.substr(0, name.size()), name)) {
+            return detail::trim(field.substr(name.size() + 1));
+        }
+        if (next == std::string_view::npos) {
+            break;
+        }
+        line = next + 2;
+    }
+    return {};
+}
+
+namespace Classifiers {
+
+RequestClassifier byHeader(std::string name) {
+    return [name = std::move(name)](const RequestView& request) {
+        return std::string(request.header(name));
+    };
+}
+
+RequestClassifier byPath(size_t depth) {
+    return [depth](const RequestView& request) {
+        std::string_view path = request.path();
+        size_t end = 0;
+        for (size_t segment = 0; segment < depth && end != std::string_view::npos; ++segment) {
+            end = path.find('/', end + 1);
+        }
+        return std::string(path.substr(0, end));
+    };
+}
+
+RequestClassifier byPeerAddress() {
+    return [](const RequestView& request) {
+        return std::string(request.peer());
+    };
+}
+
+} // namespace Classifiers
+
+FairQueue::FairQueue(size_t quantum, size_t max_per_class)
+    : quantum_(std::max<size_t>(quantum, 1)), max_per_class_(max_per_class) {}
+
+void FairQueue::setWeight(const std::string& name, size_t weight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    weight = std::max<size_t>(weight, 1);
+    weights_[name] = weight;
+    auto it = flows_.find(name);
+    if (it != flows_.end()) {
+        it->second.weight = weight;
+    }
+}
+
+FairQueue::Flow& FairQueue::flow(const std::string& name) {
+    auto [it, inserted] = flows_.try_emplace(name);
+    if (inserted) {
+        it->second.name = name;
+        auto weight = weights_.find(name);
+        if (weight != weights_.end()) {
+            it->second.weight = weight->second;
+        }
+    }
+    return it->second;
+}
+
+bool FairQueue::push(const std::string& name, TaskSlot task, size_t cost) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Flow& target = flow(name);
+    if (max_per_class_ != 0 && target.items.size() >= max_per_class_) {
+        return false;
+    }
+    target.items.push_back({std::move(task), cost});
+    ++size_;
+    if (!target.active) {
+        /* A newly backlogged class gets its quantum for the first visit */
+        target.active = true;
+        target.deficit = quantum_ * target.weight;
+        active_.push_back(&target);
+    }
+    return true;
+}
+
+TaskSlot FairQueue::pop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!active_.empty()) {
+        Flow* current = active_.front();
+        Flow::Item& head = current->items.front();
+        if (current->deficit < head.cost) {
+            /* Visit over: top up for the next round and move on */
+            current->deficit += quantum_ * current->weight;
+            active_.splice(active_.end(), active_, active_.begin());
+            continue;
+        }
+
+        current->deficit -= head.cost;
+        TaskSlot task = std::move(head.task);
+        current->items.pop_front();
+        --size_;
+        if (current->items.empty()) {
+            /* An idle class keeps no credit */
+            current->active = false;
+            current->deficit = 0;
+            active_.pop_front();
+            if (weights_.find(current->name) == weights_.end()) {
+                flows_.erase(current->name);
+            }
+        }
+        return task;
+    }
+    return TaskSlot();
+}
+
+size_t FairQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t FairQueue::size(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = flows_.find(name);
+    return it == flows_.end() ? 0 : it->second.items.size();
+}
+
+} /* namespace Gecko */
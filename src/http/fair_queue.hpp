@@ -0,0 +1,105 @@
+#ifndef FAIR_QUEUE_HPP
+#define FAIR_QUEUE_HPP
+
+#include "task_slot.hpp"
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Gecko {
+
+/* Unparsed request as the IO thread sees it, for classifying or cache lookups before any work is done */
+class RequestView {
+public:
+    RequestView(std::string_view raw, std::string_view peer);
+
+    std::string_view method() const { return method_; }
+    /* Target without the query string */
+    std::string_view path() const { return path_; }
+    /* "HTTP/1.1"; empty when the request line has no version */
+    std::string_view version() const { return version_; }
+    /* Client address without the port */
+    std::string_view peer() const { return peer_; }
+    /* First value of a header, case-insensitive; empty when absent */
+    std::string_view header(std::string_view name) const;
+
+private:
+    std::string_view headers_;  /* Header lines, after the request line */
+    std::string_view method_;
+    std::string_view path_;
+    std::string_view version_;
+    std::string_view peer_;
+};
+
+/* Maps a request to its tenant; requests of one tenant share a queue */
+using RequestClassifier = std::function<std::string(const RequestView&)>;
+
+namespace Classifiers {
+
+/* Value of a header such as an API key; requests without it share the "" class */
+RequestClassifier byHeader(std::string name);
+/* The first depth segments of the path, e.g. "/api/orders" for depth 2 */
+RequestClassifier byPath(size_t depth = 1);
+/* Client IP address */
+RequestClassifier byPeerAddress();
+
+} // namespace Classifiers
+
+/*
+ * Deficit round-robin over per-class FIFOs. Each visit to a backlogged
+ * class adds quantum * weight to its deficit and serves queued tasks while
+ * their cost fits, so over time every busy class gets throughput in
+ * proportion to its weight and a flood in one class only lengthens that
+ * class's own queue. Classes without a configured weight use weight 1 and
+ * are forgotten once their queue empties.
+ */
+class FairQueue {
+public:
+    explicit FairQueue(size_t quantum = 1, size_t max_per_class = 0);
+
+    FairQueue(const FairQueue&) = delete;
+    FairQueue& operator=(const FairQueue&) = delete;
+
+    void setWeight(const std::string& name, size_t weight);
+
+    /* False when the class already holds max_per_class tasks; the task is dropped */
+    bool push(const std::string& name, TaskSlot task, size_t cost = 1);
+
+    /* Next task in DRR order; empty when nothing is queued */
+    TaskSlot pop();
+
+    size_t size() const;
+    size_t size(const std::string& name) const;
+
+private:
+    struct Flow {
+        struct Item {
+            TaskSlot task;
+            size_t cost;
+        };
+        std::string name;
+        std::deque<Item> items;
+        size_t weight = 1;
+        size_t deficit = 0;
+        bool active = false;  /* In the round-robin list */
+    };
+
+    Flow& flow(const std::string& name);
+
+    size_t quantum_;
+    size_t max_per_class_;  /* 0 = unbounded */
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Flow> flows_;
+    std::unordered_map<std::string, size_t> weights_;
+    std::list<Flow*> active_;  /* Round-robin order; front is being served */
+    size_t size_ = 0;
+};
+
+} /* namespace Gecko */
+
+#endif /* FAIR_QUEUE_HPP */
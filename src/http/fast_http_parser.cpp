@@ -132,7 +132,7 @@ size_t FastHttpParser::parse_content_length(const FastHeaderMap& headers) {
     for (const auto& [key, value] : headers) {
         if (key.size() == 14 && 
             std::equal(key.begin(), key.end(), "content-length",
-                      [](char a, char b) { return std::tolower(a) == std::tolower(b); })) {
+                      [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); })) {
             size_t result = 0;
             auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
             if (ec == std::errc{}) {
@@ -154,7 +154,9 @@ void HttpRequestAdapter::convert(const FastHttpRequest& fast_req, HttpRequest& r
         default: request.setMethod(HttpMethod::UNKNOWN); break;
     }
     
-    request.setUrl(std::string(fast_req.url));
+    /* Assign in place so a pooled request reuses its string capacity */
+    request.url.assign(fast_req.url);
+    request.parseQueryParams();
      if (fast_req.version == "HTTP/1.0") {
          request.setVersion(HttpVersion::HTTP_1_0);
      } else if (fast_req.version == "HTTP/1.1") {
@@ -163,12 +165,18 @@ void HttpRequestAdapter::convert(const FastHttpRequest& fast_req, HttpRequest& r
          request.setVersion(HttpVersion::UNKNOWN);
      }
     
-    HttpHeaderMap headers;
+    request.headers.clear();
+    /* Built from the views, so keys and values are allocated on the request's arena;
+       a repeated field keeps its last value, as HttpRequestParser does */
     for (const auto& [key, value] : fast_req.headers) {
-        headers[std::string(key)] = std::string(value);
+        auto it = request.headers.lower_bound(key);
+        if (it != request.headers.end() && !request.headers.key_comp()(key, it->first)) {
+            it->second.assign(value);
+        } else {
+            request.headers.emplace_hint(it, key, value);
+        }
     }
-    request.setHeaders(std::move(headers));
-    request.setBody(std::string(fast_req.body));
+    request.body.assign(fast_req.body);
 }
 
 } // namespace Gecko 
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <string>
 #include <map>
+#include <memory_resource>
 #include <algorithm>
 #include <cctype>
 
@@ -26,20 +27,25 @@ struct FastCaseInsensitiveEqual {
     bool operator()(const std::string_view& lhs, const std::string_view& rhs) const {
         if (lhs.size() != rhs.size()) return false;
         return std::equal(lhs.begin(), lhs.end(), rhs.begin(),
-                         [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+                         [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); });
     }
 };
 
-using FastHeaderMap = std::unordered_map<std::string_view, std::string_view, 
-                                        FastCaseInsensitiveHash, FastCaseInsensitiveEqual>;
+using FastHeaderMap = std::pmr::unordered_map<std::string_view, std::string_view, 
+                                             FastCaseInsensitiveHash, FastCaseInsensitiveEqual>;
 
 struct FastHttpRequest {
+    FastHttpRequest() = default;
+    /* Maps allocate from the given resource (typically a RequestArena) */
+    explicit FastHttpRequest(std::pmr::memory_resource* resource)
+        : headers(resource), query_params(resource) {}
+
     FastHttpMethod method = FastHttpMethod::UNKNOWN;
     std::string_view url;
     std::string_view version;
     std::string_view body;
     FastHeaderMap headers;
-    std::unordered_map<std::string_view, std::string_view> query_params;
+    std::pmr::unordered_map<std::string_view, std::string_view> query_params;
     
     const char* raw_data = nullptr;
     size_t raw_size = 0;
@@ -0,0 +1,324 @@
+#include "fiber.hpp"
+#include "timer_service.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace Gecko {
+
+namespace {
+
+thread_local Fiber* t_current_fiber = nullptr;
+
+size_t pageSize() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/*
+ * One epoll thread that turns descriptor readiness into callbacks, for
+ * this_fiber::read/write. Registrations are one-shot and there can be one
+ * waiter per descriptor at a time.
+ */
+class ReadinessPoller {
+public:
+    static ReadinessPoller& instance() {
+        static ReadinessPoller poller;
+        return poller;
+    }
+
+    ReadinessPoller() {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd_ < 0 || stop_fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "fiber readiness poller");
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;  /* Stop marker */
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &event);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~ReadinessPoller() {
+        uint64_t one = 1;
+        ssize_t written = ::write(stop_fd_, &one, sizeof(one));
+        (void)written;
+        thread_.join();
+        close(stop_fd_);
+        close(epoll_fd_);
+    }
+
+    /* False with errno set when fd cannot be polled */
+    bool wait(int fd, uint32_t events, TaskSlot callback) {
+        auto* slot = new TaskSlot(std::move(callback));
+        epoll_event event{};
+        event.events = events | EPOLLONESHOT;
+        event.data.ptr = slot;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0) {
+            return true;
+        }
+        if (errno == EEXIST && epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0) {
+            return true;
+        }
+        int saved = errno;
+        delete slot;
+        errno = saved;
+        return false;
+    }
+
+private:
+    void run() {
+        epoll_event events[64];
+        while (true) {
+            int count = epoll_wait(epoll_fd_, events, 64, -1);
+            for (int i = 0; i < count; ++i) {
+                auto* slot = static_cast<TaskSlot*>(events[i].data.ptr);
+                if (!slot) {
+                    return;
+                }
+                (*slot)();
+                delete slot;
+            }
+        }
+    }
+
+    int epoll_fd_ = -1;
+    int stop_fd_ = -1;
+    std::thread thread_;
+};
+
+/* Park the current fiber until fd is ready; poll(2) outside a fiber */
+bool waitReady(int fd, uint32_t events) {
+    Fiber* self = Fiber::current();
+    if (!self) {
+        pollfd descriptor{fd, static_cast<short>(events == EPOLLIN ? POLLIN : POLLOUT), 0};
+        return ::poll(&descriptor, 1, -1) >= 0;
+    }
+    int error = 0;
+    self->park([self, fd, events, &error] {
+        if (!ReadinessPoller::instance().wait(fd, events, [self] { self->wake(); })) {
+            error = errno;
+            self->wake();
+        }
+    });
+    if (error != 0) {
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void* FiberStack::base() const {
+    return static_cast<char*>(mapping) + (mapped_size - usable_size);
+}
+
+FiberStackPool& FiberStackPool::instance() {
+    static FiberStackPool pool;
+    return pool;
+}
+
+FiberStackPool::~FiberStackPool() {
+    for (const FiberStack& stack : free_) {
+        munmap(stack.mapping, stack.mapped_size);
+    }
+}
+
+FiberStack FiberStackPool::acquire(size_t usable_size) {
+    size_t page = pageSize();
+    usable_size = (usable_size + page - 1) / page * page;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = free_.size(); i-- > 0;) {
+            if (free_[i].usable_size == usable_size) {
+                FiberStack stack = free_[i];
+                free_[i] = free_.back();
+                free_.pop_back();
+                return stack;
+            }
+        }
+    }
+
+    FiberStack stack;
+    stack.usable_size = usable_size;
+    stack.mapped_size = usable_size + page;
+    stack.mapping = mmap(nullptr, stack.mapped_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (stack.mapping == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "fiber stack mmap");
+    }
+    /* Stacks grow down: an overflow faults on the guard page instead of corrupting a neighbour */
+    if (mprotect(stack.mapping, page, PROT_NONE) != 0) {
+        int saved = errno;
+        munmap(stack.mapping, stack.mapped_size);
+        throw std::system_error(saved, std::generic_category(), "fiber stack guard page");
+    }
+    return stack;
+}
+
+void FiberStackPool::release(FiberStack stack) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < MAX_CACHED) {
+            free_.push_back(stack);
+            return;
+        }
+    }
+    munmap(stack.mapping, stack.mapped_size);
+}
+
+size_t FiberStackPool::cached() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+
+Fiber::Fiber(TaskSlot fn, FiberStack stack, ThreadPool* pool)
+    : fn_(std::move(fn)), stack_(stack), pool_(pool) {
+    getcontext(&context_);
+    context_.uc_stack.ss_sp = stack_.base();
+    context_.uc_stack.ss_size = stack_.usable_size;
+    context_.uc_link = nullptr;
+    /* makecontext only passes ints */
+    auto self = reinterpret_cast<std::uintptr_t>(this);
+    makecontext(&context_, reinterpret_cast<void (*)()>(&Fiber::trampoline), 2,
+                static_cast<unsigned int>(self >> 32), static_cast<unsigned int>(self & 0xffffffffu));
+}
+
+Fiber::~Fiber() {
+    FiberStackPool::instance().release(stack_);
+}
+
+void Fiber::start(TaskSlot fn, size_t stack_size) {
+    FiberStack stack = FiberStackPool::instance().acquire(stack_size);
+    auto* fiber = new Fiber(std::move(fn), stack, ThreadPool::current());
+    fiber->resume();
+}
+
+Fiber* Fiber::current() {
+    return t_current_fiber;
+}
+
+void Fiber::trampoline(unsigned int high, unsigned int low) {
+    auto* fiber = reinterpret_cast<Fiber*>((static_cast<std::uintptr_t>(high) << 32) | low);
+    try {
+        fiber->fn_();
+    } catch (const std::exception& e) {
+        std::cerr << "Fiber threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Fiber threw an unknown exception" << std::endl;
+    }
+    fiber->fn_.reset();
+    fiber->finished_ = true;
+    swapcontext(&fiber->context_, &fiber->caller_);
+}
+
+void Fiber::resume() {
+    Fiber* previous = t_current_fiber;
+    t_current_fiber = this;
+    swapcontext(&caller_, &context_);
+    t_current_fiber = previous;
+
+    if (finished_) {
+        delete this;
+        return;
+    }
+    /* Off the fiber's stack now, so whatever arm hands it to may resume it right away */
+    TaskSlot arm = std::move(arm_);
+    arm();
+}
+
+void Fiber::park(TaskSlot arm) {
+    arm_ = std::move(arm);
+    swapcontext(&context_, &caller_);
+}
+
+void Fiber::wake() {
+    if (pool_) {
+        try {
+            pool_->post([this] { resume(); });
+            return;
+        } catch (const std::exception&) {
+            /* Pool is stopping: run the fiber to completion here instead */
+        }
+    }
+    resume();
+}
+
+namespace this_fiber {
+
+void sleepUntil(std::chrono::steady_clock::time_point deadline) {
+    Fiber* self = Fiber::current();
+    if (!self) {
+        std::this_thread::sleep_until(deadline);
+        return;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+        return;
+    }
+    self->park([self, deadline] {
+        TimerService::instance().schedule(deadline, [self] { self->wake(); });
+    });
+}
+
+void yield() {
+    Fiber* self = Fiber::current();
+    if (!self) {
+        std::this_thread::yield();
+        return;
+    }
+    self->park([self] { self->wake(); });
+}
+
+ssize_t read(int fd, void* buffer, size_t length) {
+    while (true) {
+        ssize_t count = ::read(fd, buffer, length);
+        if (count >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return count;
+        }
+        if (!waitReady(fd, EPOLLIN)) {
+            return -1;
+        }
+    }
+}
+
+ssize_t write(int fd, const void* buffer, size_t length) {
+    while (true) {
+        ssize_t count = ::write(fd, buffer, length);
+        if (count >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return count;
+        }
+        if (!waitReady(fd, EPOLLOUT)) {
+            return -1;
+        }
+    }
+}
+
+} // namespace this_fiber
+
+HandlerFunc fiberHandler(HandlerFunc handler, size_t stack_size) {
+    auto shared = std::make_shared<HandlerFunc>(std::move(handler));
+    return [shared, stack_size](Context& ctx) {
+        Fiber::start([shared, responder = ctx.defer()]() mutable {
+            try {
+                (*shared)(responder.context());
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Fiber handler failed: " << e.what() << std::endl;
+                responder.response().reset();
+                responder.context().status(500).string("Internal Server Error");
+            }
+            responder.send();
+        }, stack_size);
+    };
+}
+
+} /* namespace Gecko */
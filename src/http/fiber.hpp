@@ -0,0 +1,119 @@
+#ifndef FIBER_HPP
+#define FIBER_HPP
+
+#include "context.hpp"
+#include "task_slot.hpp"
+#include "thread_pool.hpp"
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <sys/types.h>
+#include <ucontext.h>
+#include <vector>
+
+namespace Gecko {
+
+/* mmap'd fiber stack with a PROT_NONE guard page below it */
+struct FiberStack {
+    void* mapping = nullptr;  /* Guard page included */
+    size_t mapped_size = 0;
+    size_t usable_size = 0;
+
+    void* base() const;  /* Lowest usable address, just above the guard page */
+};
+
+/* Process-wide recycler for fiber stacks; stacks freed on any thread are reused */
+class FiberStackPool {
+public:
+    static constexpr size_t DEFAULT_STACK_SIZE = 64 * 1024;
+    static constexpr size_t MAX_CACHED = 256;
+
+    static FiberStackPool& instance();
+
+    ~FiberStackPool();
+
+    /* Throws std::system_error when the mapping fails */
+    FiberStack acquire(size_t usable_size = DEFAULT_STACK_SIZE);
+    void release(FiberStack stack);
+
+    size_t cached() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<FiberStack> free_;
+};
+
+/*
+ * Stackful coroutine on a pooled stack, for handler code written in
+ * blocking style. A fiber runs on whichever worker resumes it; when it
+ * parks (this_fiber::sleepFor, read, write) the worker goes back to its
+ * queue and a wake-up posts the fiber to the pool it was started on.
+ *
+ * Code on a fiber may migrate between threads at every park, so it must
+ * not keep references to thread_local state across one.
+ */
+class Fiber {
+public:
+    /* Run fn on a new fiber now, on this thread, until it first parks or finishes */
+    static void start(TaskSlot fn, size_t stack_size = FiberStackPool::DEFAULT_STACK_SIZE);
+
+    /* The fiber running on this thread, or nullptr */
+    static Fiber* current();
+
+    /*
+     * Switch off this fiber. arm runs on the resuming thread once the switch
+     * is complete, so it may hand the fiber to something that wakes it at
+     * once; the wake-up is wake().
+     */
+    void park(TaskSlot arm);
+    /* Make a parked fiber runnable again; safe from any thread */
+    void wake();
+
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+private:
+    Fiber(TaskSlot fn, FiberStack stack, ThreadPool* pool);
+    ~Fiber();
+
+    static void trampoline(unsigned int high, unsigned int low);
+    void resume();
+
+    TaskSlot fn_;
+    FiberStack stack_;
+    ThreadPool* pool_;      /* Where wake() posts; nullptr resumes on the waking thread */
+    ucontext_t context_;
+    ucontext_t caller_;     /* Whoever resumed us last */
+    TaskSlot arm_;          /* Pending park registration */
+    bool finished_ = false;
+};
+
+/* Blocking-style calls that park the calling fiber; outside a fiber they simply block */
+namespace this_fiber {
+
+void sleepUntil(std::chrono::steady_clock::time_point deadline);
+
+template <typename Rep, typename Period>
+void sleepFor(std::chrono::duration<Rep, Period> delay) {
+    sleepUntil(std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay));
+}
+
+/* Requeue behind the work already waiting on this pool */
+void yield();
+
+/* read(2)/write(2) on a non-blocking descriptor, parking while it would block */
+ssize_t read(int fd, void* buffer, size_t length);
+ssize_t write(int fd, const void* buffer, size_t length);
+
+} // namespace this_fiber
+
+/*
+ * Run a route handler on a fiber. The response is deferred until the
+ * handler returns; an exception becomes a 500.
+ */
+HandlerFunc fiberHandler(HandlerFunc handler, size_t stack_size = FiberStackPool::DEFAULT_STACK_SIZE);
+
+} /* namespace Gecko */
+
+#endif /* FIBER_HPP */
@@ -0,0 +1,347 @@
+#include "file_response.hpp"
+#include "header_text.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+
+namespace Gecko {
+
+namespace {
+
+using detail::trim;
+
+constexpr std::string_view BYTES_UNIT = "bytes=";
+
+bool parseSize(std::string_view text, size_t& out) {
+    if (text.empty()) return false;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && end == text.data() + text.size();
+}
+
+std::string_view opaqueTag(std::string_view etag) {
+    etag = trim(etag);
+    if (etag.size() >= 2 && etag[0] == 'W' && etag[1] == '/') etag.remove_prefix(2);
+    return etag;
+}
+
+const HttpHeaderMap::mapped_type* findHeader(const HttpRequest& request, const char* key) {
+    const auto& headers = request.getHeaders();
+    auto it = headers.find(key);
+    return it == headers.end() ? nullptr : &it->second;
+}
+
+/* If-Range holds either a strong ETag or the exact Last-Modified date */
+bool ifRangeMatches(std::string_view value, std::string_view etag, time_t last_modified) {
+    value = trim(value);
+    if (!value.empty() && (value.front() == '"' || value.rfind("W/", 0) == 0)) {
+        return value.front() == '"' && !etag.empty() && etag.front() == '"' && value == etag;
+    }
+    time_t date = parseHttpDate(value);
+    return date >= 0 && date == last_modified;
+}
+
+std::string multipartBoundary() {
+    thread_local std::mt19937_64 generator{std::random_device{}()};
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "gecko%016llx",
+                               static_cast<unsigned long long>(generator()));
+    return std::string(buffer, static_cast<size_t>(length));
+}
+
+std::string contentRange(const ByteRange& range, size_t size) {
+    return "bytes " + std::to_string(range.offset) + "-" +
+        std::to_string(range.offset + range.length - 1) + "/" + std::to_string(size);
+}
+
+BodySegment sliceOf(const BodySource& body, const ByteRange& range) {
+    if (body.file) {
+        return FileSegment{body.file, static_cast<off_t>(range.offset), range.length};
+    }
+    return std::string(body.memory->substr(range.offset, range.length));
+}
+
+} // namespace
+
+ConditionalResult parseRangeHeader(std::string_view value, size_t size) {
+    using Outcome = ConditionalResult::Outcome;
+    ConditionalResult result;
+    value = trim(value);
+    if (value.rfind(BYTES_UNIT, 0) != 0) {
+        return result;  /* Unknown unit: ignore the header */
+    }
+    value.remove_prefix(BYTES_UNIT.size());
+
+    size_t specs = 0;
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        std::string_view spec = trim(value.substr(0, comma));
+        value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+        if (spec.empty()) continue;
+        if (++specs > MAX_BYTE_RANGES) {
+            return ConditionalResult{};
+        }
+
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos) return ConditionalResult{};
+        std::string_view first_text = spec.substr(0, dash);
+        std::string_view last_text = spec.substr(dash + 1);
+
+        size_t first = 0;
+        size_t last = 0;
+        if (first_text.empty()) {
+            /* Suffix range: the final N bytes */
+            size_t suffix = 0;
+            if (!parseSize(last_text, suffix)) return ConditionalResult{};
+            if (suffix == 0 || size == 0) continue;
+            first = size - std::min(suffix, size);
+            last = size - 1;
+        } else {
+            if (!parseSize(first_text, first)) return ConditionalResult{};
+            if (last_text.empty()) {
+                last = size == 0 ? 0 : size - 1;
+            } else if (!parseSize(last_text, last) || last < first) {
+                return ConditionalResult{};
+            }
+            if (first >= size) continue;
+            last = std::min(last, size - 1);
+        }
+        result.ranges.push_back(ByteRange{first, last - first + 1});
+    }
+
+    if (specs == 0) {
+        return ConditionalResult{};
+    }
+    if (result.ranges.empty()) {
+        result.outcome = Outcome::UNSATISFIABLE;
+        return result;
+    }
+
+    std::sort(result.ranges.begin(), result.ranges.end(),
+              [](const ByteRange& a, const ByteRange& b) { return a.offset < b.offset; });
+    std::vector<ByteRange> merged;
+    for (const auto& range : result.ranges) {
+        if (!merged.empty() && range.offset <= merged.back().offset + merged.back().length) {
+            size_t end = std::max(merged.back().offset + merged.back().length, range.offset + range.length);
+            merged.back().length = end - merged.back().offset;
+        } else {
+            merged.push_back(range);
+        }
+    }
+    result.ranges = std::move(merged);
+    result.outcome = Outcome::PARTIAL;
+    return result;
+}
+
+bool etagMatchesAny(std::string_view header_list, std::string_view etag) {
+    if (trim(header_list) == "*") return true;
+    std::string_view wanted = opaqueTag(etag);
+    if (wanted.empty()) return false;
+    while (!header_list.empty()) {
+        size_t comma = header_list.find(',');
+        if (opaqueTag(header_list.substr(0, comma)) == wanted) return true;
+        header_list = comma == std::string_view::npos ? std::string_view() : header_list.substr(comma + 1);
+    }
+    return false;
+}
+
+ConditionalResult evaluateConditional(const HttpRequest& request, std::string_view etag,
+                                      time_t last_modified, size_t size) {
+    using Outcome = ConditionalResult::Outcome;
+    HttpMethod method = request.getMethod();
+    if (method != HttpMethod::GET && method != HttpMethod::HEAD) {
+        return ConditionalResult{};
+    }
+
+    /* If-Modified-Since only counts when there is no If-None-Match */
+    if (const auto* if_none_match = findHeader(request, "If-None-Match")) {
+        if (etagMatchesAny(*if_none_match, etag)) {
+            return ConditionalResult{Outcome::NOT_MODIFIED, {}};
+        }
+    } else if (const auto* if_modified_since = findHeader(request, "If-Modified-Since")) {
+        time_t since = parseHttpDate(*if_modified_since);
+        if (since >= 0 && last_modified <= since) {
+            return ConditionalResult{Outcome::NOT_MODIFIED, {}};
+        }
+    }
+
+    /* Range is only defined for GET */
+    const auto* range = findHeader(request, "Range");
+    if (!range || method != HttpMethod::GET) {
+        return ConditionalResult{};
+    }
+    if (const auto* if_range = findHeader(request, "If-Range")) {
+        if (!ifRangeMatches(*if_range, etag, last_modified)) {
+            return ConditionalResult{};
+        }
+    }
+    return parseRangeHeader(*range, size);
+}
+
+void applyConditional(const HttpRequest& request, HttpResponse& response,
+                      const ConditionalResult& result, const BodySource& body,
+                      std::string_view content_type) {
+    using Outcome = ConditionalResult::Outcome;
+    bool head = request.getMethod() == HttpMethod::HEAD;
+    size_t size = body.size();
+
+    switch (result.outcome) {
+        case Outcome::NOT_MODIFIED:
+            response.setStatusCode(304);
+            return;
+
+        case Outcome::UNSATISFIABLE:
+            response.setStatusCode(416);
+            response.addHeader("Content-Range", "bytes */" + std::to_string(size));
+            return;
+
+        case Outcome::FULL:
+            response.setStatusCode(200);
+            if (head) {
+                response.addHeader("Content-Length", std::to_string(size));
+            } else if (body.file) {
+                response.appendFile(body.file, 0, size);
+            } else if (body.memory) {
+                response.appendBody(body.memory);
+            }
+            return;
+
+        case Outcome::PARTIAL:
+            break;
+    }
+
+    response.setStatusCode(206);
+    if (result.ranges.size() == 1) {
+        const ByteRange& range = result.ranges.front();
+        response.addHeader("Content-Range", contentRange(range, size));
+        if (head) {
+            response.addHeader("Content-Length", std::to_string(range.length));
+        } else {
+            response.appendSegment(sliceOf(body, range));
+        }
+        return;
+    }
+
+    /* multipart/byteranges: part headers inline, part bodies as file ranges */
+    std::string boundary = multipartBoundary();
+    response.addHeader("Content-Type", "multipart/byteranges; boundary=" + boundary);
+    std::vector<BodySegment> parts;
+    size_t length = 0;
+    for (size_t i = 0; i < result.ranges.size(); ++i) {
+        const ByteRange& range = result.ranges[i];
+        std::string part_head = i == 0 ? "--" : "\r\n--";
+        part_head += boundary;
+        part_head += "\r\nContent-Type: ";
+        part_head.append(content_type);
+        part_head += "\r\nContent-Range: ";
+        part_head += contentRange(range, size);
+        part_head += "\r\n\r\n";
+        length += part_head.size() + range.length;
+        parts.emplace_back(std::move(part_head));
+        if (!head) {
+            parts.push_back(sliceOf(body, range));
+        }
+    }
+    std::string closing = "\r\n--" + boundary + "--\r\n";
+    length += closing.size();
+    parts.emplace_back(std::move(closing));
+
+    if (head) {
+        response.addHeader("Content-Length", std::to_string(length));
+        return;
+    }
+    for (auto& part : parts) {
+        response.appendSegment(std::move(part));
+    }
+}
+
+void sendFile(const HttpRequest& request, HttpResponse& response,
+              std::shared_ptr<const FileHandle> file, std::string_view content_type) {
+    std::string etag = entityTag(*file);
+    response.addHeader("Content-Type", std::string(content_type));
+    response.addHeader("Last-Modified", httpDate(file->mtime()));
+    response.addHeader("ETag", etag);
+    response.addHeader("Accept-Ranges", "bytes");
+    ConditionalResult result = evaluateConditional(request, etag, file->mtime(), file->size());
+    applyConditional(request, response, result, BodySource{std::move(file), nullptr}, content_type);
+}
+
+time_t parseHttpDate(std::string_view value) {
+    std::string text(trim(value));
+    struct tm tm_buf{};
+    const char* end = strptime(text.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm_buf);
+    if (!end || *end != '\0') {
+        return -1;
+    }
+    return timegm(&tm_buf);
+}
+
+std::string_view mimeType(std::string_view path) {
+    static const std::unordered_map<std::string_view, std::string_view> types = {
+        {"html", "text/html; charset=utf-8"},
+        {"htm", "text/html; charset=utf-8"},
+        {"css", "text/css; charset=utf-8"},
+        {"js", "text/javascript; charset=utf-8"},
+        {"mjs", "text/javascript; charset=utf-8"},
+        {"json", "application/json"},
+        {"map", "application/json"},
+        {"txt", "text/plain; charset=utf-8"},
+        {"csv", "text/csv; charset=utf-8"},
+        {"md", "text/markdown; charset=utf-8"},
+        {"xml", "application/xml"},
+        {"svg", "image/svg+xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"avif", "image/avif"},
+        {"ico", "image/x-icon"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},
+        {"wasm", "application/wasm"},
+        {"pdf", "application/pdf"},
+        {"zip", "application/zip"},
+        {"gz", "application/gzip"},
+        {"mp4", "video/mp4"},
+        {"webm", "video/webm"},
+        {"mp3", "audio/mpeg"},
+    };
+
+    size_t slash = path.rfind('/');
+    size_t dot = path.rfind('.');
+    if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) {
+        return "application/octet-stream";
+    }
+    std::string extension(path.substr(dot + 1));
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    auto it = types.find(extension);
+    return it == types.end() ? std::string_view("application/octet-stream") : it->second;
+}
+
+std::string entityTag(const FileHandle& file, std::string_view encoding) {
+    char buffer[64];
+    int length = std::snprintf(buffer, sizeof(buffer), "\"%llx-%zx",
+                               static_cast<unsigned long long>(file.mtime()), file.size());
+    std::string tag(buffer, static_cast<size_t>(length));
+    if (!encoding.empty()) {
+        tag += '-';
+        tag.append(encoding);
+    }
+    tag += '"';
+    return tag;
+}
+
+std::string httpDate(time_t time) {
+    struct tm tm_buf;
+    gmtime_r(&time, &tm_buf);
+    char buffer[64];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm_buf);
+    return std::string(buffer, length);
+}
+
+} /* namespace Gecko */
@@ -0,0 +1,77 @@
+#ifndef FILE_RESPONSE_HPP
+#define FILE_RESPONSE_HPP
+
+#include "body_segment.hpp"
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Gecko {
+
+/* More ranges than this in one request are answered with the whole body */
+constexpr size_t MAX_BYTE_RANGES = 32;
+
+struct ByteRange {
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+/*
+ * What a GET or HEAD gets for a representation once If-None-Match,
+ * If-Modified-Since, Range and If-Range have been weighed.
+ */
+struct ConditionalResult {
+    enum class Outcome { FULL, NOT_MODIFIED, PARTIAL, UNSATISFIABLE };
+
+    Outcome outcome = Outcome::FULL;
+    std::vector<ByteRange> ranges;  /* PARTIAL only; sorted, overlaps coalesced */
+};
+
+/* Bytes of a representation: a file sent with sendfile, or a shared buffer */
+struct BodySource {
+    std::shared_ptr<const FileHandle> file;
+    std::shared_ptr<const std::string> memory;
+
+    size_t size() const { return file ? file->size() : (memory ? memory->size() : 0); }
+};
+
+/* "bytes=" ranges satisfiable within size; UNSATISFIABLE if none is, FULL if the value is invalid */
+ConditionalResult parseRangeHeader(std::string_view value, size_t size);
+
+/* Weak comparison against an If-None-Match list ("*" matches anything) */
+bool etagMatchesAny(std::string_view header_list, std::string_view etag);
+
+ConditionalResult evaluateConditional(const HttpRequest& request, std::string_view etag,
+                                      time_t last_modified, size_t size);
+
+/*
+ * Status, framing and body for result. Representation headers (Content-Type,
+ * ETag, Accept-Ranges, ...) are the caller's; a multi-range 206 replaces
+ * Content-Type with multipart/byteranges and repeats content_type in each
+ * part. File ranges are sent with sendfile at their offsets. HEAD gets the
+ * headers only.
+ */
+void applyConditional(const HttpRequest& request, HttpResponse& response,
+                      const ConditionalResult& result, const BodySource& body,
+                      std::string_view content_type);
+
+/* Whole file response with validators, conditional and range handling */
+void sendFile(const HttpRequest& request, HttpResponse& response,
+              std::shared_ptr<const FileHandle> file, std::string_view content_type);
+
+/* Content-Type for a file name, application/octet-stream when unknown */
+std::string_view mimeType(std::string_view path);
+/* Strong validator from mtime and size, e.g. "5f1c2a-1e4"; encoded variants get a suffix */
+std::string entityTag(const FileHandle& file, std::string_view encoding = {});
+/* IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"; parse returns -1 on other formats */
+std::string httpDate(time_t time);
+time_t parseHttpDate(std::string_view value);
+
+} /* namespace Gecko */
+
+#endif /* FILE_RESPONSE_HPP */
@@ -0,0 +1,28 @@
+#ifndef HEADER_TEXT_HPP
+#define HEADER_TEXT_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+namespace Gecko {
+namespace detail {
+
+/* Field names and tokens such as "close" or "gzip" compare case-insensitively */
+inline bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return lhs.size() == rhs.size() &&
+        std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                   [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); });
+}
+
+/* Strip optional whitespace (SP / HTAB) around a field value or list element */
+inline std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+    return value;
+}
+
+} // namespace detail
+} // namespace Gecko
+
+#endif /* HEADER_TEXT_HPP */
@@ -78,34 +78,32 @@ auto HttpVersionToString(HttpVersion version) -> std::string {
 HttpRequest::HttpRequest()
 : method(HttpMethod::UNKNOWN), version(HttpVersion::UNKNOWN) {}
 
+HttpRequest::HttpRequest(std::pmr::memory_resource* resource)
+: method(HttpMethod::UNKNOWN), version(HttpVersion::UNKNOWN),
+  headers(resource), query_params(resource) {}
+
 HttpRequest::HttpRequest(std::string request) {
     HttpRequestParser::parse(request, this);
 }
 
-HttpRequest::HttpRequest(const HttpRequest &other) {
-    method = other.method;
-    url = other.url;
-    version = other.version;
-    headers = other.headers;
-    body = other.body;
-    query_params = other.query_params;
-}
+HttpRequest::HttpRequest(const HttpRequest &other)
+    : method(other.method), url(other.url), version(other.version),
+      headers(other.headers, std::pmr::get_default_resource()), body(other.body),
+      query_params(other.query_params, std::pmr::get_default_resource()) {}
 
-HttpRequest::HttpRequest(HttpRequest &&other) {
-    method = std::move(other.method);
-    url = std::move(other.url);
-    version = std::move(other.version);
-    headers = std::move(other.headers);
-    body = std::move(other.body);
-    query_params = std::move(other.query_params);
-}
+HttpRequest::HttpRequest(HttpRequest &&other)
+    : method(other.method), url(std::move(other.url)), version(other.version),
+      headers(std::move(other.headers), std::pmr::get_default_resource()), body(std::move(other.body)),
+      query_params(std::move(other.query_params), std::pmr::get_default_resource()) {}
 
 HttpRequest::HttpRequest(HttpMethod method, HttpUrl url, HttpVersion version, 
                         HttpHeaderMap headers, HttpBody body)
-    : method(method), url(url), version(version), headers(headers), body(body) {
+    : method(method), url(url), version(version),
+      headers(std::move(headers), std::pmr::get_default_resource()), body(body) {
     parseQueryParams();
 }
 
+/* pmr containers never propagate their allocator on assignment: the maps stay on this request's resource */
 HttpRequest &HttpRequest::operator=(const HttpRequest &other) {
     method = other.method;
     url = other.url;
@@ -117,15 +115,24 @@ HttpRequest &HttpRequest::operator=(const HttpRequest &other) {
 }
 
 HttpRequest &HttpRequest::operator=(HttpRequest &&other) {
-    method = std::move(other.method);
+    method = other.method;
     url = std::move(other.url);
-    version = std::move(other.version);
+    version = other.version;
     headers = std::move(other.headers);
     body = std::move(other.body);
     query_params = std::move(other.query_params);
     return *this;
 }
 
+void HttpRequest::reset() {
+    method = HttpMethod::UNKNOWN;
+    url.clear();
+    version = HttpVersion::UNKNOWN;
+    headers.clear();
+    body.clear();
+    query_params.clear();
+}
+
 void HttpRequest::parseQueryParams() {
     query_params.clear();
     size_t query_start = url.find('?');
@@ -140,12 +147,13 @@ void HttpRequest::parseQueryParams() {
         if (param.empty()) continue;
         size_t eq_pos = param.find('=');
         if (eq_pos == std::string::npos) {
-            query_params[param] = "";
+            query_params.insert_or_assign(HttpQueryMap::key_type(param, query_params.get_allocator()), "");
         } else {
             std::string key = param.substr(0, eq_pos);
             std::string value = param.substr(eq_pos + 1);
             /* Example: /search?q=hello%20world yields "q" -> "hello world" */
-            query_params[key] = urlDecode(value);
+            query_params.insert_or_assign(HttpQueryMap::key_type(key, query_params.get_allocator()),
+                                          urlDecode(value));
         }
     }
 }
@@ -213,14 +221,14 @@ void HttpRequestParser::parse(std::string originRequestString,
         std::string value = header_line.substr(colon_pos + 1);
         trim(key);
         trim(value);
-        headers[key] = value;
+        headers.insert_or_assign(HttpHeaderMap::key_type(key), value);
     }
 
     size_t body_start = headers_end + double_crlf.length();
     auto it = headers.find("Content-Length");
     if (it != headers.end()) {
         try {
-            int content_length = std::stoi(it->second);
+            int content_length = std::stoi(std::string(it->second));
             if (content_length > 0) {
                 if (originRequestString.length() >= body_start + content_length) {
                     httpRequest->body =
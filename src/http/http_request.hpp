@@ -1,8 +1,11 @@
 #ifndef HTTP_REQUEST
 #define HTTP_REQUEST
 #include <algorithm>
+#include <cctype>
 #include <map>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 
 namespace Gecko {
 
@@ -16,25 +19,43 @@ enum class HttpVersion { HTTP_1_0, HTTP_1_1, UNKNOWN };
 auto stringToHttpVersion(std::string version) -> HttpVersion;
 auto HttpVersionToString(HttpVersion version) -> std::string;
 
+/* Transparent, so lookups by std::string, std::string_view or literal build no key */
 struct CaseInsensitiveCompare {
-    bool operator()(const std::string &a, const std::string &b) const {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const {
         return std::lexicographical_compare(
             a.begin(), a.end(), b.begin(), b.end(),
-            [](char ca, char cb) { return std::tolower(ca) < std::tolower(cb); });
+            [](unsigned char ca, unsigned char cb) { return std::tolower(ca) < std::tolower(cb); });
     }
 };
 
+/*
+ * Request-scoped maps are PMR throughout: nodes, keys and values all come
+ * from the map's resource, so an arena-backed request allocates nothing
+ * from the global heap for its headers and query. Keys and values are
+ * std::pmr::string; code that needs a std::string copies explicitly, e.g.
+ * std::string(headers.at("Host")).
+ */
 using HttpHeaderMap =
-std::map<std::string, std::string, CaseInsensitiveCompare>;
+std::pmr::map<std::pmr::string, std::pmr::string, CaseInsensitiveCompare>;
 using HttpUrl = std::string;
 using HttpBody = std::string;
-using HttpQueryMap = std::map<std::string, std::string>;
+using HttpQueryMap = std::pmr::map<std::pmr::string, std::pmr::string, std::less<>>;
 
 class HttpRequest {
 public:
     friend class HttpRequestParser;
+    friend class HttpRequestAdapter;
     HttpRequest();
+    /* Header and query maps allocate from the given resource */
+    explicit HttpRequest(std::pmr::memory_resource* resource);
     HttpRequest(std::string);
+    /*
+     * Copies and moves construct on the default resource: a request taken
+     * out of a context never keeps pointing into that context's arena.
+     * Assignment keeps the target's resource and re-allocates the maps
+     * there when the source lives on a different one.
+     */
     HttpRequest(const HttpRequest &other);
     HttpRequest(HttpRequest &&other);
     HttpRequest(HttpMethod, HttpUrl, HttpVersion, HttpHeaderMap, HttpBody);
@@ -42,6 +63,9 @@ public:
     HttpRequest &operator=(const HttpRequest &other);
     HttpRequest &operator=(HttpRequest &&other);
 
+    /* Resource the header and query maps allocate from */
+    std::pmr::memory_resource* resource() const { return headers.get_allocator().resource(); }
+
     HttpMethod getMethod() const { return method; }
     HttpUrl getUrl() const { return url; }
     const HttpVersion& getVersion() const { return version; }
@@ -63,11 +87,14 @@ public:
     /* void setBody(HttpBody body) { this->body = body; } */
     void setBody(const HttpBody &body) { this->body = body; }
     void setBody(HttpBody &&body) { this->body = std::move(body); }
-    std::string getQueryParam(const std::string& key) const {
+    std::string getQueryParam(std::string_view key) const {
         auto it = query_params.find(key);
-        return it != query_params.end() ? it->second : "";
+        return it != query_params.end() ? std::string(it->second) : std::string();
     }
 
+    /* Clear for reuse; keeps string capacity */
+    void reset();
+
 private:
     HttpMethod method;
     HttpUrl url;
@@ -1,96 +1,286 @@
 #include "http_response.hpp"
+#include "header_text.hpp"
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
 #include <string_view>
 #include <stdexcept>
 #include <cstring>
 
 namespace Gecko {
 
+namespace {
+
+using detail::equalsIgnoreCase;
+
+constexpr int MIN_STATUS_CODE = 100;
+constexpr int MAX_STATUS_CODE = 599;
+constexpr size_t STATUS_CODE_COUNT = MAX_STATUS_CODE - MIN_STATUS_CODE + 1;
+
+constexpr std::string_view CRLF = "\r\n";
+constexpr std::string_view HEADER_SEPARATOR = ": ";
+constexpr std::string_view CONTENT_LENGTH_PREFIX = "Content-Length: ";
+constexpr std::string_view KEEP_ALIVE_LINES = "Connection: keep-alive\r\nKeep-Alive: timeout=30, max=100\r\n";
+constexpr std::string_view CLOSE_LINE = "Connection: close\r\n";
+
+/* "HTTP/1.x <code> <reason>\r\n" for every listed code, built once */
+struct StatusLineTable {
+    std::array<std::string, STATUS_CODE_COUNT> http_1_0;
+    std::array<std::string, STATUS_CODE_COUNT> http_1_1;
+
+    StatusLineTable() {
+        for (const auto& [code, reason] : statusCodeMap) {
+            if (code < MIN_STATUS_CODE || code > MAX_STATUS_CODE) continue;
+            std::string tail = " " + std::to_string(code) + " " + reason + "\r\n";
+            http_1_0[code - MIN_STATUS_CODE] = "HTTP/1.0" + tail;
+            http_1_1[code - MIN_STATUS_CODE] = "HTTP/1.1" + tail;
+        }
+    }
+
+    std::string_view lookup(HttpVersion version, int code) const {
+        if (code < MIN_STATUS_CODE || code > MAX_STATUS_CODE) return {};
+        switch (version) {
+            case HttpVersion::HTTP_1_0: return http_1_0[code - MIN_STATUS_CODE];
+            case HttpVersion::HTTP_1_1: return http_1_1[code - MIN_STATUS_CODE];
+            default: return {};
+        }
+    }
+};
+
+const StatusLineTable& statusLines() {
+    static const StatusLineTable table;
+    return table;
+}
+
+size_t decimalLength(size_t value) {
+    size_t length = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++length;
+    }
+    return length;
+}
+
+/* Connection headers in the map are replaced by the serializer's own */
+bool isConnectionHeader(std::string_view key) {
+    return key.size() == 10 &&
+        (equalsIgnoreCase(key, "Connection") || equalsIgnoreCase(key, "Keep-Alive"));
+}
+
+/* A body framed by Transfer-Encoding must not also get a Content-Length */
+bool isFramingHeader(std::string_view key) {
+    return equalsIgnoreCase(key, "Content-Length") || equalsIgnoreCase(key, "Transfer-Encoding");
+}
+
+inline char* put(char* out, std::string_view data) {
+    std::memcpy(out, data.data(), data.size());
+    return out + data.size();
+}
+
+} // namespace
+
+/* Reformatted at most once per second per thread */
+std::string_view currentDateLine() {
+    static constexpr const char* DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static constexpr const char* MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                             "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    thread_local std::time_t cached_second = -1;
+    thread_local char line[64];
+    thread_local size_t line_length = 0;
+
+    std::time_t now = std::time(nullptr);
+    if (now != cached_second) {
+        std::tm tm{};
+        gmtime_r(&now, &tm);
+        int written = std::snprintf(line, sizeof(line), "Date: %s, %02d %s %04d %02d:%02d:%02d GMT\r\n",
+                                    DAYS[tm.tm_wday], tm.tm_mday, MONTHS[tm.tm_mon], tm.tm_year + 1900,
+                                    tm.tm_hour, tm.tm_min, tm.tm_sec);
+        line_length = written > 0 ? static_cast<size_t>(written) : 0;
+        cached_second = now;
+    }
+    return std::string_view(line, line_length);
+}
+
+std::string_view connectionHeaderLines(ConnectionHeader connection) {
+    switch (connection) {
+        case ConnectionHeader::KEEP_ALIVE: return KEEP_ALIVE_LINES;
+        case ConnectionHeader::CLOSE: return CLOSE_LINE;
+        default: return {};
+    }
+}
+
+std::string_view canonicalReasonPhrase(int statusCode) {
+    auto it = statusCodeMap.find(statusCode);
+    return it != statusCodeMap.end() ? std::string_view(it->second) : std::string_view("Unknown");
+}
+
 HttpResponse HttpResponse::stockResponse(int statusCode) {
     HttpResponse response;
     response.setVersion(HttpVersion::HTTP_1_1);  /* Default to HTTP/1.1 */
-    response.setStatusCode(statusCode);
-    
-    /* Use iterator to avoid redundant map lookups */
-    auto it = statusCodeMap.find(statusCode);
-    if (it != statusCodeMap.end()) {
-        response.setReasonPhrase(it->second);  /* Copy is unavoidable here */
-    } else {
-        response.setReasonPhrase("Unknown");
-    }
+    response.setStatusCode(statusCode);  /* Reason phrase derives from the code */
     return response;
 }
 
+void HttpResponse::reset() {
+    version = HttpVersion::HTTP_1_1;
+    statusCode = 200;
+    reasonPhrase.clear();
+    headers.clear();
+    headerBlock.reset();
+    body.clear();
+    segments.clear();
+}
+
+size_t HttpResponse::getBodyLength() const {
+    size_t length = body.length();
+    for (const auto& segment : segments) {
+        length += segmentLength(segment);
+    }
+    return length;
+}
+
+std::string_view HttpResponse::flattenBody() {
+    if (segments.empty()) {
+        return body;
+    }
+    size_t inline_length = body.length();
+    body.resize(getBodyLength());
+    char* out = body.data() + inline_length;
+    try {
+        for (const auto& segment : segments) {
+            out = copySegment(segment, out);
+        }
+    } catch (...) {
+        body.resize(inline_length);
+        throw;
+    }
+    segments.clear();
+    return body;
+}
+
 /* TODO: optimize performance */
 void HttpResponse::addHeader(const std::string &key, const std::string &value,
                              bool overwrite) {
-    if (!overwrite && headers.find(key) != headers.end()) {
+    auto it = headers.find(key);
+    if (it == headers.end()) {
+        headers.emplace(key, value);
+        return;
+    }
+    if (!overwrite) {
         throw std::invalid_argument(
             "Header already exists and overwrite is disabled");
     }
-    headers[key] = value;
+    it->second = value;
 }
 
-/* Estimate serialized size */
-size_t HttpResponse::estimateSerializedSize() const {
-    /* HTTP/1.1 200 OK\r\n ~= 15 bytes */
-    size_t size = HttpVersionToString(version).length() + 1 + 
-                  std::to_string(statusCode).length() + 1 + 
-                  reasonPhrase.length() + 2;
-    
-    /* Headers */
-    for (const auto& [key, value] : headers) {
-        size += key.length() + 2 + value.length() + 2; /* key: value\r\n */
+/* Precomputed line when possible, otherwise formatted into scratch */
+std::string_view HttpResponse::statusLine(std::string& scratch) const {
+    if (reasonPhrase.empty()) {
+        std::string_view cached = statusLines().lookup(version, statusCode);
+        if (!cached.empty()) {
+            return cached;
+        }
     }
-    
-    /* Content-Length header if not present */
-    bool has_content_length = headers.find("Content-Length") != headers.end() ||
-                             headers.find("content-length") != headers.end();
-    if (!has_content_length) {
-        size += 16 + std::to_string(body.length()).length() + 2; /* Content-Length: xxx\r\n */
-    }
-    
-    size += 2; /* \r\n separator */
-    size += body.length(); /* Body */
-    
-    /* Add 10% buffer */
-    return size + (size / 10);
-}
-
-/* Serialize directly into a string with preallocation */
-void HttpResponse::serializeTo(std::string& output) const {
-    output.clear();
-    output.reserve(estimateSerializedSize());
-    
-    /* Status line */
-    output += HttpVersionToString(version);
-    output += ' ';
-    output += std::to_string(statusCode);
-    output += ' ';
-    output += reasonPhrase;
-    output += "\r\n";
-    
-    /* Headers via const ref to avoid copies */
-    const auto& headers_ref = headers;
-    bool has_content_length = headers_ref.find("Content-Length") != headers_ref.end() ||
-                             headers_ref.find("content-length") != headers_ref.end();
-    
-    /* Add Content-Length if missing */
+    scratch = HttpVersionToString(version);
+    scratch += ' ';
+    scratch += std::to_string(statusCode);
+    scratch += ' ';
+    scratch += getReasonPhrase();
+    scratch += CRLF;
+    return scratch;
+}
+
+HttpResponse::Head::Head(const HttpResponse& response, ConnectionHeader connection)
+    : connection(connection) {
+    status_line = response.statusLine(scratch);
+    inline_size = status_line.size();
+    for (const auto& [key, value] : response.headers) {
+        if (connection != ConnectionHeader::NONE && isConnectionHeader(key)) continue;
+        has_content_length = has_content_length || isFramingHeader(key);
+        has_date = has_date || equalsIgnoreCase(key, "Date");
+        inline_size += key.length() + HEADER_SEPARATOR.size() + value.length() + CRLF.size();
+    }
+    if (response.headerBlock) {
+        inline_size += response.headerBlock->size();
+    }
+
+    body_length = response.body.length();
+    size_t segment_bytes = 0;
+    for (const auto& segment : response.segments) {
+        segment_bytes += segmentLength(segment);
+    }
+    body_length += segment_bytes;
+
     if (!has_content_length) {
-        output += "Content-Length: ";
-        output += std::to_string(body.length());
-        output += "\r\n";
+        inline_size += CONTENT_LENGTH_PREFIX.size() + decimalLength(body_length) + CRLF.size();
     }
-    
-    for (const auto& [key, value] : headers_ref) {
-        output += key;
-        output += ": ";
-        output += value;
-        output += "\r\n";
+    if (!has_date) {
+        inline_size += currentDateLine().size();
     }
-    
-    output += "\r\n";
-    output += body;
+    inline_size += connectionHeaderLines(connection).size();
+    inline_size += CRLF.size();
+    inline_size += response.body.length();
+    size = inline_size + segment_bytes;
+}
+
+/* Exact serialized size */
+size_t HttpResponse::estimateSerializedSize(ConnectionHeader connection) const {
+    return Head(*this, connection).size;
+}
+
+char* HttpResponse::writeTo(char* out, ConnectionHeader connection) const {
+    return writeTo(out, Head(*this, connection));
+}
+
+char* HttpResponse::writeTo(char* out, const Head& head) const {
+    out = writeInlineTo(out, head);
+    for (const auto& segment : segments) {
+        out = copySegment(segment, out);
+    }
+    return out;
+}
+
+size_t HttpResponse::estimateInlineSize(ConnectionHeader connection) const {
+    return Head(*this, connection).inline_size;
+}
+
+char* HttpResponse::writeInlineTo(char* out, ConnectionHeader connection) const {
+    return writeInlineTo(out, Head(*this, connection));
+}
+
+char* HttpResponse::writeInlineTo(char* out, const Head& head) const {
+    out = put(out, head.status_line);
+    for (const auto& [key, value] : headers) {
+        if (head.connection != ConnectionHeader::NONE && isConnectionHeader(key)) continue;
+        out = put(out, key);
+        out = put(out, HEADER_SEPARATOR);
+        out = put(out, value);
+        out = put(out, CRLF);
+    }
+    if (headerBlock) {
+        out = put(out, *headerBlock);
+    }
+
+    if (!head.has_content_length) {
+        out = put(out, CONTENT_LENGTH_PREFIX);
+        out = std::to_chars(out, out + 20, head.body_length).ptr;
+        out = put(out, CRLF);
+    }
+    if (!head.has_date) {
+        out = put(out, currentDateLine());
+    }
+    out = put(out, connectionHeaderLines(head.connection));
+    out = put(out, CRLF);
+    return put(out, body);
+}
+
+/* Size once, then write straight into the string's buffer */
+void HttpResponse::serializeTo(std::string& output, ConnectionHeader connection) const {
+    Head head(*this, connection);
+    output.resize(head.size);
+    writeTo(output.data(), head);
 }
 
 /* HttpResponseSerializer implementation */
@@ -109,64 +299,11 @@ size_t HttpResponseSerializer::serializeToBuffer(const HttpResponse &response, c
     if (!buffer || buffer_size == 0) {
         return 0;
     }
-    
-    char* current = buffer;
-    char* end = buffer + buffer_size;
-    
-    /* Helper lambda for safe buffer writing */
-    auto safe_write = [&current, end](std::string_view data) -> bool {
-        if (current + data.length() >= end) {
-            return false; /* Buffer overflow */
-        }
-        std::memcpy(current, data.data(), data.length());
-        current += data.length();
-        return true;
-    };
-    
-    /* Status line */
-    std::string version_str = HttpVersionToString(response.getVersion());
-    std::string status_code_str = std::to_string(response.getStatusCode());
-    
-    if (!safe_write(version_str) || 
-        !safe_write(" ") ||
-        !safe_write(status_code_str) ||
-        !safe_write(" ") ||
-        !safe_write(response.getReasonPhrase()) ||
-        !safe_write("\r\n")) {
-        return 0;
-    }
-    
-    /* Headers */
-    const auto& headers = response.getHeaders();
-    bool has_content_length = headers.find("Content-Length") != headers.end() ||
-                             headers.find("content-length") != headers.end();
-    
-    /* Add Content-Length if missing */
-    if (!has_content_length) {
-        std::string content_length_str = std::to_string(response.getBody().length());
-        if (!safe_write("Content-Length: ") ||
-            !safe_write(content_length_str) ||
-            !safe_write("\r\n")) {
-            return 0;
-        }
-    }
-    
-    for (const auto& [key, value] : headers) {
-        if (!safe_write(key) ||
-            !safe_write(": ") ||
-            !safe_write(value) ||
-            !safe_write("\r\n")) {
-            return 0;
-        }
-    }
-    
-    /* Empty line and body */
-    if (!safe_write("\r\n") ||
-        !safe_write(response.getBody())) {
-        return 0;
+    HttpResponse::Head head(response);
+    if (head.size >= buffer_size) {
+        return 0; /* Buffer overflow */
     }
-    
-    return current - buffer;
+    return response.writeTo(buffer, head) - buffer;
 }
 
 } /* namespace Gecko */
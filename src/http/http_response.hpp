@@ -1,8 +1,10 @@
 #ifndef HTTP_RESPONSE
 #define HTTP_RESPONSE
 #include "http_request.hpp"
+#include "body_segment.hpp"
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace Gecko {
 struct HttpResponseSerializer;
@@ -11,6 +13,7 @@ const std::map<int, std::string> statusCodeMap{
     {200, "OK"},
     {201, "Created"},
     {204, "No Content"},
+    {206, "Partial Content"},
     {301, "Moved Permanently"},
     {302, "Found"},
     {304, "Not Modified"},
@@ -20,6 +23,7 @@ const std::map<int, std::string> statusCodeMap{
     {404, "Not Found"},
     {405, "Method Not Allowed"},
     {409, "Conflict"},
+    {416, "Range Not Satisfiable"},
     {500, "Internal Server Error"},
     {501, "Not Implemented"},
     {502, "Bad Gateway"},
@@ -28,16 +32,42 @@ const std::map<int, std::string> statusCodeMap{
     {505, "HTTP Version Not Supported"},
 };
 
+/* Canonical reason phrase for a status code ("Unknown" when unlisted) */
+std::string_view canonicalReasonPhrase(int statusCode);
+
+/* Connection handling appended by the serializer without touching the header map */
+enum class ConnectionHeader {
+    NONE,        /* Emit nothing; use the response's own headers */
+    KEEP_ALIVE,  /* Connection: keep-alive + Keep-Alive parameters */
+    CLOSE        /* Connection: close */
+};
+
+/* Header lines the serializer emits for a connection directive */
+std::string_view connectionHeaderLines(ConnectionHeader connection);
+
+/* "Date: <IMF-fixdate>\r\n" for the current second; valid until the calling thread's next call */
+std::string_view currentDateLine();
+
 class HttpResponse {
 public:
     HttpResponse() = default;
+    /* Headers allocate from the given resource */
+    explicit HttpResponse(std::pmr::memory_resource* resource) : headers(resource) {}
     HttpResponse(const HttpResponse &other) = default;
-    HttpResponse(HttpResponse &&other) = default;
+    /* Moved-to responses never inherit the source's (possibly arena) resource */
+    HttpResponse(HttpResponse &&other)
+        : version(other.version), statusCode(other.statusCode),
+          reasonPhrase(std::move(other.reasonPhrase)),
+          headers(std::move(other.headers), std::pmr::get_default_resource()),
+          headerBlock(std::move(other.headerBlock)),
+          body(std::move(other.body)),
+          segments(std::move(other.segments)) {}
     HttpResponse& operator=(const HttpResponse &other) = default;
     HttpResponse& operator=(HttpResponse &&other) = default;
 
     static auto stockResponse(int statusCode) -> HttpResponse;
     void setVersion(HttpVersion version) { this->version = version; }
+    /* The reason phrase follows the status code unless overridden with setReasonPhrase */
     void setStatusCode(int statusCode) { this->statusCode = statusCode; }
     void setReasonPhrase(const std::string &reasonPhrase) {
         this->reasonPhrase = reasonPhrase;
@@ -45,31 +75,104 @@ public:
     void setReasonPhrase(std::string &&reasonPhrase) {
         this->reasonPhrase = std::move(reasonPhrase);
     }
-    void setBody(const HttpBody &body) { this->body = body; }
-    void setBody(HttpBody &&body) { this->body = std::move(body); }
+    void setBody(const HttpBody &body) {
+        this->body = body;
+        segments.clear();
+    }
+    void setBody(HttpBody &&body) {
+        this->body = std::move(body);
+        segments.clear();
+    }
+    /* Append body segments; shared buffers and file ranges are sent without copying */
+    void appendBody(std::string data) { segments.emplace_back(std::move(data)); }
+    void appendBody(std::shared_ptr<const std::string> data) { segments.emplace_back(std::move(data)); }
+    void appendFile(std::shared_ptr<const FileHandle> file, off_t offset, size_t length) {
+        segments.emplace_back(FileSegment{std::move(file), offset, length});
+    }
+    void appendSegment(BodySegment segment) { segments.push_back(std::move(segment)); }
     void addHeader(const std::string &key, const std::string &value,
                    bool overwrite = true);
+    /*
+     * Pre-serialized "Key: value\r\n" lines written verbatim after the header
+     * map, e.g. built once per cached asset. Not visible through getHeaders().
+     */
+    void setHeaderBlock(std::shared_ptr<const std::string> block) { headerBlock = std::move(block); }
+    const std::shared_ptr<const std::string>& getHeaderBlock() const { return headerBlock; }
+
+    /* Restore the 200 OK defaults for reuse; keeps string capacity */
+    void reset();
 
     /* Return references to avoid copies */
     HttpVersion getVersion() const { return version; }
     int getStatusCode() const { return statusCode; }
-    std::string_view getReasonPhrase() const { return reasonPhrase; }
+    std::string_view getReasonPhrase() const {
+        return reasonPhrase.empty() ? canonicalReasonPhrase(statusCode) : std::string_view(reasonPhrase);
+    }
     const HttpHeaderMap& getHeaders() const { return headers; }  /* Return const reference */
-    std::string_view getBody() const { return body; }  /* Expose via string_view */
+    /* Inline body only; appended segments are not included (see flattenBody) */
+    std::string_view getBody() const { return body; }
+    /*
+     * Copy appended segments into the inline body and return the whole body.
+     * Reads file segments (pread; throws on failure) and gives up zero-copy
+     * and sendfile for this response; meant for tests and transformations
+     * that need contiguous bytes.
+     */
+    std::string_view flattenBody();
+    size_t getBodyLength() const;
+    const std::vector<BodySegment>& getBodySegments() const { return segments; }
+    /* Hand the appended segments to the writer, leaving the inline body */
+    std::vector<BodySegment> takeBodySegments() { return std::move(segments); }
+
+    /*
+     * Status line, header scan and body length of one serialization,
+     * computed once: size the buffer from it, then write with the same Head.
+     * Valid while the response is unchanged.
+     */
+    struct Head {
+        explicit Head(const HttpResponse& response, ConnectionHeader connection = ConnectionHeader::NONE);
+        Head(const Head&) = delete;
+        Head& operator=(const Head&) = delete;
+
+        ConnectionHeader connection;
+        std::string_view status_line;  /* Precomputed, or points into scratch */
+        bool has_content_length = false;
+        bool has_date = false;
+        size_t body_length = 0;
+        size_t inline_size = 0;        /* Head plus inline body */
+        size_t size = 0;               /* inline_size plus appended segments */
 
-    /* Estimate serialized size for preallocation */
-    size_t estimateSerializedSize() const;
+    private:
+        std::string scratch;
+    };
+
+    /* Exact serialized size, used to size the output buffer once */
+    size_t estimateSerializedSize(ConnectionHeader connection = ConnectionHeader::NONE) const;
     
-    /* Serialize into preallocated string */
-    void serializeTo(std::string& output) const;
+    /* Serialize into output, replacing its contents */
+    void serializeTo(std::string& output, ConnectionHeader connection = ConnectionHeader::NONE) const;
+
+    /* Write exactly estimateSerializedSize(connection) bytes at out; returns the end */
+    char* writeTo(char* out, ConnectionHeader connection = ConnectionHeader::NONE) const;
+    /* Write exactly head.size bytes at out */
+    char* writeTo(char* out, const Head& head) const;
+
+    /* Head plus inline body only; appended segments are left for the writer */
+    size_t estimateInlineSize(ConnectionHeader connection = ConnectionHeader::NONE) const;
+    char* writeInlineTo(char* out, ConnectionHeader connection = ConnectionHeader::NONE) const;
+    /* Write exactly head.inline_size bytes at out */
+    char* writeInlineTo(char* out, const Head& head) const;
 
 private:
-    friend class HttpResponseSerializer;
+    friend struct HttpResponseSerializer;
+    std::string_view statusLine(std::string& scratch) const;
+
     HttpVersion version = HttpVersion::HTTP_1_1;  /* Default HTTP/1.1 */
     int statusCode = 200;
-    std::string reasonPhrase = "OK";
+    std::string reasonPhrase;  /* Empty: canonical phrase for statusCode */
     HttpHeaderMap headers;
-    HttpBody body;
+    std::shared_ptr<const std::string> headerBlock;
+    HttpBody body;                      /* Inline body, sent first */
+    std::vector<BodySegment> segments;  /* Appended after body */
 };
 
 struct HttpResponseSerializer {
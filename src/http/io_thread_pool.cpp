@@ -1,18 +1,21 @@
 #include "io_thread_pool.hpp"
+#include "cpu_affinity.hpp"
 #include "server.hpp"
 #include <iostream>
 #include <sys/epoll.h>
 #include <sys/socket.h>
+#include <sys/sendfile.h>
 #include <fcntl.h>
 #include <cerrno>
 #include <cstring>
 #include <unistd.h>
+#include <algorithm>
 #include <charconv>
 #include <string_view>
 
 namespace Gecko {
 
-IOThreadPool::IOThreadPool(size_t io_thread_count) : stop_flag_(false) {
+IOThreadPool::IOThreadPool(size_t io_thread_count, std::vector<int> cpus) : stop_flag_(false) {
     if (io_thread_count == 0) {
         io_thread_count = std::max(4u, std::thread::hardware_concurrency() / 2); // Default to half the CPU cores, at least 4
     }
@@ -37,6 +40,10 @@ IOThreadPool::IOThreadPool(size_t io_thread_count) : stop_flag_(false) {
             throw std::runtime_error("Failed to add wakeup pipe to epoll: " + std::string(strerror(errno)));
         }
         
+        if (!cpus.empty()) {
+            io_thread->cpu = cpus[i % cpus.size()];
+        }
+
         IOThread* thread_ptr = io_thread.get();
         io_thread->thread = std::thread([this, thread_ptr]() {
             io_reactor_loop(*thread_ptr);
@@ -71,18 +78,20 @@ void IOThreadPool::register_read(std::shared_ptr<ConnectionInfo> conn_info,
         return;
     }
     
-    int thread_idx = get_next_thread_index();
-    auto& io_thread = *io_threads_[thread_idx];
+    if (conn_info->io_thread_index < 0) {
+        conn_info->io_thread_index = get_next_thread_index();
+    }
+    auto& io_thread = *io_threads_[conn_info->io_thread_index];
     
     IOEvent event;
     event.fd = conn_info->fd;
     event.operation = IOOperation::READ;
     event.conn_info = conn_info;
-    event.read_callback = callback;
+    event.read_callback = std::move(callback);
     
     {
         std::lock_guard<std::mutex> lock(io_thread.events_mutex);
-        io_thread.pending_events.push(event);
+        io_thread.pending_events.push(std::move(event));
     }
     
     wakeup_thread(io_thread);
@@ -94,6 +103,17 @@ void IOThreadPool::async_write(std::shared_ptr<ConnectionInfo> conn_info, const
 
 void IOThreadPool::async_write(std::shared_ptr<ConnectionInfo> conn_info, const std::string& data, 
                               std::function<void(std::shared_ptr<ConnectionInfo>, bool)> callback) {
+    async_write(std::move(conn_info), PooledBuffer(data), std::move(callback));
+}
+
+void IOThreadPool::async_write(std::shared_ptr<ConnectionInfo> conn_info, PooledBuffer&& data,
+                              std::function<void(std::shared_ptr<ConnectionInfo>, bool)> callback) {
+    async_write(std::move(conn_info), std::move(data), {}, std::move(callback));
+}
+
+void IOThreadPool::async_write(std::shared_ptr<ConnectionInfo> conn_info, PooledBuffer&& data,
+                              std::vector<BodySegment>&& segments,
+                              std::function<void(std::shared_ptr<ConnectionInfo>, bool)> callback) {
     if (stop_flag_ || !conn_info || !conn_info->connected) {
         if (callback) {
             callback(conn_info, false);
@@ -101,24 +121,80 @@ void IOThreadPool::async_write(std::shared_ptr<ConnectionInfo> conn_info, const
         return;
     }
     
-    int thread_idx = get_next_thread_index();
+    /* Writes go to the reactor that owns the fd so EPOLLOUT resumes them */
+    int thread_idx = conn_info->io_thread_index >= 0 ? conn_info->io_thread_index : get_next_thread_index();
     auto& io_thread = *io_threads_[thread_idx];
     
     IOEvent event;
     event.fd = conn_info->fd;
     event.operation = IOOperation::WRITE;
     event.conn_info = conn_info;
-    event.write_data = data;
-    event.write_callback = callback;
+    event.write_data = std::move(data);
+    event.write_segments = std::move(segments);
+    event.write_callback = std::move(callback);
+    
+    {
+        std::lock_guard<std::mutex> lock(io_thread.events_mutex);
+        io_thread.pending_events.push(std::move(event));
+    }
+    
+    wakeup_thread(io_thread);
+}
+
+void IOThreadPool::run_on(const std::shared_ptr<ConnectionInfo>& conn_info, TaskSlot task) {
+    if (stop_flag_ || !conn_info) {
+        return;
+    }
+    
+    int thread_idx = conn_info->io_thread_index >= 0 ? conn_info->io_thread_index : get_next_thread_index();
+    auto& io_thread = *io_threads_[thread_idx];
+    
+    IOEvent event;
+    event.fd = conn_info->fd;
+    event.operation = IOOperation::CALL;
+    event.conn_info = conn_info;
+    event.call = std::move(task);
     
     {
         std::lock_guard<std::mutex> lock(io_thread.events_mutex);
-        io_thread.pending_events.push(event);
+        io_thread.pending_events.push(std::move(event));
     }
     
     wakeup_thread(io_thread);
 }
 
+void IOThreadPool::close_connection(const std::shared_ptr<ConnectionInfo>& conn_info) {
+    if (!conn_info) return;
+    int thread_idx = conn_info->io_thread_index;
+    if (stop_flag_ || thread_idx < 0) {
+        ::close(conn_info->fd);  /* No reactor holds it */
+        return;
+    }
+    auto& io_thread = *io_threads_[thread_idx];
+    if (io_thread.thread.get_id() == std::this_thread::get_id()) {
+        close_on_reactor(io_thread, conn_info);
+        return;
+    }
+    run_on(conn_info, [this, conn_info]() {
+        close_on_reactor(*io_threads_[conn_info->io_thread_index], conn_info);
+    });
+}
+
+void IOThreadPool::close_on_reactor(IOThread& io_thread, const std::shared_ptr<ConnectionInfo>& conn_info) {
+    int fd = conn_info->fd;
+    conn_info->awaiting = false;
+    conn_info->connected = false;
+    auto conn_it = io_thread.connections.find(fd);
+    if (conn_it != io_thread.connections.end() && conn_it->second == conn_info) {
+        io_thread.connections.erase(conn_it);
+        io_thread.read_callbacks.erase(fd);
+    }
+    epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    /* Before the descriptor can be reused: no EPOLLOUT will come for these */
+    fail_queued_writes(io_thread, fd, conn_info);
+    ::close(fd);
+}
+
 void IOThreadPool::unregister_connection(std::shared_ptr<ConnectionInfo> conn_info) {
     if (!conn_info) return;
     
@@ -133,6 +209,14 @@ void IOThreadPool::unregister_connection(std::shared_ptr<ConnectionInfo> conn_in
 }
 
 void IOThreadPool::io_reactor_loop(IOThread& io_thread) {
+    /* Pin before the connection maps and buffer pool are first touched, so they land on this node */
+    if (io_thread.cpu >= 0 && !pin_current_thread(io_thread.cpu)) {
+        std::cerr << "[LOOP] Could not pin IO thread to CPU " << io_thread.cpu << std::endl;
+    }
+    /* Workers were paired with reactors by node: send this reactor's requests to its node's queue */
+    if (io_thread.cpu >= 0) {
+        ThreadPool::set_submitter_node(numa_node_of(io_thread.cpu));
+    }
     const int max_events = 1000;
     struct epoll_event events[max_events];
     
@@ -168,13 +252,23 @@ void IOThreadPool::io_reactor_loop(IOThread& io_thread) {
                 handle_write_ready(io_thread, fd);
             }
             
+            if (events[i].events & EPOLLRDHUP) {
+                /* Peer stopped sending: cancel its in-flight requests, but their answers may still go out */
+                auto conn_it = io_thread.connections.find(fd);
+                if (conn_it != io_thread.connections.end()) {
+                    conn_it->second->awaiting = false;
+                }
+            }
+            
             if (events[i].events & (EPOLLHUP | EPOLLERR)) {
                 auto conn_it = io_thread.connections.find(fd);
                 if (conn_it != io_thread.connections.end()) {
-                    conn_it->second->connected = false;
+                    auto conn_info = conn_it->second;
+                    conn_info->awaiting = false;
+                    conn_info->connected = false;
                     io_thread.connections.erase(conn_it);
                     io_thread.read_callbacks.erase(fd);
-                    io_thread.write_buffers.erase(fd); 
+                    fail_queued_writes(io_thread, fd, conn_info);
                 }
             }
         }
@@ -190,23 +284,33 @@ void IOThreadPool::process_pending_events(IOThread& io_thread) {
     }
     
     while (!events_to_process.empty()) {
-        IOEvent event = events_to_process.front();
+        IOEvent event = std::move(events_to_process.front());
         events_to_process.pop();
         
         if (event.operation == IOOperation::READ) {
-            if (io_thread.connections.find(event.fd) != io_thread.connections.end()) {
+            auto existing = io_thread.connections.find(event.fd);
+            if (existing != io_thread.connections.end() && existing->second == event.conn_info) {
                 io_thread.read_callbacks[event.fd] = event.read_callback;
                 continue;
             }
             
+            /* A descriptor closed behind our back may come back from accept() as a new connection:
+               writes still queued for the old one fail, so whoever waits on them is released */
+            std::shared_ptr<ConnectionInfo> stale;
+            if (existing != io_thread.connections.end()) {
+                stale = existing->second;
+                stale->awaiting = false;
+                stale->connected = false;
+            }
+            fail_queued_writes(io_thread, event.fd, stale);
             io_thread.connections[event.fd] = event.conn_info;
             io_thread.read_callbacks[event.fd] = event.read_callback;
             
             struct epoll_event ev;
-            ev.events = EPOLLIN | EPOLLET;  
+            ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP;
             ev.data.fd = event.fd;
             if (epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_ADD, event.fd, &ev) == -1) {
-                if (errno != EEXIST) {
+                if (errno != EEXIST || epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_MOD, event.fd, &ev) == -1) {
                     std::cerr << "epoll_ctl ADD failed for fd " << event.fd << ": " << strerror(errno) << std::endl;
                     io_thread.connections.erase(event.fd);
                     io_thread.read_callbacks.erase(event.fd);
@@ -215,6 +319,12 @@ void IOThreadPool::process_pending_events(IOThread& io_thread) {
             
         } else if (event.operation == IOOperation::WRITE) {
             handle_write_event(io_thread, event);
+        } else if (event.operation == IOOperation::CALL) {
+            try {
+                event.call();
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR] Reactor task failed: " << e.what() << std::endl;
+            }
         }
     }
 }
@@ -297,8 +407,13 @@ void IOThreadPool::handle_read_event(IOThread& io_thread, int fd) {
                 }
             }
         } else if (bytes_read == 0) {
-            conn_info->connected = false;
-            io_thread.connections.erase(fd);
+            /*
+             * EOF is also what a half-close reads as, so the socket may still
+             * take writes: stop reading and cancel, and leave the rest to the
+             * write path, which fails on a peer that is really gone (then
+             * EPOLLHUP/ERR cleans up) and closes once the last answer is out
+             */
+            conn_info->awaiting = false;
             io_thread.read_callbacks.erase(fd);
             return;
         } else {
@@ -306,16 +421,18 @@ void IOThreadPool::handle_read_event(IOThread& io_thread, int fd) {
                 break;
             } else {
                 std::cerr << "[ERROR] Read error on fd " << fd << ": " << strerror(errno) << std::endl;
+                conn_info->awaiting = false;
                 conn_info->connected = false;
                 io_thread.connections.erase(fd);
                 io_thread.read_callbacks.erase(fd);
+                fail_queued_writes(io_thread, fd, conn_info);
                 return;
             }
         }
     }
 }
 
-void IOThreadPool::handle_write_event(IOThread& io_thread, const IOEvent& event) {
+void IOThreadPool::handle_write_event(IOThread& io_thread, IOEvent& event) {
     auto conn_info = event.conn_info;
     if (!conn_info || !conn_info->connected) {
         if (event.write_callback) {
@@ -325,19 +442,33 @@ void IOThreadPool::handle_write_event(IOThread& io_thread, const IOEvent& event)
     }
     
     auto write_buffer = std::make_shared<WriteBuffer>();
-    write_buffer->data = event.write_data;
-    write_buffer->callback = event.write_callback;
+    write_buffer->data = std::move(event.write_data);
+    write_buffer->segments = std::move(event.write_segments);
+    write_buffer->skip_empty_segments();
+    write_buffer->callback = std::move(event.write_callback);
+    
+    /* Queue behind earlier writes still waiting for EPOLLOUT to keep their order */
+    auto queue_it = io_thread.write_buffers.find(conn_info->fd);
+    if (queue_it != io_thread.write_buffers.end() && !queue_it->second.empty()) {
+        queue_it->second.push_back(std::move(write_buffer));
+        return;
+    }
     
-    if (try_write_immediate(io_thread, conn_info->fd, write_buffer)) {
+    WriteResult result = try_write_immediate(io_thread, *conn_info, write_buffer);
+    if (result == WriteResult::COMPLETE) {
         total_writes_++;
         if (write_buffer->callback) {
             write_buffer->callback(conn_info, true);
         }
+    } else if (result == WriteResult::FAILED) {
+        if (write_buffer->callback) {
+            write_buffer->callback(conn_info, false);
+        }
     } else {
-        io_thread.write_buffers[conn_info->fd] = write_buffer;
+        io_thread.write_buffers[conn_info->fd].push_back(write_buffer);
         
         struct epoll_event ev;
-        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;  
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
         ev.data.fd = conn_info->fd;
         
         if (epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_MOD, conn_info->fd, &ev) == -1) {
@@ -351,56 +482,147 @@ void IOThreadPool::handle_write_event(IOThread& io_thread, const IOEvent& event)
     }
 }
 
-bool IOThreadPool::try_write_immediate(IOThread& io_thread, int fd, std::shared_ptr<WriteBuffer> buffer) {
+IOThreadPool::WriteResult IOThreadPool::try_write_immediate(IOThread& io_thread, ConnectionInfo& conn_info,
+                                                           std::shared_ptr<WriteBuffer> buffer) {
+    int fd = conn_info.fd;
     while (!buffer->is_complete()) {
-        auto remaining = buffer->remaining();
-        ssize_t bytes_sent = write(fd, remaining.data(), remaining.size());
+        ssize_t bytes_sent;
+        if (const FileSegment* file = buffer->pending_file()) {
+            off_t file_offset = file->offset + static_cast<off_t>(buffer->segment_offset);
+            bytes_sent = sendfile(fd, file->file->fd(), &file_offset, file->length - buffer->segment_offset);
+        } else {
+            struct iovec iov[WriteBuffer::MAX_IOVECS];
+            int iov_count = buffer->gather(iov, WriteBuffer::MAX_IOVECS);
+            bytes_sent = writev(fd, iov, iov_count);
+        }
         
         if (bytes_sent > 0) {
-            buffer->offset += bytes_sent;
+            buffer->advance(static_cast<size_t>(bytes_sent));
+            conn_info.update_activity();  /* A long body in flight is not idle: keep the expiry sweep off it */
         } else if (bytes_sent == 0) {
-            return false;
+            return WriteResult::FAILED;
         } else {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                return false;
+            if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return WriteResult::PENDING;  /* Resume on EPOLLOUT */
             } else {
                 std::cerr << "[ERROR] Write error on fd " << fd << ": " << strerror(errno) << std::endl;
-                return false;
+                return WriteResult::FAILED;
             }
         }
     }
-    return true; 
+    return WriteResult::COMPLETE; 
 }
 
-void IOThreadPool::handle_write_ready(IOThread& io_thread, int fd) {
-    auto buffer_it = io_thread.write_buffers.find(fd);
-    if (buffer_it == io_thread.write_buffers.end()) {
-        return; 
+/* WriteBuffer implementation */
+const FileSegment* IOThreadPool::WriteBuffer::pending_file() const {
+    if (offset < data.size() || segment_index >= segments.size()) {
+        return nullptr;
     }
-    
-    auto buffer = buffer_it->second;
+    return std::get_if<FileSegment>(&segments[segment_index]);
+}
+
+int IOThreadPool::WriteBuffer::gather(struct iovec* iov, int max_iov) const {
+    int count = 0;
+    if (offset < data.size()) {
+        iov[count].iov_base = const_cast<char*>(data.data() + offset);
+        iov[count].iov_len = data.size() - offset;
+        count++;
+    }
+    size_t skip = (offset < data.size()) ? 0 : segment_offset;
+    for (size_t i = segment_index; i < segments.size() && count < max_iov; ++i) {
+        if (isFileSegment(segments[i])) break;
+        std::string_view view = segmentView(segments[i]).substr(skip);
+        skip = 0;
+        if (view.empty()) continue;
+        iov[count].iov_base = const_cast<char*>(view.data());
+        iov[count].iov_len = view.size();
+        count++;
+    }
+    return count;
+}
+
+void IOThreadPool::WriteBuffer::advance(size_t bytes) {
+    if (offset < data.size()) {
+        size_t taken = std::min(bytes, data.size() - offset);
+        offset += taken;
+        bytes -= taken;
+    }
+    while (bytes > 0 && segment_index < segments.size()) {
+        size_t left = segmentLength(segments[segment_index]) - segment_offset;
+        size_t taken = std::min(bytes, left);
+        segment_offset += taken;
+        bytes -= taken;
+        if (segment_offset == segmentLength(segments[segment_index])) {
+            segment_index++;
+            segment_offset = 0;
+        }
+    }
+    skip_empty_segments();
+}
+
+void IOThreadPool::WriteBuffer::skip_empty_segments() {
+    while (segment_index < segments.size() && segment_offset == 0 &&
+           segmentLength(segments[segment_index]) == 0) {
+        segment_index++;
+    }
+}
+
+void IOThreadPool::handle_write_ready(IOThread& io_thread, int fd) {
     auto conn_it = io_thread.connections.find(fd);
     if (conn_it == io_thread.connections.end()) {
-        io_thread.write_buffers.erase(buffer_it);
+        fail_queued_writes(io_thread, fd, nullptr);
         return;
     }
-    
     auto conn_info = conn_it->second;
     
-    if (try_write_immediate(io_thread, fd, buffer)) {
-        total_writes_++;
-        io_thread.write_buffers.erase(buffer_it);
-        
-        struct epoll_event ev;
-        ev.events = EPOLLIN | EPOLLET;
-        ev.data.fd = fd;
-        epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    /* Drain in order; callbacks may disconnect, so look the queue up again each round */
+    while (true) {
+        auto queue_it = io_thread.write_buffers.find(fd);
+        if (queue_it == io_thread.write_buffers.end()) {
+            return;
+        }
+        auto& queue = queue_it->second;
+        if (queue.empty()) {
+            io_thread.write_buffers.erase(queue_it);
+            
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP;
+            ev.data.fd = fd;
+            epoll_ctl(io_thread.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+            return;
+        }
         
+        auto buffer = queue.front();
+        WriteResult result = try_write_immediate(io_thread, *conn_info, buffer);
+        if (result == WriteResult::PENDING) {
+            return;  /* Wait for the next EPOLLOUT */
+        }
+        if (result == WriteResult::FAILED) {
+            /* Nothing behind a broken write can reach the peer in order: fail the whole queue.
+               The first completion closes the connection; the rest see it gone. */
+            fail_queued_writes(io_thread, fd, conn_info);
+            return;
+        }
+        queue.pop_front();
+        total_writes_++;
         if (buffer->callback) {
             buffer->callback(conn_info, true);
         }
-    } else {
-        io_thread.write_buffers.erase(buffer_it);
+    }
+}
+
+void IOThreadPool::fail_queued_writes(IOThread& io_thread, int fd,
+                                      const std::shared_ptr<ConnectionInfo>& conn_info) {
+    auto queue_it = io_thread.write_buffers.find(fd);
+    if (queue_it == io_thread.write_buffers.end()) {
+        return;
+    }
+    /* Callbacks may queue more writes for fd; they land in a fresh queue */
+    auto failed = std::move(queue_it->second);
+    io_thread.write_buffers.erase(queue_it);
+    for (const auto& buffer : failed) {
         if (buffer->callback) {
             buffer->callback(conn_info, false);
         }
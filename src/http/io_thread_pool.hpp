@@ -4,6 +4,7 @@
 #include <vector>
 #include <thread>
 #include <queue>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
@@ -12,7 +13,11 @@
 #include <memory>
 #include <unordered_map>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include "body_segment.hpp"
+#include "buffer_pool.hpp"
+#include "task_slot.hpp"
 
 namespace Gecko {
 
@@ -21,7 +26,8 @@ struct ConnectionInfo;
 /* IO operation types */
 enum class IOOperation {
     READ,
-    WRITE
+    WRITE,
+    CALL
 };
 
 /* Simplified IO task */
@@ -29,15 +35,18 @@ struct IOEvent {
     int fd;
     IOOperation operation;
     std::shared_ptr<ConnectionInfo> conn_info;
-    std::string write_data;  /* For write operations */
+    PooledBuffer write_data;  /* For write operations; moved, never copied */
+    std::vector<BodySegment> write_segments;  /* Sent after write_data */
     std::function<void(std::shared_ptr<ConnectionInfo>, const std::string&)> read_callback;
     std::function<void(std::shared_ptr<ConnectionInfo>, bool)> write_callback;
+    TaskSlot call;  /* For CALL: runs on the reactor */
 };
 
 /* Reactor-style async IO thread pool */
 class IOThreadPool {
 public:
-    explicit IOThreadPool(size_t io_thread_count = 2);
+    /* Reactor i is pinned to cpus[i % cpus.size()] when cpus is not empty */
+    explicit IOThreadPool(size_t io_thread_count = 2, std::vector<int> cpus = {});
     ~IOThreadPool();
 
     /* Disable copy/move */
@@ -56,6 +65,21 @@ public:
     /* Async write with completion callback */
     void async_write(std::shared_ptr<ConnectionInfo> conn_info, const std::string& data, 
                     std::function<void(std::shared_ptr<ConnectionInfo>, bool)> callback);
+
+    /* Async write taking ownership of a pooled buffer */
+    void async_write(std::shared_ptr<ConnectionInfo> conn_info, PooledBuffer&& data,
+                    std::function<void(std::shared_ptr<ConnectionInfo>, bool)> callback = nullptr);
+
+    /* Async scatter-gather write: data, then segments via writev/sendfile */
+    void async_write(std::shared_ptr<ConnectionInfo> conn_info, PooledBuffer&& data,
+                    std::vector<BodySegment>&& segments,
+                    std::function<void(std::shared_ptr<ConnectionInfo>, bool)> callback = nullptr);
+    
+    /* Run task on the reactor that owns the connection; dropped once the pool is stopping */
+    void run_on(const std::shared_ptr<ConnectionInfo>& conn_info, TaskSlot task);
+    
+    /* Close the descriptor on its reactor, failing the writes still queued for it first */
+    void close_connection(const std::shared_ptr<ConnectionInfo>& conn_info);
     
     /* Remove connection */
     void unregister_connection(std::shared_ptr<ConnectionInfo> conn_info);
@@ -67,14 +91,26 @@ public:
    void stop();
 
 private:
-    /* Write buffer */
+    /* Write buffer: contiguous data followed by body segments */
     struct WriteBuffer {
-        std::string data;
-        size_t offset = 0;
+        static constexpr int MAX_IOVECS = 64;
+
+        PooledBuffer data;
+        std::vector<BodySegment> segments;
+        size_t offset = 0;          /* Into data */
+        size_t segment_index = 0;   /* First unsent segment once data is drained */
+        size_t segment_offset = 0;  /* Into segments[segment_index] */
         std::function<void(std::shared_ptr<ConnectionInfo>, bool)> callback;
         
-        bool is_complete() const { return offset >= data.length(); }
-        std::string_view remaining() const { return std::string_view(data).substr(offset); }
+        bool is_complete() const { return offset >= data.size() && segment_index >= segments.size(); }
+        std::string_view remaining() const { return data.view().substr(offset); }
+
+        /* Next unsent bytes are a file range */
+        const FileSegment* pending_file() const;
+        /* Fill iov with unsent in-memory bytes up to the next file segment */
+        int gather(struct iovec* iov, int max_iov) const;
+        void advance(size_t bytes);
+        void skip_empty_segments();
     };
 
     /* IO thread data */
@@ -82,11 +118,12 @@ private:
         std::thread thread;
         int epoll_fd;
         int wakeup_fd[2];  /* Pipe to wake epoll */
+        int cpu = -1;      /* Pinned CPU; -1 floats */
         std::mutex events_mutex;
         std::queue<IOEvent> pending_events;
         std::unordered_map<int, std::shared_ptr<ConnectionInfo>> connections;
         std::unordered_map<int, std::function<void(std::shared_ptr<ConnectionInfo>, const std::string&)>> read_callbacks;
-        std::unordered_map<int, std::shared_ptr<WriteBuffer>> write_buffers; /* Pending write buffers */
+        std::unordered_map<int, std::deque<std::shared_ptr<WriteBuffer>>> write_buffers; /* Per-fd FIFO of pending writes */
         std::atomic<bool> running{true};
         
         IOThread() : epoll_fd(-1) {
@@ -103,9 +140,13 @@ private:
     void io_reactor_loop(IOThread& io_thread);
     void process_pending_events(IOThread& io_thread);
     void handle_read_event(IOThread& io_thread, int fd);
-    void handle_write_event(IOThread& io_thread, const IOEvent& event);
+    void handle_write_event(IOThread& io_thread, IOEvent& event);
     void handle_write_ready(IOThread& io_thread, int fd);
-    bool try_write_immediate(IOThread& io_thread, int fd, std::shared_ptr<WriteBuffer> buffer);
+    /* Drop fd's write queue, failing each buffer's callback in order */
+    void fail_queued_writes(IOThread& io_thread, int fd, const std::shared_ptr<ConnectionInfo>& conn_info);
+    void close_on_reactor(IOThread& io_thread, const std::shared_ptr<ConnectionInfo>& conn_info);
+    enum class WriteResult { COMPLETE, PENDING, FAILED };
+    WriteResult try_write_immediate(IOThread& io_thread, ConnectionInfo& conn_info, std::shared_ptr<WriteBuffer> buffer);
     void wakeup_thread(IOThread& io_thread);
     int get_next_thread_index();
     
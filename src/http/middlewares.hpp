@@ -1,6 +1,8 @@
 #ifndef MIDDLEWARES_H
 #define MIDDLEWARES_H
+#include "compression.hpp"
 #include "context.hpp"
+#include "thread_pool.hpp"
 #include "tracing/tracer.hpp"
 #include <memory>
 #include <string>
@@ -19,14 +21,12 @@ public:
     static std::function<void(Context&, std::function<void()>)>
     RequestID(const std::string& header_name = "X-Request-ID") {
         return [header_name](Context& ctx, std::function<void()> next) {
-            std::string request_id;
-            if (ctx.has("request_id")) {
-                request_id = ctx.get<std::string>("request_id");
-            } else {
-                request_id = Tracing::Tracer::generateId();
-                ctx.set("request_id", request_id);
+            const std::string* request_id = ctx.find(ContextKeys::RequestId);
+            if (!request_id) {
+                ctx.set(ContextKeys::RequestId, Tracing::Tracer::generateId());
+                request_id = ctx.find(ContextKeys::RequestId);
             }
-            ctx.header(header_name, request_id);
+            ctx.header(header_name, *request_id);
             next();
         };
     }
@@ -73,12 +73,36 @@ public:
             span.setTag("http.target", ctx.request().getUrl());
 
             ctx.header("X-Trace-Id", span.context().trace_id);
-            ctx.set("trace_id", span.context().trace_id);
+            ctx.set(ContextKeys::TraceId, span.context().trace_id);
 
+            /* The span ends with the response, which a deferred handler fills later */
+            ctx.beforeSend([&ctx, span = std::move(span)]() mutable {
+                span.setTag("http.status_code", std::to_string(ctx.response().getStatusCode()));
+                span.setStatus(std::to_string(ctx.response().getStatusCode()));
+            });
             next();
+        };
+    }
 
-            span.setTag("http.status_code", std::to_string(ctx.response().getStatusCode()));
-            span.setStatus(std::to_string(ctx.response().getStatusCode()));
+    /*
+     * gzip/deflate per Accept-Encoding once the response is final, deferred
+     * ones included. The level steps down as the worker queue grows so
+     * compression never becomes the bottleneck; streamed responses are left
+     * alone.
+     */
+    static std::function<void(Context&, std::function<void()>)>
+    Compress(CompressionOptions options = CompressionOptions()) {
+        auto shared = std::make_shared<const CompressionOptions>(std::move(options));
+        return [shared](Context& ctx, std::function<void()> next) {
+            ctx.beforeSend([&ctx, options = shared] {
+                if (ctx.isStreaming()) {
+                    return;
+                }
+                ThreadPool* pool = ThreadPool::current();
+                int level = adaptiveLevel(*options, pool ? pool->pending_tasks() : 0);
+                compressResponse(ctx.request(), ctx.response(), *options, level);
+            });
+            next();
         };
     }
 
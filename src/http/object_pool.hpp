@@ -0,0 +1,124 @@
+#ifndef OBJECT_POOL_HPP
+#define OBJECT_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Gecko {
+
+/*
+ * Per-thread freelist of reusable objects.
+ *
+ * T must be default constructible and expose reset(), which returns the
+ * object to a clean state while keeping whatever capacity it has grown
+ * (string buffers, hash buckets). The owning thread acquires without
+ * locking. An object finished on another thread (a deferred context sent
+ * from the IO reactor, a timer or a poller) goes back to the pool that
+ * handed it out through a mutex-guarded return list, which the owner drains
+ * when its freelist runs dry, as BufferPool does.
+ */
+template <typename T>
+class ObjectPool : public std::enable_shared_from_this<ObjectPool<T>> {
+public:
+    static constexpr size_t DEFAULT_MAX_CACHED = 256;
+
+    struct Releaser {
+        std::shared_ptr<ObjectPool> origin;
+
+        void operator()(T* obj) const {
+            if (origin) {
+                origin->release(obj);
+            } else {
+                delete obj;
+            }
+        }
+    };
+    using Handle = std::unique_ptr<T, Releaser>;
+
+    /* Pool bound to the calling thread */
+    static ObjectPool& local() {
+        /* Held by shared_ptr so objects still in flight keep it alive after thread exit */
+        thread_local std::shared_ptr<ObjectPool> pool = [] {
+            auto created = std::make_shared<ObjectPool>();
+            current() = created.get();
+            return created;
+        }();
+        return *pool;
+    }
+
+    ObjectPool() { free_.reserve(DEFAULT_MAX_CACHED); }
+    ~ObjectPool() {
+        for (T* obj : free_) {
+            delete obj;
+        }
+        for (T* obj : returned_) {
+            delete obj;
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    Handle acquire() {
+        if (free_.empty()) {
+            std::lock_guard<std::mutex> lock(returned_mutex_);
+            free_.swap(returned_);
+        }
+        if (free_.empty()) {
+            pool_misses_++;
+            return Handle(new T(), Releaser{this->shared_from_this()});
+        }
+        T* obj = free_.back();
+        free_.pop_back();
+        return Handle(obj, Releaser{this->shared_from_this()});
+    }
+
+    void release(T* obj) {
+        if (!obj) return;
+        obj->reset();
+        if (current() == this) {
+            if (free_.size() >= max_cached_) {
+                delete obj; /* Drop object if pool is full */
+                return;
+            }
+            free_.push_back(obj);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(returned_mutex_);
+        if (returned_.size() >= max_cached_) {
+            lock.unlock();
+            delete obj;
+            return;
+        }
+        returned_.push_back(obj);
+    }
+
+    void set_max_cached(size_t max_cached) { max_cached_ = max_cached; }
+
+    /* Statistics */
+    size_t available_count() const {
+        std::lock_guard<std::mutex> lock(returned_mutex_);
+        return free_.size() + returned_.size();
+    }
+    size_t pool_misses() const { return pool_misses_; }
+
+private:
+    static ObjectPool*& current() {
+        thread_local ObjectPool* pool = nullptr;
+        return pool;
+    }
+
+    std::vector<T*> free_;  /* Owner thread only */
+    size_t max_cached_ = DEFAULT_MAX_CACHED;
+    size_t pool_misses_ = 0;
+
+    mutable std::mutex returned_mutex_;
+    std::vector<T*> returned_;
+};
+
+} /* namespace Gecko */
+
+#endif /* OBJECT_POOL_HPP */
@@ -0,0 +1,48 @@
+#ifndef REQUEST_ARENA_HPP
+#define REQUEST_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace Gecko {
+
+/*
+ * Monotonic arena backing the containers of a single request.
+ *
+ * Allocations are a pointer bump into an owned initial block; overflow
+ * chunks come from the upstream resource. reset() releases everything in
+ * one step and rewinds to the initial block, so a recycled arena serves
+ * the next request without touching the global allocator.
+ *
+ * Every container built on the arena must be cleared or destroyed before
+ * reset() is called.
+ */
+class RequestArena {
+public:
+    static constexpr size_t DEFAULT_INITIAL_SIZE = 8192; /* 8KB */
+
+    explicit RequestArena(size_t initial_size = DEFAULT_INITIAL_SIZE,
+                          std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : initial_size_(initial_size),
+          initial_block_(std::make_unique<std::byte[]>(initial_size)),
+          resource_(initial_block_.get(), initial_size, upstream) {}
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+    size_t initial_size() const { return initial_size_; }
+
+    /* Bulk release of all request-scoped allocations */
+    void reset() { resource_.release(); }
+
+private:
+    size_t initial_size_;
+    std::unique_ptr<std::byte[]> initial_block_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+} /* namespace Gecko */
+
+#endif /* REQUEST_ARENA_HPP */
@@ -0,0 +1,188 @@
+#include "response_cache.hpp"
+#include "fair_queue.hpp"
+#include "header_text.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace Gecko {
+
+namespace {
+
+using detail::equalsIgnoreCase;
+
+/* Fields the cache writes itself or splices per request */
+bool isManagedHeader(std::string_view key) {
+    return equalsIgnoreCase(key, "Connection") || equalsIgnoreCase(key, "Keep-Alive") ||
+        equalsIgnoreCase(key, "Date") || equalsIgnoreCase(key, "Content-Length");
+}
+
+} // namespace
+
+void ResponseCache::make_key(std::string& key, std::string_view method, std::string_view path) {
+    key.assign(method);
+    key += ' ';
+    key.append(path);
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::build(const HttpResponse& response, uint64_t version) {
+    auto entry = std::make_shared<Entry>();
+    entry->version = version;
+    entry->source = response;
+
+    entry->status_line = HttpVersionToString(response.getVersion());
+    entry->status_line += ' ';
+    entry->status_line += std::to_string(response.getStatusCode());
+    entry->status_line += ' ';
+    entry->status_line += response.getReasonPhrase();
+    entry->status_line += "\r\n";
+
+    std::string fields;
+    for (const auto& [key, value] : response.getHeaders()) {
+        if (isManagedHeader(key)) continue;
+        fields += key;
+        fields += ": ";
+        fields += value;
+        fields += "\r\n";
+    }
+    if (const auto& block = response.getHeaderBlock()) {
+        fields += *block;
+    }
+    std::string body(response.getBody());
+    size_t inline_length = body.size();
+    body.resize(response.getBodyLength());
+    char* out = body.data() + inline_length;
+    for (const auto& segment : response.getBodySegments()) {
+        out = copySegment(segment, out);
+    }
+    fields += "Content-Length: ";
+    fields += std::to_string(body.size());
+    fields += "\r\n";
+    entry->fields = std::make_shared<const std::string>(std::move(fields));
+
+    auto make_tail = [&body](ConnectionHeader connection) {
+        std::string tail(connectionHeaderLines(connection));
+        tail += "\r\n";
+        tail.append(body);
+        return std::make_shared<const std::string>(std::move(tail));
+    };
+    entry->keep_alive_tail = make_tail(ConnectionHeader::KEEP_ALIVE);
+    entry->close_tail = make_tail(ConnectionHeader::CLOSE);
+    return entry;
+}
+
+void ResponseCache::put(HttpMethod method, const std::string& path, const HttpResponse& response) {
+    std::string key;
+    make_key(key, HttpMethodToString(method), path);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto& route = routes_[key];
+    uint64_t version = route.entry ? route.entry->version + 1 : 1;
+    route.entry = build(response, version);
+    route.generator = nullptr;
+}
+
+void ResponseCache::put(HttpMethod method, const std::string& path, Generator generator) {
+    if (!generator) {
+        throw std::invalid_argument("ResponseCache generator must not be empty");
+    }
+    HttpResponse response = generator();
+    std::string key;
+    make_key(key, HttpMethodToString(method), path);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto& route = routes_[key];
+    uint64_t version = route.entry ? route.entry->version + 1 : 1;
+    route.entry = build(response, version);
+    route.generator = std::move(generator);
+}
+
+bool ResponseCache::refresh(HttpMethod method, const std::string& path) {
+    std::string key;
+    make_key(key, HttpMethodToString(method), path);
+    Generator generator;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = routes_.find(key);
+        if (it == routes_.end() || !it->second.generator) {
+            return false;
+        }
+        generator = it->second.generator;
+    }
+
+    /* Generate outside the lock; readers keep serving the current version */
+    HttpResponse response = generator();
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = routes_.find(key);
+    if (it == routes_.end()) {
+        return false;  /* Removed meanwhile */
+    }
+    it->second.entry = build(response, it->second.entry->version + 1);
+    return true;
+}
+
+void ResponseCache::remove(HttpMethod method, const std::string& path) {
+    std::string key;
+    make_key(key, HttpMethodToString(method), path);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    routes_.erase(key);
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::find(HttpMethod method, std::string_view path) const {
+    thread_local std::string key;
+    make_key(key, HttpMethodToString(method), path);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = routes_.find(key);
+    return it != routes_.end() ? it->second.entry : nullptr;
+}
+
+bool ResponseCache::empty() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return routes_.empty();
+}
+
+ResponseCache::Match ResponseCache::match(std::string_view raw_request) const {
+    Match result;
+    RequestView request(raw_request, {});
+    std::string_view version = request.version();
+    bool http_1_1 = version == "HTTP/1.1";
+    if (!http_1_1 && version != "HTTP/1.0") {
+        return result;
+    }
+
+    /* Requests with a body are left to the handler path */
+    std::string_view length = request.header("Content-Length");
+    if (!request.header("Transfer-Encoding").empty() || (!length.empty() && length != "0")) {
+        return result;
+    }
+    bool keep_alive = http_1_1;
+    std::string_view connection = request.header("Connection");
+    if (equalsIgnoreCase(connection, "close")) keep_alive = false;
+    else if (equalsIgnoreCase(connection, "keep-alive")) keep_alive = true;
+
+    thread_local std::string scratch;
+    make_key(scratch, request.method(), request.path());
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = routes_.find(scratch);
+    if (it != routes_.end()) {
+        result.entry = it->second.entry;
+        result.keep_alive = keep_alive;
+    }
+    return result;
+}
+
+PooledBuffer ResponseCache::serialize(const Entry& entry, ConnectionHeader connection,
+                                      std::vector<BodySegment>& segments) {
+    std::string_view date = currentDateLine();
+    PooledBuffer head = BufferPool::local().acquire(entry.status_line.size() + date.size());
+    std::memcpy(head.data(), entry.status_line.data(), entry.status_line.size());
+    std::memcpy(head.data() + entry.status_line.size(), date.data(), date.size());
+
+    segments.clear();
+    segments.emplace_back(entry.fields);
+    segments.emplace_back(connection == ConnectionHeader::CLOSE ? entry.close_tail : entry.keep_alive_tail);
+    return head;
+}
+
+} /* namespace Gecko */
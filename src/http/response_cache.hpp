@@ -0,0 +1,82 @@
+#ifndef RESPONSE_CACHE_HPP
+#define RESPONSE_CACHE_HPP
+
+#include "buffer_pool.hpp"
+#include "http_response.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Gecko {
+
+/*
+ * Pre-serialized responses for immutable routes.
+ *
+ * A cached route is matched on the IO thread straight from the raw request
+ * and answered without a Context, handler or serializer run; middlewares
+ * are bypassed. Only the status line, the Date line and the connection
+ * directive are spliced per request, the rest are refcounted buffers
+ * shared by every response in flight. Routes registered with a generator
+ * can be regenerated; each regeneration publishes a new version while
+ * writes of the old one finish undisturbed.
+ */
+class ResponseCache {
+public:
+    using Generator = std::function<HttpResponse()>;
+
+    /* Immutable snapshot of one cached route */
+    struct Entry {
+        uint64_t version = 0;
+        HttpResponse source;                                 /* For the routed fallback */
+        std::string status_line;                             /* "HTTP/1.1 200 OK\r\n" */
+        std::shared_ptr<const std::string> fields;           /* Header lines incl. Content-Length */
+        std::shared_ptr<const std::string> keep_alive_tail;  /* Connection lines, CRLF, body */
+        std::shared_ptr<const std::string> close_tail;
+    };
+
+    /* Result of matching a raw request */
+    struct Match {
+        std::shared_ptr<const Entry> entry;
+        bool keep_alive = false;
+    };
+
+    /* Cache a fixed response */
+    void put(HttpMethod method, const std::string& path, const HttpResponse& response);
+    /* Cache a generated response; the generator runs now and on every refresh() */
+    void put(HttpMethod method, const std::string& path, Generator generator);
+    /* Regenerate and publish a new version; false if the route has no generator */
+    bool refresh(HttpMethod method, const std::string& path);
+    void remove(HttpMethod method, const std::string& path);
+
+    std::shared_ptr<const Entry> find(HttpMethod method, std::string_view path) const;
+
+    /* Match a complete raw request (no body); entry is null on a miss */
+    Match match(std::string_view raw_request) const;
+
+    bool empty() const;
+
+    /* Per-request bytes: status and Date lines, then the shared buffers */
+    static PooledBuffer serialize(const Entry& entry, ConnectionHeader connection,
+                                  std::vector<BodySegment>& segments);
+
+private:
+    struct Route {
+        std::shared_ptr<const Entry> entry;
+        Generator generator;
+    };
+
+    static std::shared_ptr<const Entry> build(const HttpResponse& response, uint64_t version);
+    static void make_key(std::string& key, std::string_view method, std::string_view path);
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Route> routes_;  /* "METHOD path" */
+};
+
+} /* namespace Gecko */
+
+#endif /* RESPONSE_CACHE_HPP */
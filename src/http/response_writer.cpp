@@ -0,0 +1,276 @@
+#include "response_writer.hpp"
+#include "fiber.hpp"
+#include "server.hpp"
+#include "timer_service.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace Gecko {
+
+namespace {
+
+constexpr std::string_view CHUNK_CRLF = "\r\n";
+constexpr std::string_view LAST_CHUNK = "0\r\n\r\n";
+constexpr auto DRAIN_POLL_INTERVAL = std::chrono::milliseconds(100);
+
+/* "<hex length>\r\n" into out; returns the end */
+char* putChunkSize(char* out, size_t size) {
+    out = std::to_chars(out, out + 16, size, 16).ptr;
+    std::memcpy(out, CHUNK_CRLF.data(), CHUNK_CRLF.size());
+    return out + CHUNK_CRLF.size();
+}
+
+size_t chunkSizeLength(size_t size) {
+    size_t length = 1;
+    while (size >= 16) {
+        size /= 16;
+        ++length;
+    }
+    return length + CHUNK_CRLF.size();
+}
+
+} // namespace
+
+ResponseWriter::ResponseWriter(IOThreadPool& io_pool, std::shared_ptr<ConnectionInfo> conn_info,
+                               HttpResponse& response, ConnectionHeader connection,
+                               CompletionCallback on_complete,
+                               size_t high_watermark, size_t low_watermark)
+    : io_pool_(&io_pool), conn_info_(std::move(conn_info)), response_(response),
+      connection_(connection), high_watermark_(high_watermark),
+      low_watermark_(std::min(low_watermark, high_watermark)),
+      state_(std::make_shared<FlowState>()) {
+    state_->on_complete = std::move(on_complete);
+    state_->low_watermark = low_watermark_;
+}
+
+ResponseWriter::ResponseWriter(HttpResponse& response)
+    : response_(response), state_(std::make_shared<FlowState>()) {}
+
+ResponseWriter::~ResponseWriter() {
+    try {
+        end();
+    } catch (...) {
+        /* Never throw from a destructor */
+    }
+}
+
+bool ResponseWriter::ok() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return !state_->failed && (!conn_info_ || conn_info_->connected);
+}
+
+size_t ResponseWriter::queued_bytes() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->in_flight;
+}
+
+bool ResponseWriter::write(std::string_view data) {
+    if (!streaming()) {
+        response_.appendBody(std::string(data));
+        return true;
+    }
+    if (ended_ || !ok()) return false;
+    if (!head_sent_) send_head();
+    if (data.empty()) return ok();  /* An empty chunk would end the body */
+
+    PooledBuffer frame = BufferPool::local().acquire(chunkSizeLength(data.size()) + data.size() + CHUNK_CRLF.size());
+    char* out = putChunkSize(frame.data(), data.size());
+    std::memcpy(out, data.data(), data.size());
+    std::memcpy(out + data.size(), CHUNK_CRLF.data(), CHUNK_CRLF.size());
+    enqueue(std::move(frame), {}, false);
+    wait_for_drain();
+    return ok();
+}
+
+bool ResponseWriter::write(std::shared_ptr<const std::string> data) {
+    if (!streaming()) {
+        response_.appendBody(std::move(data));
+        return true;
+    }
+    if (ended_ || !ok()) return false;
+    if (!head_sent_) send_head();
+    if (!data || data->empty()) return ok();
+
+    PooledBuffer frame = BufferPool::local().acquire(chunkSizeLength(data->size()));
+    putChunkSize(frame.data(), data->size());
+    std::vector<BodySegment> segments;
+    segments.emplace_back(std::move(data));
+    segments.emplace_back(std::string(CHUNK_CRLF));
+    enqueue(std::move(frame), std::move(segments), false);
+    wait_for_drain();
+    return ok();
+}
+
+bool ResponseWriter::flush() {
+    if (!streaming()) return true;
+    if (ended_ || !ok()) return false;
+    if (!head_sent_) send_head();
+    return ok();
+}
+
+void ResponseWriter::end() {
+    if (ended_) return;
+    ended_ = true;
+    if (!streaming()) return;
+    if (!head_sent_) send_head();
+
+    PooledBuffer last = BufferPool::local().acquire(LAST_CHUNK.size());
+    std::memcpy(last.data(), LAST_CHUNK.data(), LAST_CHUNK.size());
+    enqueue(std::move(last), {}, true);
+}
+
+void ResponseWriter::abort() {
+    if (ended_) return;
+    ended_ = true;
+    if (!streaming()) return;
+
+    CompletionCallback done;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->failed = true;
+        if (!state_->completed) {
+            state_->completed = true;
+            done = std::move(state_->on_complete);
+        }
+    }
+    if (done) {
+        done(conn_info_, false);
+    }
+}
+
+void ResponseWriter::end_head_only() {
+    if (ended_) return;
+    ended_ = true;
+    if (!streaming()) {
+        response_.setBody(std::string());
+        response_.takeBodySegments();
+        return;
+    }
+    if (!head_sent_) send_head(false);
+    /* Nothing follows the head; an empty last write reports completion */
+    enqueue(PooledBuffer(), {}, true);
+}
+
+/* Headers without a length; anything already in the body goes out as the first chunk */
+void ResponseWriter::send_head(bool with_body) {
+    head_sent_ = true;
+    size_t initial_length = response_.getBodyLength();
+    std::string initial(response_.getBody());
+    std::vector<BodySegment> segments = response_.takeBodySegments();
+    response_.setBody(std::string());
+    response_.addHeader("Transfer-Encoding", "chunked");
+
+    HttpResponse::Head layout(response_, connection_);
+    PooledBuffer head = BufferPool::local().acquire(layout.inline_size);
+    response_.writeInlineTo(head.data(), layout);
+    enqueue(std::move(head), {}, false);
+
+    if (!with_body || initial_length == 0) {
+        return;
+    }
+    /* One chunk: inline bytes in the frame, appended segments sent as they are */
+    PooledBuffer frame = BufferPool::local().acquire(chunkSizeLength(initial_length) + initial.size());
+    char* out = putChunkSize(frame.data(), initial_length);
+    std::memcpy(out, initial.data(), initial.size());
+    segments.emplace_back(std::string(CHUNK_CRLF));
+    enqueue(std::move(frame), std::move(segments), false);
+}
+
+void ResponseWriter::enqueue(PooledBuffer&& data, std::vector<BodySegment>&& segments, bool last) {
+    size_t bytes = data.size();
+    for (const auto& segment : segments) {
+        bytes += segmentLength(segment);
+    }
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->in_flight += bytes;
+    }
+
+    auto state = state_;
+    io_pool_->async_write(conn_info_, std::move(data), std::move(segments),
+        [state, bytes, last](std::shared_ptr<ConnectionInfo> conn, bool success) {
+            CompletionCallback done;
+            Fiber* waiter = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->in_flight -= bytes;
+                if (!success) {
+                    state->failed = true;
+                }
+                if ((last || !success) && !state->completed) {
+                    state->completed = true;
+                    done = std::move(state->on_complete);
+                }
+                if (state->waiter && (state->in_flight <= state->low_watermark || state->failed)) {
+                    waiter = std::exchange(state->waiter, nullptr);
+                }
+            }
+            state->drained.notify_all();
+            if (done) {
+                done(conn, success);
+            }
+            if (waiter) {
+                waiter->wake();
+            }
+        });
+}
+
+/* Backpressure: past the high watermark, wait until the reactor drains to the low one.
+   Failed writes still report; the poll only catches peers lost without one. */
+void ResponseWriter::wait_for_drain() {
+    CompletionCallback done;
+    Fiber* self = Fiber::current();
+    {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        if (state_->in_flight <= high_watermark_) {
+            return;
+        }
+        while (state_->in_flight > low_watermark_ && !state_->failed) {
+            if (!conn_info_->connected) {
+                state_->failed = true;
+                if (!state_->completed) {
+                    state_->completed = true;
+                    done = std::move(state_->on_complete);
+                }
+                break;
+            }
+            if (!self) {
+                /* Off a fiber: block this thread */
+                state_->drained.wait_for(lock, DRAIN_POLL_INTERVAL);
+                continue;
+            }
+            lock.unlock();
+            /* Registered after the switch: a drain in between finds no waiter, so re-check first.
+               Whoever clears waiter wakes the fiber, the drain or the poll timer. */
+            self->park([state = state_, self] {
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (state->in_flight > state->low_watermark && !state->failed) {
+                        state->waiter = self;
+                        TimerService::instance().scheduleAfter(DRAIN_POLL_INTERVAL, [state, self] {
+                            {
+                                std::lock_guard<std::mutex> lock(state->mutex);
+                                if (state->waiter != self) {
+                                    return;
+                                }
+                                state->waiter = nullptr;
+                            }
+                            self->wake();
+                        });
+                        return;
+                    }
+                }
+                self->wake();
+            });
+            lock.lock();
+        }
+    }
+    if (done) {
+        done(conn_info_, false);
+    }
+}
+
+} /* namespace Gecko */
@@ -0,0 +1,101 @@
+#ifndef RESPONSE_WRITER_HPP
+#define RESPONSE_WRITER_HPP
+
+#include "http_response.hpp"
+#include "io_thread_pool.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+namespace Gecko {
+
+struct ConnectionInfo;
+class Fiber;
+
+/*
+ * Incremental body writer handed to Context::stream() producers.
+ *
+ * On an HTTP/1.1 connection every write() becomes one Transfer-Encoding:
+ * chunked frame queued on the connection's IO reactor. Bytes queued but
+ * not yet on the socket are counted; once they pass the high watermark
+ * write() waits until the reactor drains them below the low watermark, so
+ * a slow client stalls the producer rather than growing memory. The server
+ * runs producers on a fiber, which parks there and is resumed from the
+ * drain callback; the worker goes back to its queue meanwhile. Off a fiber
+ * the calling thread blocks.
+ *
+ * A writer built on a response alone (HTTP/1.0 peers, which cannot take
+ * chunked frames) appends to the response body instead and the response
+ * is sent whole after the producer returns.
+ */
+class ResponseWriter {
+public:
+    using CompletionCallback = std::function<void(std::shared_ptr<ConnectionInfo>, bool)>;
+
+    static constexpr size_t DEFAULT_HIGH_WATERMARK = 256 * 1024;
+    static constexpr size_t DEFAULT_LOW_WATERMARK = 64 * 1024;
+
+    /* Streaming writer; on_complete runs once, after the last frame or on failure */
+    ResponseWriter(IOThreadPool& io_pool, std::shared_ptr<ConnectionInfo> conn_info,
+                   HttpResponse& response, ConnectionHeader connection,
+                   CompletionCallback on_complete,
+                   size_t high_watermark = DEFAULT_HIGH_WATERMARK,
+                   size_t low_watermark = DEFAULT_LOW_WATERMARK);
+    /* Buffering writer */
+    explicit ResponseWriter(HttpResponse& response);
+    ~ResponseWriter();
+
+    ResponseWriter(const ResponseWriter&) = delete;
+    ResponseWriter& operator=(const ResponseWriter&) = delete;
+
+    /* Send data as one chunk; false once the connection is gone */
+    bool write(std::string_view data);
+    /* Send a shared immutable buffer as one chunk without copying it */
+    bool write(std::shared_ptr<const std::string> data);
+    /* Send headers now, before the first chunk is ready */
+    bool flush();
+    /* Terminate the body; implied by destruction */
+    void end();
+    /* Give up mid-body: no terminal chunk, the connection is reported failed */
+    void abort();
+    /* HEAD: send the head a GET would get, then finish without any body */
+    void end_head_only();
+
+    bool ok() const;
+    bool streaming() const { return io_pool_ != nullptr; }
+    size_t queued_bytes() const;
+
+private:
+    /* Shared with write callbacks, which can outlive the writer */
+    struct FlowState {
+        mutable std::mutex mutex;
+        std::condition_variable drained;
+        size_t in_flight = 0;
+        size_t low_watermark = 0;
+        Fiber* waiter = nullptr;  /* Producer parked until in_flight drops to low_watermark */
+        bool failed = false;
+        bool completed = false;
+        CompletionCallback on_complete;
+    };
+
+    void send_head(bool with_body = true);
+    void enqueue(PooledBuffer&& data, std::vector<BodySegment>&& segments, bool last);
+    void wait_for_drain();
+
+    IOThreadPool* io_pool_ = nullptr;
+    std::shared_ptr<ConnectionInfo> conn_info_;
+    HttpResponse& response_;
+    ConnectionHeader connection_ = ConnectionHeader::NONE;
+    size_t high_watermark_ = DEFAULT_HIGH_WATERMARK;
+    size_t low_watermark_ = DEFAULT_LOW_WATERMARK;
+    std::shared_ptr<FlowState> state_;
+    bool head_sent_ = false;
+    bool ended_ = false;
+};
+
+} /* namespace Gecko */
+
+#endif /* RESPONSE_WRITER_HPP */
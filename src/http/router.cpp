@@ -3,7 +3,7 @@
 namespace Gecko {
 
 void Router::insert(Gecko::HttpMethod method, const std::string &path,
-                    RequestHandler handler) {
+                    RequestHandler handler, size_t executor) {
     if (roots_.find(method) == roots_.end()) {
         roots_[method] = std::make_unique<Node>();
     }
@@ -13,7 +13,15 @@ void Router::insert(Gecko::HttpMethod method, const std::string &path,
         if (seg.empty()) {
             continue;
         }
-        if (seg[0] == ':') {
+        if (seg[0] == '*') {
+            /* Catch-all segment such as "*filepath"; must be last */
+            if (!current->catch_all_child) {
+                current->catch_all_child = std::make_unique<Node>(seg);
+                current->catch_all_key = seg.substr(1);
+            }
+            current = current->catch_all_child.get();
+            break;
+        } else if (seg[0] == ':') {
             /* Parameter segment such as ":id" */
             if (!current->param_child) {
                 current->param_child = std::make_unique<Node>(seg);
@@ -29,6 +37,7 @@ void Router::insert(Gecko::HttpMethod method, const std::string &path,
         }
     }
     current->handler = handler;
+    current->executor = executor;
 }
 
 auto Router::find(Gecko::HttpMethod method, const std::string &path) const
@@ -40,7 +49,20 @@ auto Router::find(Gecko::HttpMethod method, const std::string &path) const
     const Node *current_iter = method_iter->second.get();
     auto segments = split_path(path);
     RouteMatchResult ret{};
-    for (const auto &seg : segments) {
+
+    /* Deepest catch-all passed so far, used when the exact walk dead-ends */
+    const Node *catch_all_parent = nullptr;
+    size_t catch_all_from = 0;
+    std::map<std::string, std::string> catch_all_params;
+
+    bool matched = true;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const auto &seg = segments[i];
+        if (current_iter->catch_all_child && current_iter->catch_all_child->handler) {
+            catch_all_parent = current_iter;
+            catch_all_from = i;
+            catch_all_params = ret.params;
+        }
         auto child_iter = current_iter->children.find(seg);
         if (child_iter != current_iter->children.end()) {
             current_iter = child_iter->second.get();
@@ -48,13 +70,32 @@ auto Router::find(Gecko::HttpMethod method, const std::string &path) const
             ret.params[current_iter->param_key] = seg;
             current_iter = current_iter->param_child.get();
         } else {
-            return std::nullopt;
+            matched = false;
+            break;
         }
     }
-    if (current_iter && current_iter->handler) {
+    if (matched && current_iter->handler) {
         ret.handler = current_iter->handler;
+        ret.executor = current_iter->executor;
         return ret;
     }
+    if (matched && current_iter->catch_all_child && current_iter->catch_all_child->handler) {
+        /* A trailing slash matches the catch-all with an empty capture */
+        ret.params[current_iter->catch_all_key] = "";
+        ret.handler = current_iter->catch_all_child->handler;
+        ret.executor = current_iter->catch_all_child->executor;
+        return ret;
+    }
+    if (catch_all_parent) {
+        std::string rest;
+        for (size_t i = catch_all_from; i < segments.size(); ++i) {
+            if (!rest.empty()) rest += '/';
+            rest += segments[i];
+        }
+        catch_all_params[catch_all_parent->catch_all_key] = std::move(rest);
+        return RouteMatchResult{catch_all_parent->catch_all_child->handler, std::move(catch_all_params),
+                                catch_all_parent->catch_all_child->executor};
+    }
     return std::nullopt;
 }
 } // namespace Gecko
@@ -21,11 +21,14 @@ struct Node {
 
     Node(std::string seg = "") : segment(std::move(seg)) {}
 
-    std::string segment; /* e.g. "user" or ":id" */
+    std::string segment; /* e.g. "user", ":id" or "*filepath" */
     std::map<std::string, std::unique_ptr<Node>> children;
     std::unique_ptr<Node> param_child = nullptr;
     std::string param_key;
+    std::unique_ptr<Node> catch_all_child = nullptr; /* Matches the rest of the path */
+    std::string catch_all_key;
     RequestHandler handler = nullptr;
+    size_t executor = 0; /* Engine executor the route runs on; 0 = the request's worker */
 };
 
 
@@ -44,11 +47,13 @@ inline auto split_path(const std::string &path) -> std::vector<std::string> {
 
 class Router{
 public:
-    void insert(Gecko::HttpMethod method, const std::string& path, RequestHandler handler);
+    void insert(Gecko::HttpMethod method, const std::string& path, RequestHandler handler,
+                size_t executor = 0);
 
     struct RouteMatchResult{
         RequestHandler handler;
         std::map<std::string, std::string> params;
+        size_t executor = 0;
     };
 
     auto find(Gecko::HttpMethod method,const std::string& path) const -> std::optional<RouteMatchResult>;
@@ -1,8 +1,13 @@
 #include "server.hpp"
 #include "context.hpp"
 #include "fast_http_parser.hpp"
+#include "object_pool.hpp"
+#include "buffer_pool.hpp"
+#include "fiber.hpp"
+#include "response_writer.hpp"
 #include <algorithm>
 #include <cctype>
+#include <optional>
 #include <string_view>
 #include <thread>
 #include <sstream>
@@ -33,19 +38,54 @@ struct Server::CooperativeRequestState {
 
     std::shared_ptr<ConnectionInfo> conn_info;
     std::string request_data;
-    FastHttpRequest fast_request;
-    HttpRequest request;
-    std::unique_ptr<Context> ctx;
-    HttpResponse response;
-    std::string serialized_response;
+    /* Pooled context owning the request arena; fast_request lives on that arena
+       and is declared after it so it is destroyed first */
+    ObjectPool<Context>::Handle ctx;
+    std::optional<FastHttpRequest> fast_request;
+    PooledBuffer serialized_response;
+    std::vector<BodySegment> response_segments;
     bool keep_alive{false};
     Phase phase{Phase::Parse};
     size_t max_slices{0};
     std::chrono::steady_clock::time_point deadline;
     std::chrono::steady_clock::time_point request_start_time;
+    std::chrono::steady_clock::time_point service_start;  /* First slice */
     size_t slices_used{0};
 };
 
+namespace {
+
+bool wants_keep_alive(const HttpRequest& request) {
+    const auto& headers = request.getHeaders();
+    auto connection_it = headers.find("Connection");
+    if (connection_it == headers.end()) {
+        return request.getVersion() == HttpVersion::HTTP_1_1;
+    }
+    std::string_view connection_header = connection_it->second;
+    return connection_header == "keep-alive" ||
+        (request.getVersion() == HttpVersion::HTTP_1_1 && connection_header != "close");
+}
+
+/* Exact-size pooled buffer; ownership moves on to the IO thread */
+PooledBuffer serialize_pooled(const HttpResponse& response, ConnectionHeader connection) {
+    HttpResponse::Head head(response, connection);
+    PooledBuffer buffer = BufferPool::local().acquire(head.size);
+    response.writeTo(buffer.data(), head);
+    return buffer;
+}
+
+/* Head and inline body into a pooled buffer; appended segments are moved out unflattened */
+PooledBuffer serialize_pooled(HttpResponse& response, ConnectionHeader connection,
+                              std::vector<BodySegment>& segments) {
+    HttpResponse::Head head(response, connection);
+    PooledBuffer buffer = BufferPool::local().acquire(head.inline_size);
+    response.writeInlineTo(buffer.data(), head);
+    segments = response.takeBodySegments();
+    return buffer;
+}
+
+} // namespace
+
 /* ConnectionManager implementation */
 std::shared_ptr<ConnectionInfo> ConnectionManager::add_connection(int fd, 
                                                                 const std::string& peer_addr, 
@@ -64,14 +104,17 @@ std::shared_ptr<ConnectionInfo> ConnectionManager::add_connection(int fd,
     return conn_info;
 }
 
-void ConnectionManager::remove_connection(int fd) {
+bool ConnectionManager::remove_connection(const std::shared_ptr<ConnectionInfo>& conn_info) {
     std::unique_lock<std::shared_mutex> lock(connections_mutex_);
-    auto it = connections_.find(fd);
-    if (it != connections_.end()) {
-        it->second->connected = false;
-        connections_.erase(it);
-        active_connections_--;
+    auto it = connections_.find(conn_info->fd);
+    if (it == connections_.end() || it->second != conn_info) {
+        return false;  /* Already removed; the descriptor may have a new owner */
     }
+    conn_info->awaiting = false;
+    conn_info->connected = false;
+    connections_.erase(it);
+    active_connections_--;
+    return true;
 }
 
 void ConnectionManager::update_activity(int fd) {
@@ -110,6 +153,7 @@ void ConnectionManager::batch_remove_connections(const std::vector<int>& fds) {
     for (int fd : fds) {
         auto it = connections_.find(fd);
         if (it != connections_.end()) {
+            it->second->awaiting = false;
             it->second->connected = false;
             connections_.erase(it);
             active_connections_--;
@@ -124,6 +168,15 @@ void ConnectionManager::get_connection_stats(size_t& active, size_t& total_ever_
 }
 
 /* Server implementation */
+ThreadPool::ElasticConfig Server::elastic_config(const ServerConfig& config) {
+    ThreadPool::ElasticConfig elastic;
+    elastic.max_threads = config.max_worker_threads;
+    elastic.queue_delay = std::chrono::milliseconds(config.worker_grow_delay_ms);
+    elastic.blocked_after = std::chrono::milliseconds(config.worker_blocked_ms);
+    elastic.idle_timeout = std::chrono::seconds(config.worker_idle_timeout_s);
+    return elastic;
+}
+
 void Server::print_server_info() {
     std::cout << " Gecko Web Framework" << std::endl;
     std::cout << " Configuration:" << std::endl;
@@ -141,7 +194,14 @@ void Server::print_server_info_with_config(const ServerConfig& config) {
     std::cout << "   ├─ Port: " << config.port << std::endl;
     std::cout << "   ├─ Host: " << config.host << std::endl;
     std::cout << "   ├─ Worker Thread Pool Size: " << config.thread_pool_size << std::endl;
+    if (config.max_worker_threads > config.thread_pool_size) {
+        std::cout << "   ├─ Max Worker Threads: " << config.max_worker_threads << std::endl;
+    }
     std::cout << "   ├─ IO Thread Pool Size: " << config.io_thread_count << std::endl;
+    if (!config.io_cpus.empty() || !config.worker_cpus.empty()) {
+        std::cout << "   ├─ Pinned CPUs: " << config.io_cpus.size() << " IO, "
+                  << config.worker_cpus.size() << " worker" << std::endl;
+    }
     std::cout << "   ├─ Max Connections: " << config.max_connections << std::endl;
     std::cout << "   ├─ Keep-Alive Timeout: " << config.keep_alive_timeout << "s" << std::endl;
     std::cout << "   └─ Max Request Body Size: " << (config.max_request_body_size / 1024) << "KB" << std::endl;
@@ -275,17 +335,22 @@ void Server::on_connection(int client_fd) {
 }
 
 void Server::on_disconnect(int client_fd) {
-    auto conn_info = conn_manager_->get_connection(client_fd);
-    if (conn_info) {
-        #ifdef DEBUG
-        std::cout << "[ERROR] Connection closed " << conn_info->peer_addr << " (fd: " << client_fd 
-                  << ", requests: " << conn_info->request_count.load() << ")" << std::endl;
-        #endif
+    if (auto conn_info = conn_manager_->get_connection(client_fd)) {
+        on_disconnect(conn_info);
     }
-    
-    conn_manager_->remove_connection(client_fd);
-    remove_from_epoll(client_fd);
-    close(client_fd);
+}
+
+void Server::on_disconnect(const std::shared_ptr<ConnectionInfo>& conn_info) {
+    if (!conn_manager_->remove_connection(conn_info)) {
+        return;
+    }
+    #ifdef DEBUG
+    std::cout << "[ERROR] Connection closed " << conn_info->peer_addr << " (fd: " << conn_info->fd
+              << ", requests: " << conn_info->request_count.load() << ")" << std::endl;
+    #endif
+    remove_from_epoll(conn_info->fd);
+    /* The owning reactor releases the descriptor, so producers waiting on its queued writes hear of it */
+    io_thread_pool_->close_connection(conn_info);
 }
 
 void Server::handler_new_connection() {
@@ -374,33 +439,66 @@ void Server::handler_client_data(int client_fd) {
     });
 }
 
+std::chrono::steady_clock::time_point Server::request_deadline(std::string_view request_data,
+                                                               std::chrono::steady_clock::time_point now,
+                                                               std::chrono::milliseconds default_budget) const {
+    std::chrono::milliseconds budget = default_budget;
+    if (route_deadlines_.empty() && deadline_header_.empty()) {
+        return budget.count() > 0 ? now + budget : ThreadPool::NO_DEADLINE;
+    }
+
+    RequestView request(request_data, {});
+    for (const auto& [prefix, route_budget] : route_deadlines_) {
+        if (request.path().compare(0, prefix.size(), prefix) == 0) {
+            budget = route_budget;
+            break;
+        }
+    }
+
+    if (!deadline_header_.empty()) {
+        std::string_view value = request.header(deadline_header_);
+        long long client_ms = 0;
+        bool valid = !value.empty();
+        for (size_t i = 0; valid && i < value.size(); ++i) {
+            valid = std::isdigit(static_cast<unsigned char>(value[i])) && client_ms < 86400000;
+            client_ms = client_ms * 10 + (value[i] - '0');
+        }
+        if (valid && (budget.count() <= 0 || client_ms < budget.count())) {
+            /* A zero budget has already run out */
+            return now + std::chrono::milliseconds(client_ms);
+        }
+    }
+
+    return budget.count() > 0 ? now + budget : ThreadPool::NO_DEADLINE;
+}
+
+CancellationToken Server::cancellation_for(const std::shared_ptr<ConnectionInfo>& conn_info,
+                                           std::chrono::steady_clock::time_point deadline) {
+    /* Shares ownership of the connection, so the flag outlives it being closed */
+    return CancellationToken(std::shared_ptr<const std::atomic<bool>>(conn_info, &conn_info->awaiting), deadline);
+}
+
 bool Server::process_cooperative_request(const std::shared_ptr<CooperativeRequestState>& state,
                                          ThreadPool::TaskContext& ctx_slot) {
-    if (!state || !state->conn_info || !state->conn_info->connected) {
+    if (!state || !state->conn_info) {
+        return true;
+    }
+    if (!state->conn_info->awaiting) {
+        /* Client went away while queued or between slices */
+        cancelled_requests_++;
+        close_cancelled(state->conn_info);
         return true;
     }
 
     auto should_stop = [&]() {
-        bool timeout_reached = cooperative_request_timeout_.count() > 0 &&
-            std::chrono::steady_clock::now() >= state->deadline;
+        bool timeout_reached = std::chrono::steady_clock::now() >= state->deadline;
         bool slice_limit = state->slices_used >= state->max_slices;
         return timeout_reached || slice_limit;
     };
 
     auto fail_and_reply = [&](int status, const std::string& message) {
         cooperative_dropped_++;
-        HttpResponse error_response = HttpResponse::stockResponse(status);
-        error_response.setBody(message);
-        error_response.addHeader("Content-Type", "text/plain");
-        error_response.addHeader("Connection", "close");
-        std::string error_response_str;
-        error_response.serializeTo(error_response_str);
-        io_thread_pool_->async_write(state->conn_info, error_response_str, 
-            [this](std::shared_ptr<ConnectionInfo> conn, bool /*success*/) {
-                if (conn) {
-                    on_disconnect(conn->fd);
-                }
-            });
+        reply_error_and_close(state->conn_info, status, message);
     };
 
     auto handle_yield = [&]() -> bool {
@@ -413,11 +511,28 @@ bool Server::process_cooperative_request(const std::shared_ptr<CooperativeReques
         return false; /* requeue */
     };
 
+    if (state->phase == CooperativeRequestState::Phase::Parse && state->slices_used == 0) {
+        /* Shed before doing any work when the deadline cannot be met anyway */
+        auto now = std::chrono::steady_clock::now();
+        if (admission_) {
+            admission_->record(now - state->request_start_time, now);
+        }
+        auto expected = std::chrono::microseconds(cooperative_service_us_.load(std::memory_order_relaxed));
+        if (ctx_slot.expired() || state->deadline - now < expected) {
+            cooperative_shed_++;
+            fail_and_reply(503, "Service Unavailable");
+            return true;
+        }
+        state->service_start = now;
+    }
+
     while (true) {
         try {
             switch (state->phase) {
             case CooperativeRequestState::Phase::Parse: {
-                if (!FastHttpParser::parse(state->request_data, state->fast_request)) {
+                state->ctx = ObjectPool<Context>::local().acquire();
+                state->fast_request.emplace(state->ctx->arena());
+                if (!FastHttpParser::parse(state->request_data, *state->fast_request)) {
                     throw std::runtime_error("Failed to parse HTTP request");
                 }
                 state->phase = CooperativeRequestState::Phase::Convert;
@@ -428,12 +543,10 @@ bool Server::process_cooperative_request(const std::shared_ptr<CooperativeReques
                 continue;
             }
             case CooperativeRequestState::Phase::Convert: {
-                HttpRequestAdapter::convert(state->fast_request, state->request);
-                auto headers = state->request.getHeaders();
-                auto connection_it = headers.find("Connection");
-                std::string connection_header = (connection_it != headers.end()) ? connection_it->second : "";
-                state->keep_alive = (connection_header == "keep-alive" || 
-                    (state->request.getVersion() == HttpVersion::HTTP_1_1 && connection_header != "close"));
+                HttpRequest& request = state->ctx->requestStorage();
+                HttpRequestAdapter::convert(*state->fast_request, request);
+                state->fast_request.reset();
+                state->keep_alive = wants_keep_alive(request);
                 state->conn_info->keep_alive = state->keep_alive;
 
                 state->phase = CooperativeRequestState::Phase::BuildContext;
@@ -444,7 +557,7 @@ bool Server::process_cooperative_request(const std::shared_ptr<CooperativeReques
                 continue;
             }
             case CooperativeRequestState::Phase::BuildContext: {
-                state->ctx = std::make_unique<Context>(state->request);
+                state->ctx->setRequest(state->ctx->requestStorage());
                 state->phase = CooperativeRequestState::Phase::Handle;
                 if (ctx_slot.should_yield()) {
                     if (handle_yield()) return true;
@@ -453,8 +566,18 @@ bool Server::process_cooperative_request(const std::shared_ptr<CooperativeReques
                 continue;
             }
             case CooperativeRequestState::Phase::Handle: {
+                state->ctx->setCancellation(cancellation_for(state->conn_info, state->deadline));
                 request_handler_(*state->ctx);
-                state->response = state->ctx->response();
+                if (state->ctx->isDeferred()) {
+                    /* The handler yields on its own; the phase machine is done with it */
+                    Context& deferred = *state->ctx;
+                    deferred.onComplete([this, state, ctx = std::move(state->ctx)]() mutable {
+                        finish_deferred(state->conn_info, std::move(ctx), state->keep_alive,
+                                        state->request_start_time);
+                    });
+                    state->phase = CooperativeRequestState::Phase::Done;
+                    return true;
+                }
                 state->phase = CooperativeRequestState::Phase::Serialize;
                 if (ctx_slot.should_yield()) {
                     if (handle_yield()) return true;
@@ -463,13 +586,18 @@ bool Server::process_cooperative_request(const std::shared_ptr<CooperativeReques
                 continue;
             }
             case CooperativeRequestState::Phase::Serialize: {
-                if (state->keep_alive) {
-                    state->response.addHeader("Connection", "keep-alive");
-                    state->response.addHeader("Keep-Alive", "timeout=30, max=100");
-                } else {
-                    state->response.addHeader("Connection", "close");
+                /* A streamed body runs to completion here; it cannot yield mid-stream */
+                if (state->ctx->isStreaming() &&
+                    stream_response(state->conn_info, state->ctx, state->keep_alive)) {
+                    state->ctx.reset();
+                    successful_requests_++;
+                    state->phase = CooperativeRequestState::Phase::Done;
+                    return true;
                 }
-                state->response.serializeTo(state->serialized_response);
+                state->serialized_response = serialize_pooled(state->ctx->response(),
+                    state->keep_alive ? ConnectionHeader::KEEP_ALIVE : ConnectionHeader::CLOSE,
+                    state->response_segments);
+                state->ctx.reset();
                 state->phase = CooperativeRequestState::Phase::Write;
                 if (ctx_slot.should_yield()) {
                     if (handle_yield()) return true;
@@ -479,13 +607,19 @@ bool Server::process_cooperative_request(const std::shared_ptr<CooperativeReques
             }
             case CooperativeRequestState::Phase::Write: {
                 if (state->conn_info->connected) {
-                    handle_keep_alive_response(state->conn_info, state->serialized_response);
+                    handle_keep_alive_response(state->conn_info, std::move(state->serialized_response),
+                                               std::move(state->response_segments));
                 }
 
                 successful_requests_++;
                 auto request_end_time = std::chrono::steady_clock::now();
                 auto response_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
                     request_end_time - state->request_start_time).count() / 1000.0;
+                /* EWMA with weight 1/8; racing updates only lose a sample */
+                int64_t service_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    request_end_time - state->service_start).count();
+                int64_t average = cooperative_service_us_.load(std::memory_order_relaxed);
+                cooperative_service_us_.store(average + (service_us - average) / 8, std::memory_order_relaxed);
                 double current_total = total_response_time_ms_.load();
                 while (!total_response_time_ms_.compare_exchange_weak(current_total, 
                                                                    current_total + response_time_ms)) {
@@ -503,21 +637,9 @@ bool Server::process_cooperative_request(const std::shared_ptr<CooperativeReques
                       << ": " << e.what() << std::endl;
 
             if (state->conn_info->connected) {
-                HttpResponse error_response = HttpResponse::stockResponse(500);
-                error_response.setBody("Internal Server Error");
-                error_response.addHeader("Content-Type", "text/plain");
-                error_response.addHeader("Connection", "close");
-                
-                std::string error_response_str;
-                error_response.serializeTo(error_response_str);
-                io_thread_pool_->async_write(state->conn_info, error_response_str, 
-                    [this](std::shared_ptr<ConnectionInfo> conn, bool /*success*/) {
-                        if (conn) {
-                            on_disconnect(conn->fd);
-                        }
-                    });
-                state->conn_info->keep_alive = false;
+                reply_error_and_close(state->conn_info, 500, "Internal Server Error");
             }
+            release_when_sent(state->ctx);
             state->phase = CooperativeRequestState::Phase::Failed;
             return true;
         }
@@ -539,12 +661,31 @@ void Server::process_request_with_io_thread(std::shared_ptr<ConnectionInfo> conn
     
     conn_info->request_count++;
     total_requests_++;
+
+    /* Precomputed routes are answered right here on the IO thread */
+    if (response_cache_) {
+        auto hit = response_cache_->match(request_data);
+        if (hit.entry) {
+            conn_info->keep_alive = hit.keep_alive;
+            std::vector<BodySegment> segments;
+            PooledBuffer head = ResponseCache::serialize(*hit.entry,
+                hit.keep_alive ? ConnectionHeader::KEEP_ALIVE : ConnectionHeader::CLOSE, segments);
+            response_cache_hits_++;
+            successful_requests_++;
+            handle_keep_alive_response(conn_info, std::move(head), std::move(segments));
+            return;
+        }
+    }
+
+    /* Under a standing queue, refuse before spending anything on parsing or routing */
+    if (admission_ && !admission_->admit(thread_pool_->pending_tasks())) {
+        reply_overloaded(conn_info);
+        return;
+    }
     
     if (use_cooperative_workers_) {
-        auto now = std::chrono::steady_clock::now();
-        auto deadline = (cooperative_request_timeout_.count() > 0)
-            ? now + cooperative_request_timeout_
-            : std::chrono::steady_clock::time_point::max();
+        auto deadline = request_deadline(request_data, std::chrono::steady_clock::now(),
+                                         cooperative_request_timeout_);
         auto state = std::make_shared<CooperativeRequestState>(conn_info, request_data,
                                                                cooperative_max_slices_,
                                                                deadline);
@@ -553,110 +694,268 @@ void Server::process_request_with_io_thread(std::shared_ptr<ConnectionInfo> conn
                 return process_cooperative_request(state, ctx_slot);
             },
             cooperative_priority_,
-            cooperative_time_slice_);
+            cooperative_time_slice_,
+            deadline);
         return;
     }
 
     auto request_start_time = std::chrono::steady_clock::now();
-    thread_pool_->enqueue([this, conn_info, request_data, request_start_time]() {
+    /* A non-const copy of the request keeps the task nothrow-movable, hence inline */
+    auto work = [this, conn_info, request_data = std::string(request_data), request_start_time]() {
+        auto now = std::chrono::steady_clock::now();
+        if (admission_) {
+            admission_->record(now - request_start_time, now);
+        }
+        /* Nobody is waiting for this answer any more: skip parsing, handler and serialization */
+        if (!conn_info->awaiting) {
+            cancelled_requests_++;
+            close_cancelled(conn_info);
+            return;
+        }
+        /* Derived here rather than captured, so the task stays inline in its slot */
+        auto deadline = request_deadline(request_data, request_start_time, std::chrono::milliseconds(0));
+        if (now >= deadline) {
+            cancelled_requests_++;
+            reply_error_and_close(conn_info, 503, "Service Unavailable");
+            return;
+        }
+        /* Outside the try: a responder may still point at it when the handler throws */
+        ObjectPool<Context>::Handle ctx;
         try {
-            FastHttpRequest fast_request;
-            if (!FastHttpParser::parse(request_data, fast_request)) {
-                throw std::runtime_error("Failed to parse HTTP request");
+            /* All request-scoped containers live on the pooled context's arena */
+            ctx = ObjectPool<Context>::local().acquire();
+            HttpRequest& request = ctx->requestStorage();
+            {
+                FastHttpRequest fast_request(ctx->arena());
+                if (!FastHttpParser::parse(request_data, fast_request)) {
+                    throw std::runtime_error("Failed to parse HTTP request");
+                }
+                HttpRequestAdapter::convert(fast_request, request);
             }
-            /* TODO: pool this request object */
-            HttpRequest request;
-            HttpRequestAdapter::convert(fast_request, request);
             
             /* Check keep-alive support */
-            bool keep_alive = false;
-            auto headers = request.getHeaders();
-            auto connection_it = headers.find("Connection");
-            std::string connection_header = (connection_it != headers.end()) ? connection_it->second : "";
-            if (connection_header == "keep-alive" || 
-                (request.getVersion() == HttpVersion::HTTP_1_1 && connection_header != "close")) {
-                keep_alive = true;
-            }
+            bool keep_alive = wants_keep_alive(request);
             conn_info->keep_alive = keep_alive;
             
-            /* TODO: pool context/response objects */
-            Context ctx(request);
-            request_handler_(ctx);
-            HttpResponse response = ctx.response();
-            
-            if (keep_alive) {
-                response.addHeader("Connection", "keep-alive");
-                response.addHeader("Keep-Alive", "timeout=30, max=100");
-            } else {
-                response.addHeader("Connection", "close");
-            }
-            
-            std::string response_str;
-            response.serializeTo(response_str);
-            
-            auto request_end_time = std::chrono::steady_clock::now();
-            auto response_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
-                request_end_time - request_start_time).count() / 1000.0;
-            
-            successful_requests_++;
-            
-            double current_total = total_response_time_ms_.load();
-            while (!total_response_time_ms_.compare_exchange_weak(current_total, 
-                                                                current_total + response_time_ms)) {
-            }
-            
-            if (conn_info->connected) {
-                handle_keep_alive_response(conn_info, response_str);
+            ctx->setRequest(request);
+            ctx->setCancellation(cancellation_for(conn_info, deadline));
+            request_handler_(*ctx);
+
+            if (ctx->isDeferred()) {
+                Context& deferred = *ctx;
+                deferred.onComplete([this, conn_info, ctx = std::move(ctx), keep_alive, request_start_time]() mutable {
+                    finish_deferred(std::move(conn_info), std::move(ctx), keep_alive, request_start_time);
+                });
+                return;
             }
+            finish_request(conn_info, ctx, keep_alive, request_start_time);
         } catch (const std::exception& e) {
-            /* Track failed request */
-            failed_requests_++;
-            
-            std::cerr << "[ERROR] Error processing request from " << conn_info->peer_addr 
-                      << ": " << e.what() << std::endl;
-            
-            if (conn_info->connected) {
-                HttpResponse error_response = HttpResponse::stockResponse(500);
-                error_response.setBody("Internal Server Error");
-                error_response.addHeader("Content-Type", "text/plain");
-                error_response.addHeader("Connection", "close");
-                
-                std::string error_response_str;
-                error_response.serializeTo(error_response_str);
-                io_thread_pool_->async_write(conn_info, error_response_str, 
-                    [this](std::shared_ptr<ConnectionInfo> conn, bool /*success*/) {
-                        if (conn) {
-                            on_disconnect(conn->fd);
-                        }
-                    });
-                conn_info->keep_alive = false;
-            }
+            fail_request(conn_info, e);
+            release_when_sent(ctx);
+        }
+    };
+
+    static_assert(TaskSlot::fits_inline<decltype(work)>, "per-request task must not allocate");
+
+    if (!fair_queue_) {
+        thread_pool_->post(std::move(work));
+        return;
+    }
+    /* Queue by tenant; each pool task then runs whichever request DRR picks next */
+    std::string tenant = tenant_classifier_(RequestView(request_data, conn_info->peer_addr));
+    if (!fair_queue_->push(tenant, std::move(work))) {
+        tenant_rejected_++;
+        reply_overloaded(conn_info);
+        return;
+    }
+    thread_pool_->post([this]() {
+        TaskSlot next = fair_queue_->pop();
+        if (next) {
+            next();
         }
     });
 }
 
-void Server::handle_keep_alive_response(std::shared_ptr<ConnectionInfo> conn_info, const std::string& response_data) {
+void Server::finish_request(const std::shared_ptr<ConnectionInfo>& conn_info, ObjectPool<Context>::Handle& ctx,
+                            bool keep_alive, std::chrono::steady_clock::time_point request_start_time) {
+    if (ctx->isStreaming() && stream_response(conn_info, ctx, keep_alive)) {
+        successful_requests_++;
+        return;
+    }
+    
+    std::vector<BodySegment> response_segments;
+    PooledBuffer response_buffer = serialize_pooled(ctx->response(),
+        keep_alive ? ConnectionHeader::KEEP_ALIVE : ConnectionHeader::CLOSE, response_segments);
+    
+    auto request_end_time = std::chrono::steady_clock::now();
+    auto response_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+        request_end_time - request_start_time).count() / 1000.0;
+    
+    successful_requests_++;
+    
+    double current_total = total_response_time_ms_.load();
+    while (!total_response_time_ms_.compare_exchange_weak(current_total, 
+                                                        current_total + response_time_ms)) {
+    }
+    
+    if (conn_info->connected) {
+        handle_keep_alive_response(conn_info, std::move(response_buffer), std::move(response_segments));
+    }
+}
+
+void Server::finish_deferred(std::shared_ptr<ConnectionInfo> conn_info, ObjectPool<Context>::Handle ctx,
+                             bool keep_alive, std::chrono::steady_clock::time_point request_start_time) {
+    bool on_worker = ThreadPool::current() == thread_pool_.get();
+    bool streaming = ctx->isStreaming();
+    auto finish = [this, conn_info, ctx = std::move(ctx), keep_alive, request_start_time]() mutable {
+        try {
+            finish_request(conn_info, ctx, keep_alive, request_start_time);
+        } catch (const std::exception& e) {
+            fail_request(conn_info, e);
+        }
+    };
+    
+    if (on_worker) {
+        finish();
+        return;
+    }
+    /* Sent from a timer, poller or upstream client thread */
+    if (streaming) {
+        /* A stream producer runs on a fiber of the worker pool, never on a reactor */
+        try {
+            thread_pool_->post(std::move(finish));
+        } catch (const std::exception& e) {
+            fail_request(conn_info, e);
+        }
+        return;
+    }
+    io_thread_pool_->run_on(conn_info, std::move(finish));
+}
+
+void Server::fail_request(const std::shared_ptr<ConnectionInfo>& conn_info, const std::exception& e) {
+    /* Track failed request */
+    failed_requests_++;
+    
+    std::cerr << "[ERROR] Error processing request from " << conn_info->peer_addr 
+              << ": " << e.what() << std::endl;
+    
+    if (conn_info->connected) {
+        reply_error_and_close(conn_info, 500, "Internal Server Error");
+    }
+}
+
+void Server::close_cancelled(const std::shared_ptr<ConnectionInfo>& conn_info) {
+    /* A half-closed peer is still writable; no answer is coming, so close it */
+    on_disconnect(conn_info);
+}
+
+void Server::release_when_sent(ObjectPool<Context>::Handle& ctx) {
+    if (!ctx || !ctx->isDeferred()) {
+        return;
+    }
+    /* The 500 is already out; the responder's send() only recycles the context */
+    Context& deferred = *ctx;
+    deferred.onComplete([ctx = std::move(ctx)]() mutable { ctx.reset(); });
+}
+
+void Server::handle_keep_alive_response(std::shared_ptr<ConnectionInfo> conn_info, PooledBuffer&& response_data,
+                                        std::vector<BodySegment>&& response_segments) {
     if (!conn_info || !conn_info->connected) {
         return;
     }
     
-    io_thread_pool_->async_write(conn_info, response_data, 
-        [this, conn_info](std::shared_ptr<ConnectionInfo> conn, bool success) {
-            if (!conn || !conn->connected) {
-                return;
+    io_thread_pool_->async_write(conn_info, std::move(response_data), std::move(response_segments),
+                                 response_completion());
+}
+
+ResponseWriter::CompletionCallback Server::response_completion() {
+    return [this](std::shared_ptr<ConnectionInfo> conn, bool success) {
+        if (!conn || !conn->connected) {
+            return;
+        }
+        
+        if (success) {
+            /* A peer that half-closed sends nothing more; close once its answer is out */
+            if (!conn->keep_alive || !conn->awaiting) {
+                on_disconnect(conn);
             }
-            
-            if (success) {
-                if (!conn->keep_alive) {
-                    on_disconnect(conn->fd);
-                }
-            } else {
-                on_disconnect(conn->fd);
+        } else {
+            on_disconnect(conn);
+        }
+    };
+}
+
+bool Server::stream_response(const std::shared_ptr<ConnectionInfo>& conn_info, ObjectPool<Context>::Handle& ctx,
+                             bool keep_alive) {
+    StreamProducer producer = ctx->takeStreamProducer();
+    bool head_only = ctx->request().getMethod() == HttpMethod::HEAD;
+    if (ctx->request().getVersion() != HttpVersion::HTTP_1_1) {
+        /* No chunked framing before HTTP/1.1: collect the body and send it whole */
+        ResponseWriter writer(ctx->response());
+        if (head_only) {
+            writer.end_head_only();
+        } else {
+            producer(writer);
+        }
+        return false;
+    }
+    
+    ConnectionHeader connection = keep_alive ? ConnectionHeader::KEEP_ALIVE : ConnectionHeader::CLOSE;
+    if (head_only) {
+        /* Same head as a GET; the producer never runs */
+        ResponseWriter writer(*io_thread_pool_, conn_info, ctx->response(), connection, response_completion(),
+                              stream_high_watermark_, stream_low_watermark_);
+        writer.end_head_only();
+        ctx.reset();
+        return true;
+    }
+
+    /* The fiber owns the context until the last chunk is queued; backpressure parks it, not the worker */
+    Fiber::start([this, conn_info, connection, ctx = std::move(ctx), producer = std::move(producer)]() mutable {
+        ResponseWriter writer(*io_thread_pool_, conn_info, ctx->response(), connection, response_completion(),
+                              stream_high_watermark_, stream_low_watermark_);
+        try {
+            producer(writer);
+        } catch (const std::exception& e) {
+            failed_requests_++;
+            std::cerr << "[ERROR] Stream producer failed for " << conn_info->peer_addr << ": " << e.what()
+                      << std::endl;
+            writer.abort();  /* Headers may be out already; a 500 cannot follow */
+            return;
+        }
+        writer.end();
+    });
+    return true;
+}
+
+
+void Server::reply_overloaded(const std::shared_ptr<ConnectionInfo>& conn_info) {
+    conn_info->keep_alive = false;
+    std::vector<BodySegment> segments;
+    segments.emplace_back(overload_response_);
+    io_thread_pool_->async_write(conn_info, PooledBuffer(), std::move(segments),
+        [this](std::shared_ptr<ConnectionInfo> conn, bool /*success*/) {
+            if (conn) {
+                on_disconnect(conn);
             }
         });
 }
 
+void Server::reply_error_and_close(const std::shared_ptr<ConnectionInfo>& conn_info, int status_code,
+                                   const std::string& message) {
+    auto error_response = ObjectPool<HttpResponse>::local().acquire();
+    error_response->setStatusCode(status_code);
+    error_response->setBody(message);
+    error_response->addHeader("Content-Type", "text/plain");
 
+    conn_info->keep_alive = false;
+    io_thread_pool_->async_write(conn_info, serialize_pooled(*error_response, ConnectionHeader::CLOSE), 
+        [this](std::shared_ptr<ConnectionInfo> conn, bool /*success*/) {
+            if (conn) {
+                on_disconnect(conn);
+            }
+        });
+}
 
 void Server::send_error_response(int client_fd, int status_code, const std::string& message) {
     std::ostringstream response;
@@ -746,8 +1045,14 @@ Server::PerformanceStats Server::get_performance_stats() const {
     
     stats.io_thread_load = io_thread_pool_->thread_count();
     stats.worker_thread_load = thread_pool_->thread_count();
+    stats.worker_thread_target = thread_pool_->target_threads();
     stats.cooperative_reschedules = cooperative_reschedules_.load();
+    stats.response_cache_hits = response_cache_hits_.load();
     stats.cooperative_dropped = cooperative_dropped_.load();
+    stats.cooperative_shed = cooperative_shed_.load();
+    stats.admission_shed = admission_ ? admission_->rejected() : 0;
+    stats.cancelled_requests = cancelled_requests_.load();
+    stats.tenant_rejected = tenant_rejected_.load();
     stats.pending_worker_tasks = thread_pool_->pending_tasks();
     
     return stats;
@@ -764,10 +1069,19 @@ void Server::print_performance_stats() const {
     std::cout << " Avg response time: " << std::fixed << std::setprecision(2) 
               << stats.avg_response_time_ms << " ms" << std::endl;
     std::cout << " IO threads: " << stats.io_thread_load << std::endl;
-    std::cout << " Worker threads: " << stats.worker_thread_load << std::endl;
+    std::cout << " Worker threads: " << stats.worker_thread_load;
+    if (stats.worker_thread_target != stats.worker_thread_load) {
+        std::cout << " (target " << stats.worker_thread_target << ")";
+    }
+    std::cout << std::endl;
     std::cout << " Worker queue depth: " << stats.pending_worker_tasks << std::endl;
     std::cout << " Cooperative reschedules: " << stats.cooperative_reschedules << std::endl;
     std::cout << " Cooperative drops: " << stats.cooperative_dropped << std::endl;
+    std::cout << " Cooperative early sheds: " << stats.cooperative_shed << std::endl;
+    std::cout << " Admission control sheds: " << stats.admission_shed << std::endl;
+    std::cout << " Cancelled before handler: " << stats.cancelled_requests << std::endl;
+    std::cout << " Tenant queue rejections: " << stats.tenant_rejected << std::endl;
+    std::cout << " Response cache hits: " << stats.response_cache_hits << std::endl;
     std::cout << "================================" << std::endl;
 }
 
@@ -3,8 +3,14 @@
 #include "http_request.hpp"
 #include "http_response.hpp"
 #include "thread_pool.hpp"
+#include "admission_controller.hpp"
+#include "cancellation_token.hpp"
+#include "fair_queue.hpp"
 #include "io_thread_pool.hpp"
+#include "object_pool.hpp"
 #include "server_config.hpp"
+#include "response_cache.hpp"
+#include "response_writer.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -19,6 +25,8 @@
 #include <shared_mutex>
 #include <chrono>
 #include <stack>
+#include <algorithm>
+#include <cstdint>
 
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -40,12 +48,14 @@ struct ConnectionInfo {
     int fd;
     std::string peer_addr;
     std::string local_addr;
-    std::chrono::steady_clock::time_point last_active;
+    std::atomic<std::chrono::steady_clock::time_point> last_active;  /* Refreshed by reads and write progress */
     std::chrono::steady_clock::time_point creation_time;
-    std::atomic<bool> connected{true};
+    std::atomic<bool> connected{true};   /* Writable; cleared on EOF, HUP/ERR or when the server closes it */
+    std::atomic<bool> awaiting{true};    /* Cleared once the peer stops sending: cancels its requests in flight */
     std::atomic<size_t> request_count{0};
     std::string partial_request;  /* Partial request data */
     bool keep_alive{true};        /* Keep connection alive */
+    int io_thread_index{-1};      /* Owning IO reactor, fixed on first registration */
     
     ConnectionInfo(int fd, const std::string& peer, const std::string& local)
         : fd(fd), peer_addr(peer), local_addr(local),
@@ -53,12 +63,12 @@ struct ConnectionInfo {
           creation_time(std::chrono::steady_clock::now()) {}
           
     void update_activity() {
-        last_active = std::chrono::steady_clock::now();
+        last_active.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
     }
     
     bool is_expired(std::chrono::seconds timeout) const {
         auto now = std::chrono::steady_clock::now();
-        return (now - last_active) > timeout;
+        return (now - last_active.load(std::memory_order_relaxed)) > timeout;
     }
 };
 
@@ -74,7 +84,8 @@ public:
     
     std::shared_ptr<ConnectionInfo> add_connection(int fd, const std::string& peer_addr, 
                                                   const std::string& local_addr);
-    void remove_connection(int fd);
+    /* False if conn_info was already removed */
+    bool remove_connection(const std::shared_ptr<ConnectionInfo>& conn_info);
     void update_activity(int fd);
     std::shared_ptr<ConnectionInfo> get_connection(int fd);
     std::vector<int> get_expired_connections();
@@ -118,8 +129,10 @@ public:
         : port_(config.port), host_(config.host), listen_fd_(-1), epoll_fd_(-1),
           thread_pool_(std::make_unique<ThreadPool>(config.thread_pool_size,
                                                     config.enable_cooperative_tasks,
-                                                    config.cooperative_task_time_slice)),
-          io_thread_pool_(std::make_unique<IOThreadPool>(config.io_thread_count)),
+                                                    config.cooperative_task_time_slice,
+                                                    elastic_config(config),
+                                                    pair_with_reactors(config.worker_cpus, config.io_cpus))),
+          io_thread_pool_(std::make_unique<IOThreadPool>(config.io_thread_count, config.io_cpus)),
           conn_manager_(std::make_unique<ConnectionManager>(config.max_connections, 
                                                           std::chrono::seconds(config.keep_alive_timeout))),
           enable_performance_monitoring_(config.enable_performance_monitor),
@@ -137,6 +150,32 @@ public:
             cooperative_max_slices_ = config.cooperative_max_slices;
             cooperative_request_timeout_ = std::chrono::milliseconds(config.cooperative_request_timeout_ms);
         }
+        route_deadlines_ = config.route_deadlines;
+        std::sort(route_deadlines_.begin(), route_deadlines_.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first.size() > rhs.first.size();
+        });
+        deadline_header_ = config.deadline_header;
+        if (config.enable_admission_control) {
+            admission_ = std::make_unique<AdmissionController>(
+                std::chrono::milliseconds(config.admission_target_ms),
+                std::chrono::milliseconds(config.admission_interval_ms));
+        }
+        overload_response_ = std::make_shared<const std::string>(
+            "HTTP/1.1 503 Service Unavailable\r\n"
+            "Content-Type: text/plain\r\n"
+            "Retry-After: " + std::to_string(config.admission_retry_after_s) + "\r\n"
+            "Connection: close\r\n"
+            "Content-Length: 19\r\n\r\n"
+            "Service Unavailable");
+        if (config.tenant_classifier) {
+            tenant_classifier_ = config.tenant_classifier;
+            fair_queue_ = std::make_unique<FairQueue>(1, config.tenant_queue_limit);
+            for (const auto& [tenant, weight] : config.tenant_weights) {
+                fair_queue_->setWeight(tenant, weight);
+            }
+        }
+        stream_high_watermark_ = config.stream_high_watermark;
+        stream_low_watermark_ = config.stream_low_watermark;
         print_server_info_with_config(config);
         epoll_fd_ = epoll_create1(0);
         if(epoll_fd_ == -1){
@@ -156,6 +195,9 @@ public:
     }
 
     void run(RequestHandler request_handler);
+
+    /* Routes answered from pre-serialized responses on the IO thread */
+    void set_response_cache(std::shared_ptr<const ResponseCache> cache) { response_cache_ = std::move(cache); }
     
     size_t get_active_connections() const { return conn_manager_->get_active_count(); }
     size_t get_total_requests() const { return total_requests_.load(); }
@@ -168,9 +210,15 @@ public:
         double avg_response_time_ms = 0.0;
         size_t io_thread_load = 0;
         size_t worker_thread_load = 0;
+        size_t worker_thread_target = 0;  /* Size an elastic pool is heading to */
         size_t cooperative_reschedules = 0;
         size_t cooperative_dropped = 0;
+        size_t cooperative_shed = 0;  /* Dropped before any work: the deadline could not be met */
         size_t pending_worker_tasks = 0;
+        size_t response_cache_hits = 0;
+        size_t admission_shed = 0;    /* Refused by admission control without being parsed */
+        size_t cancelled_requests = 0;  /* Skipped before the handler: client gone or deadline passed */
+        size_t tenant_rejected = 0;     /* Refused because the tenant's queue was full */
         std::chrono::steady_clock::time_point timestamp;
     };
     
@@ -184,12 +232,14 @@ protected:
     bool is_request_complete(const std::string& request_data) const;
 
 private:
+    static ThreadPool::ElasticConfig elastic_config(const ServerConfig& config);
     void print_server_info();
     void print_server_info_with_config(const ServerConfig& config);
     void setup_listen_socket();
     
     void on_connection(int client_fd);
     void on_disconnect(int client_fd);
+    void on_disconnect(const std::shared_ptr<ConnectionInfo>& conn_info);
     void handler_new_connection();
     void handler_batch_accept(int& event_index, int num_events, const struct epoll_event* events);
     void handler_client_data(int client_fd);
@@ -198,10 +248,34 @@ private:
     
     /* Three-thread architecture handlers */
     void process_request_with_io_thread(std::shared_ptr<ConnectionInfo> conn_info, const std::string& request_data);
-    void handle_keep_alive_response(std::shared_ptr<ConnectionInfo> conn_info, const std::string& response_data);
+    void handle_keep_alive_response(std::shared_ptr<ConnectionInfo> conn_info, PooledBuffer&& response_data,
+                                    std::vector<BodySegment>&& response_segments = {});
+    /* Completion of a response's last write: close unless the connection is kept alive */
+    ResponseWriter::CompletionCallback response_completion();
+    /*
+     * Run ctx's stream producer on a fiber that takes ctx over; false when the
+     * body was buffered into the response instead and ctx is left in place
+     */
+    bool stream_response(const std::shared_ptr<ConnectionInfo>& conn_info, ObjectPool<Context>::Handle& ctx,
+                         bool keep_alive);
+    /* Stream or serialize ctx's response and hand it to the IO thread; runs later for deferred handlers */
+    void finish_request(const std::shared_ptr<ConnectionInfo>& conn_info, ObjectPool<Context>::Handle& ctx,
+                        bool keep_alive, std::chrono::steady_clock::time_point request_start_time);
+    void fail_request(const std::shared_ptr<ConnectionInfo>& conn_info, const std::exception& e);
+    /* Close the connection of a request dropped as cancelled unless it is already gone */
+    void close_cancelled(const std::shared_ptr<ConnectionInfo>& conn_info);
+    /* A handler that deferred and then threw: keep ctx until its responder lets go of it */
+    static void release_when_sent(ObjectPool<Context>::Handle& ctx);
+    /* Write a deferred response once sent: inline on a worker, else on the connection's reactor */
+    void finish_deferred(std::shared_ptr<ConnectionInfo> conn_info, ObjectPool<Context>::Handle ctx,
+                         bool keep_alive, std::chrono::steady_clock::time_point request_start_time);
     
     /* Error helpers */
     void send_error_response(int client_fd, int status_code, const std::string& message);
+    /* Answer a shed request with the pre-serialized 503 and close */
+    void reply_overloaded(const std::shared_ptr<ConnectionInfo>& conn_info);
+    void reply_error_and_close(const std::shared_ptr<ConnectionInfo>& conn_info, int status_code,
+                               const std::string& message);
     
     /* Network helpers */
     void set_non_blockint(int fd);
@@ -212,6 +286,13 @@ private:
     /* Utility helpers */
     std::string get_peer_address(int fd) const;
     std::string get_local_address(int fd) const;
+    /* Deadline of a raw request: route budget or default_budget (0 = none), tightened by the deadline header */
+    std::chrono::steady_clock::time_point request_deadline(std::string_view request_data,
+                                                            std::chrono::steady_clock::time_point now,
+                                                            std::chrono::milliseconds default_budget) const;
+    /* Cancelled when the connection drops or the deadline passes */
+    static CancellationToken cancellation_for(const std::shared_ptr<ConnectionInfo>& conn_info,
+                                              std::chrono::steady_clock::time_point deadline);
     bool process_cooperative_request(const std::shared_ptr<CooperativeRequestState>& state,
                                      ThreadPool::TaskContext& ctx);
 
@@ -221,6 +302,12 @@ private:
     int listen_fd_;
     int epoll_fd_;
     RequestHandler request_handler_;
+    std::shared_ptr<const ResponseCache> response_cache_;
+    std::unique_ptr<AdmissionController> admission_;  /* Null unless enabled */
+    std::shared_ptr<const std::string> overload_response_;  /* Pre-serialized 503 for shed requests (config ctor) */
+    std::unique_ptr<FairQueue> fair_queue_;  /* Null unless a tenant classifier is configured */
+    RequestClassifier tenant_classifier_;
+    std::atomic<size_t> tenant_rejected_{0};
     std::unique_ptr<ThreadPool> thread_pool_;
     std::unique_ptr<IOThreadPool> io_thread_pool_;  /* IO thread pool */
     std::unique_ptr<ConnectionManager> conn_manager_;
@@ -232,6 +319,7 @@ private:
     /* Detailed performance stats */
     std::atomic<size_t> successful_requests_{0};
     std::atomic<size_t> failed_requests_{0};
+    std::atomic<size_t> response_cache_hits_{0};
     std::atomic<double> total_response_time_ms_{0.0};
     mutable std::atomic<size_t> last_requests_snapshot_{0};
     mutable std::chrono::steady_clock::time_point last_stats_snapshot_;
@@ -262,6 +350,15 @@ private:
     std::chrono::milliseconds cooperative_request_timeout_{200};
     std::atomic<size_t> cooperative_reschedules_{0};
     std::atomic<size_t> cooperative_dropped_{0};
+    std::atomic<size_t> cooperative_shed_{0};
+    std::atomic<size_t> cancelled_requests_{0};
+    std::atomic<int64_t> cooperative_service_us_{0};  /* EWMA of time from first slice to response */
+    std::vector<std::pair<std::string, std::chrono::milliseconds>> route_deadlines_;  /* Longest prefix first */
+    std::string deadline_header_;
+
+    /* Streaming backpressure */
+    size_t stream_high_watermark_{ResponseWriter::DEFAULT_HIGH_WATERMARK};
+    size_t stream_low_watermark_{ResponseWriter::DEFAULT_LOW_WATERMARK};
 };
 
 }
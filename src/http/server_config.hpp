@@ -2,8 +2,13 @@
 #define SERVER_CONFIG_HPP
 
 #include <string>
+#include <chrono>
 #include <cstddef>
 #include <thread>
+#include <utility>
+#include <vector>
+#include "cpu_affinity.hpp"
+#include "fair_queue.hpp"
 #include "http_request.hpp"
 
 namespace Gecko {
@@ -13,6 +18,12 @@ struct ServerConfig {
     std::string host = "0.0.0.0";      /* Bind address */
     size_t thread_pool_size = 0;       /* Worker threads (0 = hw concurrency) */
     size_t io_thread_count = 16;       /* IO threads */
+    size_t max_worker_threads = 0;     /* Elastic ceiling; <= thread_pool_size keeps the pool fixed */
+    int worker_grow_delay_ms = 5;      /* Backlog age that adds a worker */
+    int worker_blocked_ms = 100;       /* A handler running this long no longer counts as a free worker */
+    int worker_idle_timeout_s = 10;    /* Idle time before an extra worker exits */
+    std::vector<int> io_cpus;          /* Reactor i pinned to io_cpus[i % size]; empty = unpinned */
+    std::vector<int> worker_cpus;      /* Likewise for workers, ordered to share a NUMA node with a reactor */
         
     int max_connections = 10000;        /* Max connections */
     int keep_alive_timeout = 30;        /* Keep-Alive timeout (seconds) */
@@ -25,6 +36,18 @@ struct ServerConfig {
     int cooperative_task_priority = 0; /* -1 low, 0 normal, 1 high */
     size_t cooperative_max_slices = 200; /* Max slice requeues before failing */
     int cooperative_request_timeout_ms = 200; /* Per-request deadline in cooperative mode */
+    /* Cooperative deadlines by path prefix, replacing the default; longest prefix wins */
+    std::vector<std::pair<std::string, std::chrono::milliseconds>> route_deadlines;
+    std::string deadline_header = "X-Request-Timeout"; /* Client budget in ms; only tightens the deadline */
+    bool enable_admission_control = false;
+    int admission_target_ms = 5;       /* Acceptable queue delay */
+    int admission_interval_ms = 100;   /* How long the delay must stand above target before shedding */
+    int admission_retry_after_s = 1;   /* Retry-After of the 503 sent to shed requests */
+    RequestClassifier tenant_classifier;  /* Set to queue tenants fairly instead of in one FIFO */
+    std::vector<std::pair<std::string, size_t>> tenant_weights;  /* Unlisted tenants weigh 1 */
+    size_t tenant_queue_limit = 0;      /* Queued requests per tenant before 503; 0 = unbounded */
+    size_t stream_high_watermark = 256 * 1024; /* Queued streamed bytes per connection that block the producer */
+    size_t stream_low_watermark = 64 * 1024;   /* Producer resumes once drained below this */
 
     enum class AcceptStrategy {
         SINGLE,          /* Single accept */
@@ -70,6 +93,20 @@ struct ServerConfig {
         return *this;
     }
     
+    /*
+     * CPU lists such as "0-3,16-19"; throw std::invalid_argument when malformed.
+     * Workers are paired with reactors by NUMA node, and each reactor submits to
+     * its own node's queue, so a request's buffers stay node-local.
+     */
+    ServerConfig& setIOThreadAffinity(std::string_view cpus) {
+        this->io_cpus = parse_cpu_list(cpus);
+        return *this;
+    }
+    ServerConfig& setWorkerAffinity(std::string_view cpus) {
+        this->worker_cpus = parse_cpu_list(cpus);
+        return *this;
+    }
+    
     ServerConfig& setMaxConnections(int max_conn) {
         this->max_connections = max_conn;
         return *this;
@@ -100,11 +137,56 @@ struct ServerConfig {
         this->cooperative_request_timeout_ms = request_timeout_ms;
         return *this;
     }
+    /* Shed new requests with a 503 while worker queue delay stands above target for an interval;
+       rejections are spaced interval/sqrt(count) apart, and answered before the request is parsed */
+    ServerConfig& enableAdmissionControl(int target_ms = 5, int interval_ms = 100, int retry_after_s = 1) {
+        this->enable_admission_control = true;
+        this->admission_target_ms = target_ms;
+        this->admission_interval_ms = interval_ms;
+        this->admission_retry_after_s = retry_after_s;
+        return *this;
+    }
+    /* Grow the worker pool up to max_threads under backlog or blocking handlers, shrink back when idle */
+    ServerConfig& enableElasticWorkers(size_t max_threads, int grow_delay_ms = 5, int idle_timeout_s = 10,
+                                       int blocked_ms = 100) {
+        this->max_worker_threads = max_threads;
+        this->worker_grow_delay_ms = grow_delay_ms;
+        this->worker_idle_timeout_s = idle_timeout_s;
+        this->worker_blocked_ms = blocked_ms;
+        return *this;
+    }
+    /* Deficit round-robin between the classes classifier assigns (see Classifiers); not in cooperative mode */
+    ServerConfig& enableFairQueuing(RequestClassifier classifier, size_t per_tenant_limit = 0) {
+        this->tenant_classifier = std::move(classifier);
+        this->tenant_queue_limit = per_tenant_limit;
+        return *this;
+    }
+    ServerConfig& setTenantWeight(const std::string& tenant, size_t weight) {
+        this->tenant_weights.emplace_back(tenant, weight);
+        return *this;
+    }
+    /* A stream producer parks once high bytes are queued on its connection and resumes below low */
+    ServerConfig& setStreamWatermarks(size_t high, size_t low) {
+        this->stream_high_watermark = high;
+        this->stream_low_watermark = low;
+        return *this;
+    }
     ServerConfig& setCooperativeLimits(size_t max_slices, int request_timeout_ms) {
         this->cooperative_max_slices = max_slices;
         this->cooperative_request_timeout_ms = request_timeout_ms;
         return *this;
     }
+    /* Budget for paths under path_prefix (longest prefix wins); a tighter client budget overrides it.
+       Cooperative mode sheds a request with a 503 up front when it cannot finish in time */
+    ServerConfig& setRouteDeadline(const std::string& path_prefix, int budget_ms) {
+        this->route_deadlines.emplace_back(path_prefix, std::chrono::milliseconds(budget_ms));
+        return *this;
+    }
+    /* Empty name ignores client-supplied budgets */
+    ServerConfig& setDeadlineHeader(const std::string& name) {
+        this->deadline_header = name;
+        return *this;
+    }
 
 
 };
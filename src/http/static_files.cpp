@@ -0,0 +1,373 @@
+#include "static_files.hpp"
+#include "compression.hpp"
+#include "file_response.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <sys/stat.h>
+
+namespace Gecko {
+
+namespace {
+
+struct EncodingSuffix {
+    std::string_view encoding;
+    std::string_view suffix;
+};
+
+/* Server preference when the client weighs several encodings equally */
+constexpr std::array<EncodingSuffix, 3> PRECOMPRESSED = {{
+    {"br", ".br"},
+    {"zstd", ".zst"},
+    {"gzip", ".gz"},
+}};
+
+/* Sources remembered before the sibling memo starts over */
+constexpr size_t MAX_SIBLING_ENTRIES = 4096;
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Percent-decoding for paths: unlike query decoding, '+' stays literal */
+std::string percentDecode(std::string_view input) {
+    std::string out;
+    out.reserve(input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        if (input[i] == '%' && i + 2 < input.size()) {
+            int high = hexValue(input[i + 1]);
+            int low = hexValue(input[i + 2]);
+            if (high >= 0 && low >= 0) {
+                out += static_cast<char>(high * 16 + low);
+                i += 2;
+                continue;
+            }
+        }
+        out += input[i];
+    }
+    return out;
+}
+
+void notFound(Context& ctx) {
+    ctx.status(404).string("404 Not Found");
+}
+
+} // namespace
+
+StaticFiles::StaticFiles(std::string root, StaticOptions options)
+    : root_(std::move(root)), options_(std::move(options)) {
+    while (root_.size() > 1 && root_.back() == '/') {
+        root_.pop_back();
+    }
+    if (options_.compress_at_startup && compressionAvailable()) {
+        compressTree();
+    }
+    if (options_.cache_budget > 0) {
+        cache_ = std::make_unique<AssetCache>(options_.cache_budget);
+        if (!cache_->enabled()) {
+            cache_.reset();
+        }
+    }
+}
+
+std::optional<std::string> StaticFiles::resolve(const std::string& relative) const {
+    std::string_view raw(relative);
+    raw = raw.substr(0, raw.find('?'));
+    std::string decoded = percentDecode(raw);
+
+    std::string path = root_;
+    size_t start = 0;
+    while (start <= decoded.size()) {
+        size_t slash = decoded.find('/', start);
+        if (slash == std::string::npos) slash = decoded.size();
+        std::string_view segment(decoded.data() + start, slash - start);
+        start = slash + 1;
+
+        if (segment.empty() || segment == ".") continue;
+        if (segment == ".." || segment.find('\0') != std::string_view::npos) {
+            return std::nullopt;
+        }
+        path += '/';
+        path.append(segment);
+    }
+    if (decoded.empty() || decoded.back() == '/') {
+        path += '/';
+        path += options_.index_file;
+    }
+    return path;
+}
+
+void StaticFiles::serve(Context& ctx, const std::string& relative) const {
+    auto path = resolve(relative);
+    if (!path) {
+        notFound(ctx);
+        return;
+    }
+    if (cache_) {
+        if (auto asset = cache_->find(*path)) {
+            serveCached(ctx, *asset);
+            return;
+        }
+    }
+
+    /* Snapshot and watch before reading, so a concurrent change voids the insert */
+    uint64_t epoch = cache_ ? cache_->epoch() : 0;
+    bool cacheable = cache_ && cache_->watch(*path);
+
+    std::shared_ptr<const FileHandle> file;
+    try {
+        file = FileHandle::open(*path);
+    } catch (const std::exception&) {
+        notFound(ctx);
+        return;
+    }
+
+    if (cacheable && file->size() <= options_.cache_max_asset_size) {
+        if (auto asset = load(*path, file)) {
+            cache_->insert(*path, asset, epoch);
+            serveCached(ctx, *asset);
+            return;
+        }
+    }
+
+    Variant variant = negotiate(ctx, *path, file);
+    std::string_view content_type = mimeType(*path);
+    std::string tag = entityTag(*file, variant.encoding);
+    HttpResponse& response = ctx.response();
+    response.addHeader("Content-Type", std::string(content_type));
+    response.addHeader("Last-Modified", httpDate(file->mtime()));
+    response.addHeader("ETag", tag);
+    if (options_.precompressed || !generated_.empty()) {
+        response.addHeader("Vary", "Accept-Encoding");
+    }
+    if (!variant.encoding.empty()) {
+        response.addHeader("Content-Encoding", std::string(variant.encoding));
+    }
+    response.addHeader("Accept-Ranges", "bytes");
+
+    /* Validators and ranges refer to the chosen variant */
+    auto result = evaluateConditional(ctx.request(), tag, file->mtime(), variant.size());
+    applyConditional(ctx.request(), response, result, BodySource{variant.file, variant.memory}, content_type);
+}
+
+/* Best cached variant for Accept-Encoding; headers and body are shared, not rebuilt */
+void StaticFiles::serveCached(Context& ctx, const CachedAsset& asset) const {
+    const CachedAsset::Variant* chosen = &asset.variants.front();
+    const auto& headers = ctx.request().getHeaders();
+    auto accept = headers.find("Accept-Encoding");
+    if (accept != headers.end() && !accept->second.empty()) {
+        double best_q = 0.0;
+        for (const auto& variant : asset.variants) {
+            if (variant.encoding.empty()) continue;
+            double q = encodingQuality(accept->second, variant.encoding);
+            if (q > best_q) {
+                best_q = q;
+                chosen = &variant;
+            }
+        }
+    }
+
+    auto result = evaluateConditional(ctx.request(), chosen->etag, asset.last_modified, chosen->body->size());
+    HttpResponse& response = ctx.response();
+    if (result.outcome == ConditionalResult::Outcome::PARTIAL && result.ranges.size() > 1) {
+        /* multipart/byteranges sets its own Content-Type: drop the leading line */
+        size_t type_line = std::string_view("Content-Type: ").size() + asset.content_type.size() + 2;
+        response.setHeaderBlock(std::make_shared<const std::string>(chosen->headers->substr(type_line)));
+    } else {
+        response.setHeaderBlock(chosen->headers);
+    }
+    applyConditional(ctx.request(), response, result, BodySource{nullptr, chosen->body}, asset.content_type);
+}
+
+/* Read a file and its fresh variants into a cache entry; nullptr if a read fails */
+std::shared_ptr<const CachedAsset> StaticFiles::load(const std::string& path,
+                                                     const std::shared_ptr<const FileHandle>& identity) const {
+    auto read = [](const std::shared_ptr<const FileHandle>& file) {
+        std::string contents(file->size(), '\0');
+        copySegment(FileSegment{file, 0, file->size()}, contents.data());
+        return std::make_shared<const std::string>(std::move(contents));
+    };
+
+    auto asset = std::make_shared<CachedAsset>();
+    asset->content_type = std::string(mimeType(path));
+    asset->last_modified = identity->mtime();
+    try {
+        asset->variants.push_back(CachedAsset::Variant{
+            "", entityTag(*identity), read(identity),
+            std::make_shared<const std::string>(headerLines(path, *identity, {}))});
+
+        for (const auto& candidate : PRECOMPRESSED) {
+            std::shared_ptr<const std::string> body;
+            if (options_.precompressed) {
+                try {
+                    auto sibling = FileHandle::open(path + std::string(candidate.suffix));
+                    if (sibling->mtime() >= identity->mtime()) {
+                        body = read(sibling);
+                    }
+                } catch (const std::runtime_error&) {
+                    /* No such variant */
+                }
+            }
+            if (!body && candidate.encoding == "gzip") {
+                auto generated = generated_.find(path);
+                if (generated != generated_.end() &&
+                    generated->second.source_mtime == identity->mtime() &&
+                    generated->second.source_size == identity->size()) {
+                    body = generated->second.gzip;
+                }
+            }
+            if (body) {
+                asset->variants.push_back(CachedAsset::Variant{
+                    std::string(candidate.encoding), entityTag(*identity, candidate.encoding), std::move(body),
+                    std::make_shared<const std::string>(headerLines(path, *identity, candidate.encoding))});
+            }
+        }
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+    return asset;
+}
+
+std::string StaticFiles::headerLines(const std::string& path, const FileHandle& identity,
+                                     std::string_view encoding) const {
+    std::string lines;
+    auto line = [&lines](std::string_view key, std::string_view value) {
+        lines.append(key);
+        lines += ": ";
+        lines.append(value);
+        lines += "\r\n";
+    };
+    line("Content-Type", mimeType(path));
+    line("Last-Modified", httpDate(identity.mtime()));
+    line("ETag", entityTag(identity, encoding));
+    if (options_.precompressed || !generated_.empty()) {
+        line("Vary", "Accept-Encoding");
+    }
+    if (!encoding.empty()) {
+        line("Content-Encoding", encoding);
+    }
+    line("Accept-Ranges", "bytes");
+    return lines;
+}
+
+/* Highest-q encoding among the variants that exist; identity when none is accepted */
+StaticFiles::Variant StaticFiles::negotiate(const Context& ctx, const std::string& path,
+                                            const std::shared_ptr<const FileHandle>& identity) const {
+    Variant chosen{{}, identity, nullptr};
+    const auto& headers = ctx.request().getHeaders();
+    auto accept = headers.find("Accept-Encoding");
+    if (accept == headers.end() || accept->second.empty()) {
+        return chosen;
+    }
+
+    uint8_t present = options_.precompressed ? siblingsOf(path, *identity) : 0;
+    double best_q = 0.0;
+    for (size_t i = 0; i < PRECOMPRESSED.size(); ++i) {
+        const auto& candidate = PRECOMPRESSED[i];
+        double q = encodingQuality(accept->second, candidate.encoding);
+        if (q <= best_q) continue;
+
+        if (present & (1u << i)) {
+            try {
+                auto sibling = FileHandle::open(path + std::string(candidate.suffix));
+                if (sibling->mtime() >= identity->mtime()) {
+                    chosen = Variant{candidate.encoding, std::move(sibling), nullptr};
+                    best_q = q;
+                    continue;
+                }
+            } catch (const std::exception&) {
+                /* Gone since it was probed */
+            }
+            forgetSiblings(path);
+        }
+        if (candidate.encoding == "gzip") {
+            auto generated = generated_.find(path);
+            if (generated != generated_.end() &&
+                generated->second.source_mtime == identity->mtime() &&
+                generated->second.source_size == identity->size()) {
+                chosen = Variant{candidate.encoding, nullptr, generated->second.gzip};
+                best_q = q;
+            }
+        }
+    }
+    return chosen;
+}
+
+/* Which siblings exist and are not older than their source; probed once per source version */
+uint8_t StaticFiles::siblingsOf(const std::string& path, const FileHandle& identity) const {
+    uint64_t epoch = cache_ ? cache_->epoch() : 0;
+    {
+        std::shared_lock<std::shared_mutex> lock(siblings_mutex_);
+        auto it = siblings_.find(path);
+        if (it != siblings_.end() && it->second.source_mtime == identity.mtime() &&
+            it->second.source_size == identity.size() && it->second.epoch == epoch) {
+            return it->second.present;
+        }
+    }
+
+    uint8_t present = 0;
+    for (size_t i = 0; i < PRECOMPRESSED.size(); ++i) {
+        struct stat st;
+        std::string sibling = path + std::string(PRECOMPRESSED[i].suffix);
+        if (::stat(sibling.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_mtime >= identity.mtime()) {
+            present |= static_cast<uint8_t>(1u << i);
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(siblings_mutex_);
+    if (siblings_.size() >= MAX_SIBLING_ENTRIES && !siblings_.count(path)) {
+        siblings_.clear();
+    }
+    siblings_[path] = Siblings{identity.mtime(), identity.size(), epoch, present};
+    return present;
+}
+
+void StaticFiles::forgetSiblings(const std::string& path) const {
+    std::unique_lock<std::shared_mutex> lock(siblings_mutex_);
+    siblings_.erase(path);
+}
+
+/* gzip every compressible file that has no .gz sibling and actually shrinks */
+void StaticFiles::compressTree() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root_, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        std::string path = it->path().string();
+        if (!isCompressibleType(mimeType(path))) continue;
+        if (fs::exists(path + ".gz", ec)) continue;
+
+        std::shared_ptr<const FileHandle> file;
+        try {
+            file = FileHandle::open(path);
+        } catch (const std::exception&) {
+            continue;
+        }
+        if (file->size() < options_.min_compress_size || file->size() > options_.max_compress_size) {
+            continue;
+        }
+
+        std::string contents(file->size(), '\0');
+        try {
+            copySegment(FileSegment{file, 0, file->size()}, contents.data());
+        } catch (const std::exception&) {
+            continue;
+        }
+        std::string compressed;
+        if (!compressBody(ContentEncoding::GZIP, 9, contents, compressed) ||
+            compressed.size() >= contents.size()) {
+            continue;
+        }
+        generated_[path] = GeneratedVariant{
+            file->mtime(), file->size(), std::make_shared<const std::string>(std::move(compressed))};
+    }
+}
+
+} /* namespace Gecko */
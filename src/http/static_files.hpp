@@ -0,0 +1,106 @@
+#ifndef STATIC_FILES_HPP
+#define STATIC_FILES_HPP
+
+#include "asset_cache.hpp"
+#include "body_segment.hpp"
+#include "context.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Gecko {
+
+struct StaticOptions {
+    std::string index_file = "index.html";
+    bool precompressed = true;          /* Serve name.br / name.zst / name.gz when accepted */
+    bool compress_at_startup = false;   /* gzip text assets without a .gz sibling into memory */
+    size_t min_compress_size = 1024;
+    size_t max_compress_size = 8 * 1024 * 1024;
+    size_t cache_budget = 0;                    /* Bytes of hot assets held in memory; 0 disables */
+    size_t cache_max_asset_size = 256 * 1024;   /* Larger files always go through sendfile */
+};
+
+/*
+ * Files under a root directory, sent with sendfile, honouring conditional
+ * and Range requests (see file_response.hpp). Encoded variants are
+ * never produced per request: the best of the precompressed siblings (or
+ * the startup-compressed copy) allowed by Accept-Encoding is served as is,
+ * with Content-Encoding and Vary set.
+ *
+ * With a cache budget, small files are kept in an AssetCache together with
+ * their variants, ETags and pre-serialized headers; a hit is one lookup and
+ * no filesystem access.
+ *
+ * Files served from disk remember which fresh siblings exist, so a request
+ * opens only the variant it sends. The memo is dropped when the source
+ * changes or, with a cache, when anything under a watched directory does;
+ * without one a sibling added later is seen once its source changes.
+ */
+class StaticFiles {
+public:
+    explicit StaticFiles(std::string root, StaticOptions options = StaticOptions());
+
+    /* Answer ctx for relative (the route's catch-all capture) */
+    void serve(Context& ctx, const std::string& relative) const;
+
+    /* Filesystem path for relative, or nullopt if it escapes the root */
+    std::optional<std::string> resolve(const std::string& relative) const;
+
+    const std::string& root() const { return root_; }
+    size_t generated_variants() const { return generated_.size(); }
+    /* nullptr unless options.cache_budget is set and inotify is available */
+    AssetCache* cache() const { return cache_.get(); }
+
+private:
+    /* A representation of one file: a sibling on disk or a buffer built at startup */
+    struct Variant {
+        std::string_view encoding;  /* Empty for identity */
+        std::shared_ptr<const FileHandle> file;
+        std::shared_ptr<const std::string> memory;
+
+        size_t size() const { return file ? file->size() : memory->size(); }
+    };
+
+    /* Fresh precompressed siblings of one source, bit i for PRECOMPRESSED[i] */
+    struct Siblings {
+        time_t source_mtime;
+        size_t source_size;
+        uint64_t epoch;  /* AssetCache epoch when probed; 0 without a cache */
+        uint8_t present;
+    };
+
+    struct GeneratedVariant {
+        time_t source_mtime;
+        size_t source_size;
+        std::shared_ptr<const std::string> gzip;
+    };
+
+    void compressTree();
+    std::shared_ptr<const CachedAsset> load(const std::string& path,
+                                            const std::shared_ptr<const FileHandle>& identity) const;
+    void serveCached(Context& ctx, const CachedAsset& asset) const;
+    std::string headerLines(const std::string& path, const FileHandle& identity,
+                            std::string_view encoding) const;
+    Variant negotiate(const Context& ctx, const std::string& path,
+                      const std::shared_ptr<const FileHandle>& identity) const;
+    uint8_t siblingsOf(const std::string& path, const FileHandle& identity) const;
+    void forgetSiblings(const std::string& path) const;
+
+    std::string root_;
+    StaticOptions options_;
+    /* Keyed by filesystem path; written only by the constructor */
+    std::unordered_map<std::string, GeneratedVariant> generated_;
+    std::unique_ptr<AssetCache> cache_;
+    mutable std::shared_mutex siblings_mutex_;
+    mutable std::unordered_map<std::string, Siblings> siblings_;
+};
+
+} /* namespace Gecko */
+
+#endif /* STATIC_FILES_HPP */
@@ -0,0 +1,115 @@
+#ifndef TASK_SLOT_HPP
+#define TASK_SLOT_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Gecko {
+
+/*
+ * Move-only void() callable with inline storage. Callables up to
+ * INLINE_SIZE bytes (a lambda capturing `this`, a shared_ptr, a string and a
+ * timestamp) live inside the slot; larger or over-aligned ones fall back to
+ * the heap. Unlike std::function it accepts move-only captures and never
+ * allocates for the common case.
+ */
+class TaskSlot {
+public:
+    static constexpr size_t INLINE_SIZE = 64;
+
+    template <typename F>
+    static constexpr bool fits_inline =
+        sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible<F>::value;
+
+    TaskSlot() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, TaskSlot>::value>>
+    TaskSlot(F&& f) {
+        emplace(std::forward<F>(f));
+    }
+
+    TaskSlot(TaskSlot&& other) noexcept { take(other); }
+
+    TaskSlot& operator=(TaskSlot&& other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    TaskSlot(const TaskSlot&) = delete;
+    TaskSlot& operator=(const TaskSlot&) = delete;
+
+    ~TaskSlot() { reset(); }
+
+    /* Replace the held callable */
+    template <typename F>
+    void emplace(F&& f) {
+        using Fn = std::decay_t<F>;
+        reset();
+        if constexpr (fits_inline<Fn>) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+        } else {
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+        }
+        ops_ = &OpsFor<Fn>::table;
+    }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    void operator()() { ops_->invoke(storage_); }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* from, void* to);  /* Move-constructs into to and destroys from */
+        void (*destroy)(void* storage);
+    };
+
+    template <typename Fn, bool Inline = fits_inline<Fn>>
+    struct OpsFor {
+        static void invoke(void* storage) { (*std::launder(static_cast<Fn*>(storage)))(); }
+        static void move(void* from, void* to) {
+            Fn* source = std::launder(static_cast<Fn*>(from));
+            ::new (to) Fn(std::move(*source));
+            source->~Fn();
+        }
+        static void destroy(void* storage) { std::launder(static_cast<Fn*>(storage))->~Fn(); }
+        static constexpr Ops table{&invoke, &move, &destroy};
+    };
+
+    template <typename Fn>
+    struct OpsFor<Fn, false> {
+        static Fn*& held(void* storage) { return *std::launder(static_cast<Fn**>(storage)); }
+        static void invoke(void* storage) { (*held(storage))(); }
+        static void move(void* from, void* to) { ::new (to) Fn*(held(from)); }
+        static void destroy(void* storage) { delete held(storage); }
+        static constexpr Ops table{&invoke, &move, &destroy};
+    };
+
+    void take(TaskSlot& other) noexcept {
+        if (other.ops_) {
+            other.ops_->move(other.storage_, storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+};
+
+} /* namespace Gecko */
+
+#endif /* TASK_SLOT_HPP */
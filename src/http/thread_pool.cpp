@@ -1,101 +1,123 @@
 #include "thread_pool.hpp"
+#include "cpu_affinity.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace Gecko {
 
-ThreadPool::ThreadPool(size_t thread_count, bool cooperative_mode, std::chrono::milliseconds default_time_slice) 
-    : stop_(false), cooperative_mode_(cooperative_mode), default_time_slice_(default_time_slice) {
+thread_local ThreadPool* ThreadPool::t_current_pool_ = nullptr;
+thread_local size_t ThreadPool::t_worker_index_ = 0;
+thread_local int ThreadPool::t_submitter_node_ = -1;
+
+namespace {
+
+/* Victim selection for stealing; xorshift is plenty and needs no lock */
+size_t next_random() {
+    thread_local std::uint64_t state =
+        0x9E3779B97F4A7C15ull ^ std::hash<std::thread::id>{}(std::this_thread::get_id());
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return static_cast<size_t>(state);
+}
+
+void run_task(TaskSlot& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "Thread pool task threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Thread pool task threw an unknown exception" << std::endl;
+    }
+}
+}
+
+ThreadPool* ThreadPool::current() {
+    return t_current_pool_;
+}
+
+ThreadPool::ThreadPool(size_t thread_count, bool cooperative_mode, std::chrono::milliseconds default_time_slice,
+                       ElasticConfig elastic, std::vector<int> cpus)
+    : elastic_(elastic), stop_(false), cooperative_mode_(cooperative_mode), default_time_slice_(default_time_slice) {
     if (thread_count == 0) {
         thread_count = std::thread::hardware_concurrency();
         if (thread_count == 0) {
             thread_count = 4; /* Default to four threads */
         }
     }
-    
-    std::cout << "[THREAD] Creating thread pool, thread count: " << thread_count << std::endl;
-    
+    core_threads_ = thread_count;
+    size_t max_threads = std::max(thread_count, elastic_.max_threads);
+    elastic_enabled_ = max_threads > thread_count;
+
+    std::cout << "[THREAD] Creating thread pool, thread count: " << thread_count;
+    if (elastic_enabled_) {
+        std::cout << " (elastic up to " << max_threads << ")";
+    }
+    std::cout << std::endl;
+
+    /* Entries never move; victims whose Worker is not allocated yet are skipped */
+    workers_ = std::vector<WorkerEntry>(max_threads);
+    if (!cpus.empty()) {
+        for (size_t i = 0; i < max_threads; ++i) {
+            workers_[i].cpu = cpus[i % cpus.size()];
+            workers_[i].node = numa_node_of(workers_[i].cpu);
+            multi_node_ = multi_node_ || workers_[i].node != workers_[0].node;
+        }
+    }
+    /* One injection queue per node, in order of first appearance */
+    for (auto& entry : workers_) {
+        size_t node = static_cast<size_t>(std::max(entry.node, 0));
+        if (node >= node_injection_.size()) {
+            node_injection_.resize(node + 1, SIZE_MAX);
+        }
+        if (node_injection_[node] == SIZE_MAX) {
+            node_injection_[node] = injection_.size();
+            injection_.push_back(std::make_unique<InjectionQueue>());
+        }
+        entry.injection = node_injection_[node];
+    }
+    for (size_t& index : node_injection_) {
+        if (index == SIZE_MAX) {
+            index = injection_.size();
+        }
+    }
+    threads_.resize(max_threads);
+    target_threads_.store(thread_count, std::memory_order_relaxed);
+
     /* Spawn worker threads */
     for (size_t i = 0; i < thread_count; ++i) {
-        threads_.emplace_back([this] {
-            while (true) {
-                std::function<void()> task;
-                ScheduledTask coop_task;
-                bool has_coop_task = false;
-
-                {
-                    std::unique_lock<std::mutex> lock(queue_mutex_);
-                    
-                    /* Wait for work or stop signal */
-                    condition_.wait(lock, [this] {
-                        return stop_ || !tasks_.empty() || !coop_tasks_.empty();
-                    });
-                    
-                    /* Exit when stopping and queues are empty */
-                    if (stop_ && tasks_.empty() && coop_tasks_.empty()) {
-                        return;
-                    }
-                    
-                    if (cooperative_mode_ && !coop_tasks_.empty()) {
-                        coop_task = coop_tasks_.top();
-                        coop_tasks_.pop();
-                        has_coop_task = true;
-                    } else if (!tasks_.empty()) {
-                        task = std::move(tasks_.front());
-                        tasks_.pop();
-                    } else if (!coop_tasks_.empty()) {
-                        coop_task = coop_tasks_.top();
-                        coop_tasks_.pop();
-                        has_coop_task = true;
-                    }
-                }
-                
-                if (has_coop_task) {
-                    TaskContext ctx{std::chrono::steady_clock::now() + coop_task.time_slice};
-                    bool completed = true;
-                    try {
-                        completed = coop_task.task(ctx);
-                    } catch (const std::exception& e) {
-                        std::cerr << "Thread pool task threw an exception: " << e.what() << std::endl;
-                    } catch (...) {
-                        std::cerr << "Thread pool task threw an unknown exception" << std::endl;
-                    }
-
-                    if (!completed && !stop_) {
-                        std::unique_lock<std::mutex> lock(queue_mutex_);
-                        coop_tasks_.push(ScheduledTask{
-                            coop_task.priority,
-                            next_sequence_++,
-                            coop_task.task,
-                            coop_task.time_slice
-                        });
-                        condition_.notify_one();
-                    }
-                    continue;
-                }
-
-                /* Execute regular task */
-                if (task) {
-                    try {
-                        task();
-                    } catch (const std::exception& e) {
-                    std::cerr << "Thread pool task threw an exception: " << e.what() << std::endl;
-                    } catch (...) {
-                        std::cerr << "Thread pool task threw an unknown exception" << std::endl;
-                    }
-                }
-            }
-        });
+        start_worker(i);
+    }
+    if (elastic_enabled_) {
+        supervisor_ = std::thread([this] { supervise(); });
     }
 }
 
 ThreadPool::~ThreadPool() {
     {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
+        /* Under every queue lock, so no post() slips in after the workers saw stop_ */
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (auto& injection : injection_) {
+            locks.emplace_back(injection->mutex);
+        }
         stop_ = true;
     }
+
+    /* The supervisor owns burst slots; it must be gone before they are joined */
+    if (supervisor_.joinable()) {
+        {
+            std::unique_lock<std::mutex> lock(supervisor_mutex_);
+        }
+        supervisor_condition_.notify_all();
+        supervisor_.join();
+    }
     
     /* Wake up all threads */
-    condition_.notify_all();
+    {
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        ++wake_epoch_;
+    }
+    park_condition_.notify_all();
     
     /* Join all threads */
     for (std::thread& thread : threads_) {
@@ -103,6 +125,21 @@ ThreadPool::~ThreadPool() {
             thread.join();
         }
     }
+
+    /* Workers drain everything before exiting; this only guards against leaks */
+    for (auto& entry : workers_) {
+        Worker* worker = entry.get();
+        if (!worker) {
+            continue;
+        }
+        while (TaskSlot* slot = worker->queue.steal()) {
+            delete slot;
+        }
+        for (TaskSlot* slot : worker->free_slots) {
+            delete slot;
+        }
+        delete worker;
+    }
     
     std::cout << "[THREAD] Thread pool stopped" << std::endl;
 }
@@ -114,4 +151,358 @@ void ThreadPool::enable_cooperative_mode(std::chrono::milliseconds default_slice
     }
 }
 
+size_t ThreadPool::pending_tasks() const {
+    size_t pending = injection_size_.load(std::memory_order_relaxed) +
+                     coop_size_.load(std::memory_order_relaxed);
+    for (const auto& entry : workers_) {
+        if (const Worker* worker = entry.get()) {
+            pending += worker->queue.size();
+        }
+    }
+    return pending;
+}
+
+TaskSlot* ThreadPool::acquire_slot(Worker& worker) {
+    if (worker.free_slots.empty()) {
+        return new TaskSlot();
+    }
+    TaskSlot* slot = worker.free_slots.back();
+    worker.free_slots.pop_back();
+    return slot;
+}
+
+void ThreadPool::release_slot(Worker& worker, TaskSlot* slot) {
+    slot->reset();
+    if (worker.free_slots.size() >= MAX_FREE_SLOTS) {
+        delete slot;
+        return;
+    }
+    worker.free_slots.push_back(slot);
+}
+
+void ThreadPool::start_worker(size_t index) {
+    workers_[index].running.store(true, std::memory_order_relaxed);
+    active_threads_.fetch_add(1, std::memory_order_relaxed);
+    threads_[index] = std::thread([this, index] {
+        worker_loop(index);
+    });
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    t_current_pool_ = this;
+    t_worker_index_ = index;
+    WorkerEntry& entry = workers_[index];
+    const bool burst = index >= core_threads_;
+    /* Pin first: everything this thread allocates from here on is first touched on its node */
+    if (entry.cpu >= 0 && !pin_current_thread(entry.cpu)) {
+        std::cerr << "[THREAD] Could not pin worker " << index << " to CPU " << entry.cpu << std::endl;
+    }
+    /* A restarted burst worker finds the Worker its predecessor allocated */
+    if (!entry.get()) {
+        entry.worker.store(new Worker(), std::memory_order_release);
+    }
+    Worker& worker = *entry.get();
+    auto idle_since = std::chrono::steady_clock::now();
+
+    size_t idle_rounds = 0;
+    while (true) {
+        if (cooperative_mode_ && run_cooperative_task()) {
+            idle_rounds = 0;
+            continue;
+        }
+
+        if (TaskSlot* slot = find_task(index)) {
+            if (elastic_enabled_) {
+                worker.task_started.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                                          std::memory_order_relaxed);
+            }
+            run_task(*slot);
+            worker.task_started.store(0, std::memory_order_relaxed);
+            release_slot(worker, slot);
+            idle_rounds = 0;
+            idle_since = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        if (run_cooperative_task()) {
+            idle_rounds = 0;
+            idle_since = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        /* Exit when stopping and no work is left anywhere */
+        if (stop_ && !has_visible_work()) {
+            break;
+        }
+
+        /* Work usually arrives in bursts: spin a little before paying for a futex wait */
+        if (idle_rounds++ < SPIN_ROUNDS) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle_rounds = 0;
+        if (!burst) {
+            park();
+            continue;
+        }
+        /* Burst worker: a timed-out park with nothing in sight means the pool can shrink */
+        if (!park(idle_since + elastic_.idle_timeout) && worker.queue.empty() && !has_visible_work()) {
+            break;
+        }
+    }
+    if (burst) {
+        entry.running.store(false, std::memory_order_release);
+    }
+    active_threads_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+TaskSlot* ThreadPool::find_task(size_t index) {
+    if (TaskSlot* slot = workers_[index].get()->queue.pop()) {
+        return slot;
+    }
+    if (TaskSlot* slot = take_injected(index)) {
+        return slot;
+    }
+
+    size_t count = workers_.size();
+    if (count < 2) {
+        return nullptr;
+    }
+    size_t start = next_random() % count;
+    int node = workers_[index].node;
+    /* Same-node victims first; the second pass only runs when workers span nodes */
+    for (int pass = 0; pass < (multi_node_ ? 2 : 1); ++pass) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t victim = (start + i) % count;
+            if (victim == index || (multi_node_ && (workers_[victim].node == node) != (pass == 0))) {
+                continue;
+            }
+            Worker* victim_worker = workers_[victim].get();
+            if (!victim_worker) {
+                continue;
+            }
+            if (TaskSlot* slot = victim_worker->queue.steal()) {
+                stolen_tasks_.fetch_add(1, std::memory_order_relaxed);
+                return slot;
+            }
+        }
+    }
+    return nullptr;
+}
+
+TaskSlot* ThreadPool::take_injected(size_t index) {
+    if (injection_size_.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+
+    /* Own node's queue first, then the others in order */
+    WorkerEntry& entry = workers_[index];
+    size_t count = injection_.size();
+    for (size_t i = 0; i < count; ++i) {
+        InjectionQueue& injection = *injection_[(entry.injection + i) % count];
+        if (injection.size.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        if (TaskSlot* slot = take_injected_from(injection, *entry.get())) {
+            return slot;
+        }
+    }
+    return nullptr;
+}
+
+TaskSlot* ThreadPool::take_injected_from(InjectionQueue& injection, Worker& worker) {
+    /* Take a fair share in one lock round trip; the surplus becomes stealable */
+    std::unique_lock<std::mutex> lock(injection.mutex);
+    if (injection.tasks.empty()) {
+        return nullptr;
+    }
+    size_t batch = injection.tasks.size() / std::max<size_t>(active_threads_.load(std::memory_order_relaxed), 1) + 1;
+    if (batch > INJECTION_BATCH) {
+        batch = INJECTION_BATCH;
+    }
+    TaskSlot* first = acquire_slot(worker);
+    *first = std::move(injection.tasks.front());
+    injection.tasks.pop_front();
+    size_t taken = 1;
+    for (; taken < batch && !injection.tasks.empty(); ++taken) {
+        TaskSlot* slot = acquire_slot(worker);
+        *slot = std::move(injection.tasks.front());
+        injection.tasks.pop_front();
+        worker.queue.push(slot);
+    }
+    injection.size.store(injection.tasks.size(), std::memory_order_release);
+    injection_size_.fetch_sub(taken, std::memory_order_release);
+    return first;
+}
+
+size_t ThreadPool::injection_index() {
+    size_t count = injection_.size();
+    if (count == 1) {
+        return 0;
+    }
+    int node = t_submitter_node_;
+    if (node >= 0 && static_cast<size_t>(node) < node_injection_.size() &&
+        node_injection_[node] < count) {
+        return node_injection_[node];
+    }
+    /* Unplaced submitter, or no worker on its node */
+    return next_injection_.fetch_add(1, std::memory_order_relaxed) % count;
+}
+
+bool ThreadPool::run_cooperative_task() {
+    if (coop_size_.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    ScheduledTask coop_task;
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (coop_tasks_.empty()) {
+            return false;
+        }
+        coop_task = coop_tasks_.top();
+        coop_tasks_.pop();
+        coop_size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    TaskContext ctx{std::chrono::steady_clock::now() + coop_task.time_slice, coop_task.deadline};
+    bool completed = true;
+    try {
+        completed = coop_task.task(ctx);
+    } catch (const std::exception& e) {
+        std::cerr << "Thread pool task threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Thread pool task threw an unknown exception" << std::endl;
+    }
+
+    if (!completed && !stop_) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            coop_tasks_.push(ScheduledTask{
+                coop_task.priority,
+                next_sequence_++,
+                coop_task.deadline,
+                coop_task.task,
+                coop_task.time_slice
+            });
+            coop_size_.fetch_add(1, std::memory_order_relaxed);
+        }
+        wake_one();
+    }
+    return true;
+}
+
+bool ThreadPool::has_visible_work() const {
+    if (injection_size_.load(std::memory_order_acquire) > 0 ||
+        coop_size_.load(std::memory_order_acquire) > 0) {
+        return true;
+    }
+    for (const auto& entry : workers_) {
+        const Worker* worker = entry.get();
+        if (worker && !worker->queue.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::park(TimePoint until) {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    std::uint64_t epoch = wake_epoch_;
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    /* Pairs with the fence in wake_one(): either we see the work or the submitter sees us */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool woken = true;
+    if (!stop_ && !has_visible_work()) {
+        auto wakeup = [this, epoch] {
+            return stop_ || wake_epoch_ != epoch;
+        };
+        if (until == TimePoint::max()) {
+            park_condition_.wait(lock, wakeup);
+        } else {
+            woken = park_condition_.wait_until(lock, until, wakeup);
+        }
+    }
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    return woken;
+}
+
+void ThreadPool::wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        ++wake_epoch_;
+    }
+    park_condition_.notify_one();
+}
+
+size_t ThreadPool::blocked_workers(TimePoint now) const {
+    std::int64_t limit = (now - elastic_.blocked_after).time_since_epoch().count();
+    size_t blocked = 0;
+    for (const auto& entry : workers_) {
+        const Worker* worker = entry.get();
+        if (!worker) {
+            continue;
+        }
+        std::int64_t started = worker->task_started.load(std::memory_order_relaxed);
+        if (started != 0 && started <= limit) {
+            ++blocked;
+        }
+    }
+    return blocked;
+}
+
+/*
+ * Samples the pool a few times per queue_delay. Queue delay is approximated
+ * by how long a backlog has persisted with no worker asleep; each
+ * queue_delay of it adds one burst worker. Workers stuck in one task for
+ * blocked_after are replaced right away so that thread_count workers stay
+ * runnable while work is waiting.
+ */
+void ThreadPool::supervise() {
+    auto tick = std::max(std::min(elastic_.queue_delay, elastic_.blocked_after) / 2, std::chrono::milliseconds(1));
+    TimePoint backlog_since{};
+    std::unique_lock<std::mutex> lock(supervisor_mutex_);
+    while (!supervisor_condition_.wait_for(lock, tick, [this] { return stop_.load(); })) {
+        auto now = std::chrono::steady_clock::now();
+        size_t active = active_threads_.load(std::memory_order_relaxed);
+        size_t target = active;
+        bool backlog = pending_tasks() > 0;
+
+        if (backlog && sleepers_.load(std::memory_order_relaxed) == 0) {
+            if (backlog_since == TimePoint{}) {
+                backlog_since = now;
+            } else if (now - backlog_since >= elastic_.queue_delay) {
+                target = active + 1;
+                backlog_since = now;
+            }
+        } else {
+            backlog_since = TimePoint{};
+        }
+
+        size_t blocked = blocked_workers(now);
+        size_t runnable = active > blocked ? active - blocked : 0;
+        if (backlog && runnable < core_threads_) {
+            target = std::max(target, active + (core_threads_ - runnable));
+        }
+        target = std::min(target, workers_.size());
+        target_threads_.store(target, std::memory_order_relaxed);
+
+        for (size_t i = core_threads_; i < workers_.size() && active < target; ++i) {
+            if (workers_[i].running.load(std::memory_order_acquire)) {
+                continue;
+            }
+            /* A retired thread has already left worker_loop; reap it before reusing the slot */
+            if (threads_[i].joinable()) {
+                threads_[i].join();
+            }
+            start_worker(i);
+            ++active;
+        }
+    }
+}
+
 } /* namespace Gecko */
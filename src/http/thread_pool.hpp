@@ -4,6 +4,7 @@
 #include <vector>
 #include <thread>
 #include <queue>
+#include <stdexcept>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
@@ -11,25 +12,78 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include "task_slot.hpp"
+#include "work_stealing_deque.hpp"
 
 namespace Gecko {
 
+/* Growth limits of a ThreadPool; see below */
+struct ElasticPoolConfig {
+    size_t max_threads = 0;  /* Up to this many workers in total; <= thread_count keeps the pool fixed */
+    std::chrono::milliseconds queue_delay{5};      /* Backlog age that adds a burst worker */
+    std::chrono::milliseconds blocked_after{100};  /* A task running this long blocks its worker */
+    std::chrono::milliseconds idle_timeout{10000}; /* Burst workers retire after this long idle */
+};
+
+/*
+ * Worker pool with work stealing. Each worker owns a Chase-Lev deque: tasks
+ * submitted from a worker go to its own deque, tasks from other threads (IO
+ * reactors) to an injection queue that idle workers drain in batches.
+ * A worker with nothing local takes from the injection queue, then steals
+ * from randomly chosen peers, spins briefly and finally parks; submitters
+ * only touch the park lock when someone is actually asleep.
+ *
+ * Tasks are TaskSlots: external posts are stored by value in the injection
+ * queue, and workers recycle slot objects through private freelists, so
+ * post() allocates nothing in steady state.
+ *
+ * Cooperative tasks keep their own run queue: by priority, then earliest
+ * deadline first, then FIFO. Tasks without a deadline sort last within
+ * their priority.
+ *
+ * With an ElasticConfig the pool runs thread_count core workers and a
+ * supervisor adds burst workers, up to max_threads, while work has been
+ * waiting longer than queue_delay or while long-running (blocked) tasks
+ * leave fewer than thread_count workers free. A burst worker retires after
+ * idle_timeout without work.
+ *
+ * Given CPUs, worker i is pinned to cpus[i % cpus.size()] before it touches
+ * any memory, and allocates its Worker (deque, slot freelist) and buffer
+ * pool there, so they are node-local. It steals from workers on its own
+ * NUMA node before crossing to another. Each node the workers span gets its
+ * own injection queue: a thread that called set_submitter_node() (a pinned
+ * IO reactor) posts to its node's queue, and workers drain their node's
+ * queue before the others'.
+ */
 class ThreadPool {
 public:
     enum class TaskPriority { LOW = 0, NORMAL = 1, HIGH = 2 };
 
+    using TimePoint = std::chrono::steady_clock::time_point;
+    static constexpr TimePoint NO_DEADLINE = TimePoint::max();
+
     struct TaskContext {
-        std::chrono::steady_clock::time_point deadline;
+        TimePoint deadline;                    /* End of this time slice */
+        TimePoint task_deadline = NO_DEADLINE; /* The task's own deadline */
         bool should_yield() const {
             return std::chrono::steady_clock::now() >= deadline;
         }
+        bool expired() const {
+            return std::chrono::steady_clock::now() >= task_deadline;
+        }
     };
 
     using CooperativeTask = std::function<bool(TaskContext&)>;
 
+    using ElasticConfig = ElasticPoolConfig;
+
     ThreadPool(size_t thread_count = std::thread::hardware_concurrency(),
                bool cooperative_mode = false,
-               std::chrono::milliseconds default_time_slice = std::chrono::milliseconds(2));
+               std::chrono::milliseconds default_time_slice = std::chrono::milliseconds(2),
+               ElasticConfig elastic = ElasticConfig(),
+               std::vector<int> cpus = {});
     ~ThreadPool();
 
     /* Non-copyable, non-movable */
@@ -41,37 +95,50 @@ public:
     /* Enqueue task into pool */
     template<typename F, typename... Args>
     auto enqueue(F&& f, Args&&... args) 
-        -> std::future<typename std::result_of<F(Args...)>::type> {
+        -> std::future<typename std::invoke_result<F, Args...>::type> {
         
-        using return_type = typename std::result_of<F(Args...)>::type;
+        using return_type = typename std::invoke_result<F, Args...>::type;
         
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
+        std::packaged_task<return_type()> task(
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
         
-        std::future<return_type> result = task->get_future();
-        
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            
+        std::future<return_type> result = task.get_future();
+        post(std::move(task));
+        return result;
+    }
+
+    /*
+     * Fire-and-forget: f is moved into a task slot and nothing is returned.
+     * Exceptions escaping f are logged. Throws if the pool is stopping.
+     */
+    template<typename F>
+    void post(F&& f) {
+        if (t_current_pool_ == this) {
+            /* Nested submission: stays on this worker's deque */
+            Worker& worker = *workers_[t_worker_index_].worker.load(std::memory_order_relaxed);
+            TaskSlot* slot = acquire_slot(worker);
+            slot->emplace(std::forward<F>(f));
+            worker.queue.push(slot);
+        } else {
+            InjectionQueue& injection = *injection_[injection_index()];
+            std::unique_lock<std::mutex> lock(injection.mutex);
             if (stop_) {
                 throw std::runtime_error("enqueue on stopped ThreadPool");
             }
-            
-            tasks_.emplace([task]() {
-                (*task)();
-            });
+            injection.tasks.emplace_back(std::forward<F>(f));
+            injection.size.fetch_add(1, std::memory_order_relaxed);
+            injection_size_.fetch_add(1, std::memory_order_relaxed);
         }
-        
-        condition_.notify_one();
-        return result;
+        wake_one();
     }
 
-    /* Enqueue cooperative task with optional priority and time slice */
+    /* Enqueue cooperative task with optional priority, time slice and deadline (EDF within a priority) */
     template<typename F>
     void enqueue_cooperative(F&& task,
                              TaskPriority priority = TaskPriority::NORMAL,
-                             std::chrono::milliseconds time_slice = std::chrono::milliseconds(0)) {
+                             std::chrono::milliseconds time_slice = std::chrono::milliseconds(0),
+                             TimePoint deadline = NO_DEADLINE) {
         std::chrono::milliseconds slice = (time_slice.count() > 0) ? time_slice : default_time_slice_;
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
@@ -81,43 +148,132 @@ public:
             coop_tasks_.push(ScheduledTask{
                 static_cast<int>(priority),
                 next_sequence_++,
+                deadline,
                 CooperativeTask(std::forward<F>(task)),
                 slice
             });
+            coop_size_.fetch_add(1, std::memory_order_relaxed);
         }
-        condition_.notify_one();
+        wake_one();
     }
 
     void enable_cooperative_mode(std::chrono::milliseconds default_slice);
 
     /* Inspect pool state */
-    size_t thread_count() const { return threads_.size(); }
-    size_t pending_tasks() const {
-        std::unique_lock<std::mutex> lock(queue_mutex_);
-        return tasks_.size();
-    }
+    size_t thread_count() const { return active_threads_.load(std::memory_order_relaxed); }
+    size_t core_threads() const { return core_threads_; }
+    size_t max_threads() const { return workers_.size(); }
+    /* Size the supervisor last asked for; equals thread_count() once burst workers are up or gone */
+    size_t target_threads() const { return target_threads_.load(std::memory_order_relaxed); }
+    size_t pending_tasks() const;
+    /* Tasks taken from another worker's deque since start */
+    uint64_t stolen_tasks() const { return stolen_tasks_.load(std::memory_order_relaxed); }
+
+    /* Pool whose worker is running the calling thread, or nullptr */
+    static ThreadPool* current();
+    /* NUMA node whose injection queue the calling thread posts to, in every pool; -1 spreads */
+    static void set_submitter_node(int node) { t_submitter_node_ = node; }
 
 private:
+    static constexpr size_t SPIN_ROUNDS = 64;
+    static constexpr size_t INJECTION_BATCH = 32;
+    static constexpr size_t MAX_FREE_SLOTS = 1024;
+
+    struct alignas(64) Worker {
+        WorkStealingDeque<TaskSlot*> queue;
+        std::vector<TaskSlot*> free_slots;  /* Owner only; slots migrate with stolen tasks */
+        std::atomic<std::int64_t> task_started{0};  /* Clock ticks when the running task began; 0 idle */
+    };
+
+    /* Placement of one worker; the Worker itself is allocated by the first thread to run here */
+    struct WorkerEntry {
+        std::atomic<Worker*> worker{nullptr};
+        std::atomic<bool> running{false};  /* A thread owns this entry */
+        int cpu = -1;          /* Pinned CPU; -1 floats */
+        int node = 0;          /* NUMA node of cpu */
+        size_t injection = 0;  /* Index of its node's injection queue */
+
+        Worker* get() const { return worker.load(std::memory_order_acquire); }
+    };
+
+    /* Submissions from threads outside the pool, held by value until a worker takes them */
+    struct alignas(64) InjectionQueue {
+        std::mutex mutex;
+        std::deque<TaskSlot> tasks;
+        std::atomic<size_t> size{0};
+    };
+
+    static thread_local ThreadPool* t_current_pool_;
+    static thread_local size_t t_worker_index_;
+    static thread_local int t_submitter_node_;
+
+    static TaskSlot* acquire_slot(Worker& worker);
+    static void release_slot(Worker& worker, TaskSlot* slot);
+
+    void worker_loop(size_t index);
+    TaskSlot* find_task(size_t index);
+    TaskSlot* take_injected(size_t index);
+    TaskSlot* take_injected_from(InjectionQueue& injection, Worker& worker);
+    size_t injection_index();
+    bool run_cooperative_task();
+    bool has_visible_work() const;
+    bool park(TimePoint until = TimePoint::max());  /* False when until passed without a wakeup */
+    void wake_one();
+    void start_worker(size_t index);
+    void supervise();
+    size_t blocked_workers(TimePoint now) const;
+
+    /* One slot per possible worker, core first; burst slots are reused */
     std::vector<std::thread> threads_;
-    std::queue<std::function<void()>> tasks_;
+    std::vector<WorkerEntry> workers_;
+    size_t core_threads_{0};
+    std::atomic<size_t> active_threads_{0};
+    std::atomic<size_t> target_threads_{0};
+
+    bool multi_node_{false};  /* Pinned workers span NUMA nodes: steal locally first */
+
+    ElasticConfig elastic_;
+    bool elastic_enabled_{false};
+    std::thread supervisor_;
+    std::mutex supervisor_mutex_;
+    std::condition_variable supervisor_condition_;
+
+    /* One queue per NUMA node the workers span, or a single one when unpinned */
+    std::vector<std::unique_ptr<InjectionQueue>> injection_;
+    std::vector<size_t> node_injection_;  /* By node id; injection_.size() where no worker lives */
+    std::atomic<size_t> injection_size_{0};  /* Across all queues */
+    std::atomic<size_t> next_injection_{0};  /* Spreads posts from unplaced submitters */
+
     struct ScheduledTask {
         int priority;
         std::uint64_t sequence;
+        TimePoint deadline;
         CooperativeTask task;
         std::chrono::milliseconds time_slice;
     };
     struct TaskComparator {
         bool operator()(const ScheduledTask& lhs, const ScheduledTask& rhs) const {
-            if (lhs.priority == rhs.priority) {
-                return lhs.sequence > rhs.sequence; /* FIFO for equal priority */
+            if (lhs.priority != rhs.priority) {
+                return lhs.priority < rhs.priority; /* Higher priority first */
+            }
+            if (lhs.deadline != rhs.deadline) {
+                return lhs.deadline > rhs.deadline; /* Earliest deadline first */
             }
-            return lhs.priority < rhs.priority; /* Higher priority first */
+            return lhs.sequence > rhs.sequence; /* FIFO otherwise */
         }
     };
     std::priority_queue<ScheduledTask, std::vector<ScheduledTask>, TaskComparator> coop_tasks_;
     
-    mutable std::mutex queue_mutex_;
-    std::condition_variable condition_;
+    mutable std::mutex queue_mutex_;  /* Guards coop_tasks_ */
+    std::atomic<size_t> coop_size_{0};
+
+    /* Parking: wake_epoch_ changes under park_mutex_ whenever a sleeper should look again */
+    std::mutex park_mutex_;
+    std::condition_variable park_condition_;
+    std::uint64_t wake_epoch_{0};
+    std::atomic<size_t> sleepers_{0};
+
+    std::atomic<uint64_t> stolen_tasks_{0};
     std::atomic<bool> stop_;
     bool cooperative_mode_{false};
     std::chrono::milliseconds default_time_slice_{2};
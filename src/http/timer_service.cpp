@@ -0,0 +1,87 @@
+#include "timer_service.hpp"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace Gecko {
+
+TimerService::TimerService() : thread_([this] { run(); }) {}
+
+TimerService::~TimerService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+TimerService& TimerService::instance() {
+    static TimerService service;
+    return service;
+}
+
+TimerService::TimerId TimerService::schedule(Clock::time_point deadline, TaskSlot callback) {
+    TimerId id;
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        callbacks_.emplace(id, std::move(callback));
+        heap_.push_back(Entry{deadline, id});
+        std::push_heap(heap_.begin(), heap_.end(), Later());
+        earliest = heap_.front().id == id;
+    }
+    if (earliest) {
+        wakeup_.notify_one();
+    }
+    return id;
+}
+
+bool TimerService::cancel(TimerId id) {
+    /* The heap entry stays behind and is skipped when it comes up */
+    std::lock_guard<std::mutex> lock(mutex_);
+    return callbacks_.erase(id) > 0;
+}
+
+size_t TimerService::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return callbacks_.size();
+}
+
+void TimerService::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (heap_.empty()) {
+            wakeup_.wait(lock);
+            continue;
+        }
+        Entry next = heap_.front();
+        if (Clock::now() < next.deadline) {
+            wakeup_.wait_until(lock, next.deadline);
+            continue;
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), Later());
+        heap_.pop_back();
+
+        auto it = callbacks_.find(next.id);
+        if (it == callbacks_.end()) {
+            continue;  /* Cancelled */
+        }
+        TaskSlot callback = std::move(it->second);
+        callbacks_.erase(it);
+
+        lock.unlock();
+        try {
+            callback();
+        } catch (const std::exception& e) {
+            std::cerr << "Timer callback threw an exception: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Timer callback threw an unknown exception" << std::endl;
+        }
+        callback.reset();
+        lock.lock();
+    }
+}
+
+} /* namespace Gecko */
@@ -0,0 +1,66 @@
+#ifndef TIMER_SERVICE_HPP
+#define TIMER_SERVICE_HPP
+
+#include "task_slot.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Gecko {
+
+/*
+ * One background thread firing callbacks at deadlines. Callbacks run on
+ * the timer thread and must be short: anything real is posted to a worker
+ * pool from there. cancel() is best effort; a callback already running is
+ * not waited for.
+ */
+class TimerService {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = std::uint64_t;
+
+    TimerService();
+    ~TimerService();
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    /* Process-wide instance, started on first use */
+    static TimerService& instance();
+
+    TimerId schedule(Clock::time_point deadline, TaskSlot callback);
+    TimerId scheduleAfter(Clock::duration delay, TaskSlot callback) {
+        return schedule(Clock::now() + delay, std::move(callback));
+    }
+    /* False when the timer already fired or was cancelled */
+    bool cancel(TimerId id);
+
+    size_t pending() const;
+
+private:
+    struct Entry {
+        Clock::time_point deadline;
+        TimerId id;
+    };
+    struct Later {
+        bool operator()(const Entry& lhs, const Entry& rhs) const { return lhs.deadline > rhs.deadline; }
+    };
+
+    void run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::vector<Entry> heap_;                           /* Min-heap on deadline */
+    std::unordered_map<TimerId, TaskSlot> callbacks_;  /* Absent once fired or cancelled */
+    TimerId next_id_ = 1;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} /* namespace Gecko */
+
+#endif /* TIMER_SERVICE_HPP */
@@ -0,0 +1,135 @@
+#ifndef WORK_STEALING_DEQUE_HPP
+#define WORK_STEALING_DEQUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace Gecko {
+
+/*
+ * Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP'13).
+ * The owning worker pushes and pops at the bottom without atomic
+ * read-modify-writes except when racing for the last element; any thread
+ * may steal from the top. T is a pointer; nullptr means "nothing".
+ *
+ * The ring grows when full. Outgrown rings stay allocated until the deque is
+ * destroyed because a concurrent thief may still be reading one.
+ */
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_pointer<T>::value, "WorkStealingDeque holds pointers");
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        rings_.push_back(std::make_unique<Ring>(rounded));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /* Owner only */
+    void push(T item) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(ring->mask)) {
+            ring = grow(ring, top, bottom);
+        }
+        ring->put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /* Owner only; most recently pushed first */
+    T pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T item = ring->get(bottom);
+        if (top == bottom) {
+            /* Last element: race thieves for it */
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /* Any thread; oldest first. nullptr when empty or when another thief won */
+    T steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        Ring* ring = ring_.load(std::memory_order_acquire);
+        T item = ring->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    /* Approximate when read concurrently */
+    size_t size() const {
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        int64_t top = top_.load(std::memory_order_acquire);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Ring {
+        explicit Ring(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+
+        T get(int64_t index) const {
+            return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+        void put(int64_t index, T item) {
+            slots[static_cast<size_t>(index) & mask].store(item, std::memory_order_relaxed);
+        }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Ring* grow(Ring* ring, int64_t top, int64_t bottom) {
+        auto bigger = std::make_unique<Ring>((ring->mask + 1) * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->put(i, ring->get(i));
+        }
+        rings_.push_back(std::move(bigger));
+        Ring* next = rings_.back().get();
+        ring_.store(next, std::memory_order_release);
+        return next;
+    }
+
+    /* Owner and thieves touch opposite ends; keep them on separate lines */
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    alignas(64) std::atomic<Ring*> ring_{nullptr};
+    std::vector<std::unique_ptr<Ring>> rings_;  /* Owner only */
+};
+
+} /* namespace Gecko */
+
+#endif /* WORK_STEALING_DEQUE_HPP */
@@ -0,0 +1,213 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "batcher.hpp"
+#include "context.hpp"
+#include "thread_pool.hpp"
+
+using namespace std::chrono_literals;
+using IntBatcher = Gecko::Batcher<int, std::string>;
+
+template <typename Predicate>
+bool waitFor(Predicate predicate, std::chrono::milliseconds limit = 2000ms) {
+    auto until = std::chrono::steady_clock::now() + limit;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() >= until) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+std::vector<std::string> echo(const std::vector<int> &keys) {
+    std::vector<std::string> values;
+    for (int key : keys) {
+        values.push_back("v" + std::to_string(key));
+    }
+    return values;
+}
+
+void test_flush_on_size() {
+    std::vector<std::vector<int>> calls;
+    std::thread::id loader_thread;
+    IntBatcher batcher([&calls, &loader_thread](const std::vector<int> &keys) {
+        calls.push_back(keys);
+        loader_thread = std::this_thread::get_id();
+        return echo(keys);
+    }, Gecko::BatchOptions{4, 10s});
+
+    std::vector<std::string> got(4);
+    std::atomic<int> done{0};
+    for (int i = 0; i < 4; ++i) {
+        assert(batcher.batches() == 0);
+        batcher.load(i, [&got, &done, i](IntBatcher::Result result) {
+            got[i] = *result.value;
+            done++;
+        });
+    }
+    /* Outside any pool the fourth key hands the batch to the Batcher's own executor */
+    bool flushed = waitFor([&] { return done.load() == 4; });
+    assert(flushed);
+    assert(loader_thread != std::this_thread::get_id());
+    assert(calls.size() == 1);
+    assert((calls[0] == std::vector<int>{0, 1, 2, 3}));
+    assert(got[3] == "v3");
+    assert(got[0] == "v0");
+    assert(batcher.batches() == 1);
+}
+
+void test_flush_on_delay() {
+    std::atomic<int> done{0};
+    std::atomic<bool> on_pool{true};
+    IntBatcher batcher([&on_pool](const std::vector<int> &keys) {
+        /* Never the TimerService thread that noticed the delay */
+        on_pool = on_pool && Gecko::ThreadPool::current() != nullptr;
+        return echo(keys);
+    }, Gecko::BatchOptions{64, 2000us});
+    batcher.load(7, [&done](IntBatcher::Result result) {
+        assert(result.ok());
+        assert(*result.value == "v7");
+        done++;
+    });
+    batcher.load(8, [&done](IntBatcher::Result) { done++; });
+    assert(done.load() == 0);
+
+    bool flushed = waitFor([&] { return done.load() == 2; });
+    assert(flushed);
+    assert(on_pool.load());
+    assert(batcher.batches() == 1);
+    assert(batcher.loadedKeys() == 2);
+}
+
+void test_duplicate_keys_load_once() {
+    std::vector<int> seen;
+    IntBatcher batcher([&seen](const std::vector<int> &keys) {
+        seen = keys;
+        return echo(keys);
+    }, Gecko::BatchOptions{64, 10s});
+
+    std::vector<std::string> got;
+    std::atomic<int> done{0};
+    for (int key : {1, 2, 1, 1}) {
+        batcher.load(key, [&got, &done](IntBatcher::Result result) {
+            got.push_back(*result.value);
+            done++;
+        });
+    }
+    batcher.flush();
+    bool flushed = waitFor([&] { return done.load() == 4; });
+    assert(flushed);
+    assert((seen == std::vector<int>{1, 2}));
+    assert(got.size() == 4);
+    assert(batcher.requests() == 4);
+    assert(batcher.loadedKeys() == 2);
+    for (const auto &value : got) {
+        assert(value == "v1" || value == "v2");
+    }
+}
+
+void test_errors_reach_every_waiter() {
+    IntBatcher throwing([](const std::vector<int> &) -> std::vector<std::string> {
+        throw std::runtime_error("backend down");
+    }, Gecko::BatchOptions{2, 10s});
+    std::atomic<int> failed{0};
+    for (int key : {1, 2}) {
+        throwing.load(key, [&failed](IntBatcher::Result result) {
+            assert(!result.ok());
+            assert(result.error);
+            failed++;
+        });
+    }
+    bool answered = waitFor([&] { return failed.load() == 2; });
+    assert(answered);
+
+    IntBatcher short_answer([](const std::vector<int> &) { return std::vector<std::string>{"only one"}; },
+                            Gecko::BatchOptions{2, 10s});
+    failed = 0;
+    for (int key : {1, 2}) {
+        short_answer.load(key, [&failed](IntBatcher::Result result) {
+            if (!result.ok()) failed++;
+        });
+    }
+    answered = waitFor([&] { return failed.load() == 2; });
+    assert(answered);
+}
+
+/* Concurrent deferred requests on a worker pool share a few backend calls */
+void test_deferred_requests_on_pool() {
+    constexpr int REQUESTS = 40;
+    Gecko::ThreadPool pool(2);
+    std::atomic<int> backend_calls{0};
+    IntBatcher batcher([&backend_calls](const std::vector<int> &keys) {
+        backend_calls++;
+        std::this_thread::sleep_for(2ms);
+        return echo(keys);
+    }, Gecko::BatchOptions{16, 1000us}, &pool);
+
+    std::vector<Gecko::HttpRequest> requests;
+    std::vector<std::unique_ptr<Gecko::Context>> contexts;
+    for (int i = 0; i < REQUESTS; ++i) {
+        requests.emplace_back(Gecko::HttpMethod::GET, "/item", Gecko::HttpVersion::HTTP_1_1,
+                              Gecko::HttpHeaderMap{}, "");
+    }
+    std::atomic<int> completed{0};
+    for (int i = 0; i < REQUESTS; ++i) {
+        contexts.push_back(std::make_unique<Gecko::Context>(requests[i]));
+        contexts.back()->onComplete([&completed] { completed++; });
+    }
+    for (int i = 0; i < REQUESTS; ++i) {
+        Gecko::Context *ctx = contexts[i].get();
+        pool.post([&batcher, ctx, i] {
+            batcher.load(i % 10, ctx->defer(), [](Gecko::Context &c, const std::string &value) {
+                c.string(value);
+            });
+        });
+    }
+
+    bool finished = waitFor([&] { return completed.load() == REQUESTS; });
+    assert(finished);
+    for (int i = 0; i < REQUESTS; ++i) {
+        assert(contexts[i]->response().getStatusCode() == 200);
+        assert(contexts[i]->response().getBody() == "v" + std::to_string(i % 10));
+    }
+    int calls = backend_calls.load();
+    assert(calls >= 1);
+    assert(calls < REQUESTS);
+}
+
+void test_failed_batch_answers_500() {
+    IntBatcher batcher([](const std::vector<int> &) -> std::vector<std::string> {
+        throw std::runtime_error("backend down");
+    }, Gecko::BatchOptions{1, 10s});
+    Gecko::HttpRequest request(Gecko::HttpMethod::GET, "/item", Gecko::HttpVersion::HTTP_1_1, {}, "");
+    Gecko::Context ctx(request);
+    std::atomic<bool> completed{false};
+    ctx.onComplete([&completed] { completed = true; });
+    batcher.load(1, ctx.defer(), [](Gecko::Context &c, const std::string &value) { c.string(value); });
+    bool answered = waitFor([&] { return completed.load(); });
+    assert(answered);
+    assert(ctx.response().getStatusCode() == 500);
+}
+
+int main() {
+    test_flush_on_size();
+    std::cout << "[PASS] batch flushes at max_keys" << std::endl;
+    test_flush_on_delay();
+    std::cout << "[PASS] batch flushes after max_delay" << std::endl;
+    test_duplicate_keys_load_once();
+    std::cout << "[PASS] duplicate keys are loaded once" << std::endl;
+    test_errors_reach_every_waiter();
+    std::cout << "[PASS] loader errors reach every waiter" << std::endl;
+    test_deferred_requests_on_pool();
+    std::cout << "[PASS] deferred requests share backend calls" << std::endl;
+    test_failed_batch_answers_500();
+    std::cout << "[PASS] failed batch answers 500" << std::endl;
+    return 0;
+}
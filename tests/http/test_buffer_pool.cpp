@@ -0,0 +1,65 @@
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include "buffer_pool.hpp"
+
+void test_acquire_rounds_to_size_class() {
+    auto& pool = Gecko::BufferPool::local();
+    auto buffer = pool.acquire(100);
+    assert(buffer.size() == 100);
+    assert(buffer.str().capacity() >= 1024);
+
+    auto large = pool.acquire(5000);
+    assert(large.size() == 5000);
+    assert(large.str().capacity() >= 16384);
+}
+
+void test_release_on_owner_thread_reuses_storage() {
+    auto& pool = Gecko::BufferPool::local();
+    const char* storage = nullptr;
+    {
+        auto buffer = pool.acquire(2000);
+        storage = buffer.data();
+    }
+    size_t misses = pool.pool_misses();
+    auto buffer = pool.acquire(3000);
+    assert(buffer.data() == storage);
+    assert(pool.pool_misses() == misses);
+}
+
+void test_release_on_other_thread_returns_to_origin() {
+    auto& pool = Gecko::BufferPool::local();
+    auto buffer = pool.acquire(60000);
+    const char* storage = buffer.data();
+    size_t available = pool.available_count();
+
+    std::thread io_thread([moved = std::move(buffer)]() mutable {
+        Gecko::PooledBuffer sink = std::move(moved);
+        assert(sink.size() == 60000);
+    });
+    io_thread.join();
+
+    assert(pool.available_count() == available + 1);
+    auto reused = pool.acquire(60000);
+    assert(reused.data() == storage);
+}
+
+void test_oversized_and_adopted_buffers_are_not_pooled() {
+    auto& pool = Gecko::BufferPool::local();
+    size_t available = pool.available_count();
+    {
+        auto huge = pool.acquire(Gecko::BufferPool::CLASS_SIZES.back() + 1);
+        Gecko::PooledBuffer adopted(std::string(8192, 'a'));
+        assert(adopted.view() == std::string(8192, 'a'));
+    }
+    assert(pool.available_count() == available);
+}
+
+int main() {
+    test_acquire_rounds_to_size_class();
+    test_release_on_owner_thread_reuses_storage();
+    test_release_on_other_thread_returns_to_origin();
+    test_oversized_and_adopted_buffers_are_not_pooled();
+    std::cout << "[PASS] Buffer pool tests" << std::endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include "context.hpp"
+
+using namespace std::chrono_literals;
+using Gecko::CancellationToken;
+
+void test_default_token_never_cancels() {
+    CancellationToken token;
+    assert(!token.cancelled());
+    assert(!token.disconnected());
+    assert(token.deadline() == CancellationToken::Clock::time_point::max());
+}
+
+void test_disconnect_cancels_copies() {
+    auto connected = std::make_shared<std::atomic<bool>>(true);
+    CancellationToken token(connected, CancellationToken::Clock::time_point::max());
+    CancellationToken copy = token;
+    assert(!copy.cancelled());
+
+    connected->store(false);
+    assert(token.disconnected());
+    assert(copy.cancelled());
+
+    /* The token keeps the flag alive after its owner lets go */
+    connected.reset();
+    assert(copy.cancelled());
+}
+
+void test_deadline_cancels() {
+    auto now = CancellationToken::Clock::now();
+    CancellationToken token(std::make_shared<std::atomic<bool>>(true), now + 50ms);
+    assert(!token.expired(now));
+    assert(token.expired(now + 50ms));
+    assert(!token.disconnected());
+
+    CancellationToken past(nullptr, now - 1ms);
+    assert(past.cancelled());
+}
+
+void test_context_token_is_per_request() {
+    Gecko::HttpRequest request(Gecko::HttpMethod::GET, "/slow", Gecko::HttpVersion::HTTP_1_1, {}, "");
+    Gecko::Context ctx(request);
+    assert(!ctx.cancelled());
+
+    auto connected = std::make_shared<std::atomic<bool>>(false);
+    ctx.setCancellation(CancellationToken(connected, CancellationToken::Clock::time_point::max()));
+    assert(ctx.cancelled());
+    CancellationToken held = ctx.cancellation();
+
+    /* A pooled context starts its next request uncancelled */
+    ctx.reset();
+    assert(!ctx.cancelled());
+    assert(held.cancelled());
+}
+
+int main() {
+    test_default_token_never_cancels();
+    test_disconnect_cancels_copies();
+    test_deadline_cancels();
+    test_context_token_is_per_request();
+    std::cout << "[PASS] cancellation tests" << std::endl;
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <zlib.h>
+#include "compression.hpp"
+
+Gecko::HttpRequest makeRequest(const std::string& accept_encoding) {
+    Gecko::HttpHeaderMap headers;
+    if (!accept_encoding.empty()) {
+        headers["Accept-Encoding"] = accept_encoding;
+    }
+    return Gecko::HttpRequest(Gecko::HttpMethod::GET, "/data", Gecko::HttpVersion::HTTP_1_1,
+                              std::move(headers), "");
+}
+
+Gecko::HttpResponse makeJsonResponse(size_t records) {
+    std::string body = "[";
+    for (size_t i = 0; i < records; ++i) {
+        body += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\",\"active\":true},";
+    }
+    body.back() = ']';
+    Gecko::HttpResponse response;
+    response.addHeader("Content-Type", "application/json");
+    response.setBody(body);
+    return response;
+}
+
+std::string inflateBody(const std::string& compressed, int window_bits) {
+    z_stream stream{};
+    int rc = inflateInit2(&stream, window_bits);
+    assert(rc == Z_OK);
+    std::string out(1 << 20, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    rc = inflate(&stream, Z_FINISH);
+    assert(rc == Z_STREAM_END);
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    return out;
+}
+
+void test_negotiation() {
+    using Gecko::ContentEncoding;
+    assert(Gecko::negotiateEncoding("gzip, deflate, br") == ContentEncoding::GZIP);
+    assert(Gecko::negotiateEncoding("deflate") == ContentEncoding::DEFLATE);
+    assert(Gecko::negotiateEncoding("gzip;q=0.2, deflate;q=0.8") == ContentEncoding::DEFLATE);
+    assert(Gecko::negotiateEncoding("gzip;q=0, deflate;q=0") == ContentEncoding::IDENTITY);
+    assert(Gecko::negotiateEncoding("*") == ContentEncoding::GZIP);
+    assert(Gecko::negotiateEncoding("br") == ContentEncoding::IDENTITY);
+    assert(Gecko::negotiateEncoding("") == ContentEncoding::IDENTITY);
+}
+
+void test_adaptive_level() {
+    Gecko::CompressionOptions options;
+    options.level = 6;
+    options.min_level = 1;
+    options.backlog_per_level = 10;
+    assert(Gecko::adaptiveLevel(options, 0) == 6);
+    assert(Gecko::adaptiveLevel(options, 9) == 6);
+    assert(Gecko::adaptiveLevel(options, 25) == 4);
+    assert(Gecko::adaptiveLevel(options, 10000) == 1);
+}
+
+void test_compress_response_round_trip() {
+    Gecko::CompressionOptions options;
+    Gecko::HttpResponse response = makeJsonResponse(200);
+    std::string original(response.getBody());
+
+    bool compressed = Gecko::compressResponse(makeRequest("gzip"), response, options, 6);
+    assert(compressed);
+    assert(response.getHeaders().at("Content-Encoding") == "gzip");
+    assert(response.getHeaders().at("Vary") == "Accept-Encoding");
+    assert(response.getBodyLength() * 4 < original.size());
+    assert(inflateBody(std::string(response.getBody()), 15 + 16) == original);
+
+    /* Thread-local stream is reset, not reused dirty */
+    Gecko::HttpResponse deflated = makeJsonResponse(200);
+    compressed = Gecko::compressResponse(makeRequest("deflate"), deflated, options, 6);
+    assert(compressed);
+    assert(deflated.getHeaders().at("Content-Encoding") == "deflate");
+    assert(inflateBody(std::string(deflated.getBody()), 15) == original);
+}
+
+void test_compression_weakens_strong_etag() {
+    Gecko::CompressionOptions options;
+    Gecko::HttpResponse strong = makeJsonResponse(200);
+    strong.addHeader("ETag", "\"v1\"");
+    bool compressed = Gecko::compressResponse(makeRequest("gzip"), strong, options, 6);
+    assert(compressed);
+    assert(strong.getHeaders().at("ETag") == "W/\"v1\"");
+
+    Gecko::HttpResponse weak = makeJsonResponse(200);
+    weak.addHeader("ETag", "W/\"v1\"");
+    compressed = Gecko::compressResponse(makeRequest("gzip"), weak, options, 6);
+    assert(compressed);
+    assert(weak.getHeaders().at("ETag") == "W/\"v1\"");
+
+    Gecko::HttpResponse identity = makeJsonResponse(200);
+    identity.addHeader("ETag", "\"v1\"");
+    compressed = Gecko::compressResponse(makeRequest(""), identity, options, 6);
+    assert(!compressed);
+    assert(identity.getHeaders().at("ETag") == "\"v1\"");
+}
+
+void test_skips() {
+    Gecko::CompressionOptions options;
+
+    Gecko::HttpResponse small = makeJsonResponse(2);
+    bool compressed = Gecko::compressResponse(makeRequest("gzip"), small, options, 6);
+    assert(!compressed);
+
+    Gecko::HttpResponse no_accept = makeJsonResponse(200);
+    compressed = Gecko::compressResponse(makeRequest(""), no_accept, options, 6);
+    assert(!compressed);
+    assert(no_accept.getHeaders().count("Content-Encoding") == 0);
+
+    Gecko::HttpResponse image = makeJsonResponse(200);
+    image.addHeader("Content-Type", "image/png");
+    compressed = Gecko::compressResponse(makeRequest("gzip"), image, options, 6);
+    assert(!compressed);
+
+    Gecko::HttpResponse not_modified = makeJsonResponse(200);
+    not_modified.setStatusCode(304);
+    compressed = Gecko::compressResponse(makeRequest("gzip"), not_modified, options, 6);
+    assert(!compressed);
+}
+
+int main() {
+    test_negotiation();
+    test_adaptive_level();
+    if (Gecko::compressionAvailable()) {
+        test_compress_response_round_trip();
+        test_skips();
+        test_compression_weakens_strong_etag();
+    }
+    std::cout << "[PASS] compression tests" << std::endl;
+    return 0;
+}
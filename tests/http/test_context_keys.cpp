@@ -0,0 +1,98 @@
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include "context.hpp"
+
+namespace {
+
+struct LargeValue {
+    char payload[128] = {};
+    int tag = 0;
+};
+
+const Gecko::ContextKey<int> TenantShard{"tenant_shard"};
+const Gecko::ContextKey<LargeValue> Large{"large_value"};
+const Gecko::ContextKey<std::shared_ptr<int>> Shared{"shared_value"};
+
+} // namespace
+
+void test_typed_slots() {
+    Gecko::Context ctx;
+    assert(!ctx.has(TenantShard));
+    assert(ctx.find(TenantShard) == nullptr);
+
+    ctx.set(TenantShard, 7);
+    assert(ctx.get(TenantShard) == 7);
+    ctx.set(TenantShard, 8);
+    assert(*ctx.find(TenantShard) == 8);
+
+    LargeValue large;
+    large.tag = 42;
+    ctx.set(Large, large);
+    assert(ctx.get(Large).tag == 42);
+
+    bool threw = false;
+    try {
+        ctx.get(Gecko::ContextKeys::RequestId);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void test_string_api_shares_typed_slots() {
+    Gecko::Context ctx;
+    ctx.set(Gecko::ContextKeys::RequestId, std::string("abc"));
+    assert(ctx.has("request_id"));
+    assert(ctx.get<std::string>("request_id") == "abc");
+
+    ctx.set("trace_id", std::string("trace-1"));
+    assert(ctx.get(Gecko::ContextKeys::TraceId) == "trace-1");
+
+    /* A value of another type is kept string-keyed next to the typed slot */
+    ctx.set("trace_id", 5);
+    assert(ctx.get<int>("trace_id") == 5);
+    assert(ctx.get<std::string>("trace_id") == "trace-1");
+    assert(ctx.get(Gecko::ContextKeys::TraceId) == "trace-1");
+
+    ctx.set("plain", 3);
+    assert(ctx.get<int>("plain") == 3);
+}
+
+void test_reset_destroys_slot_values() {
+    auto tracked = std::make_shared<int>(1);
+    {
+        Gecko::Context ctx;
+        ctx.set(Shared, tracked);
+        assert(tracked.use_count() == 2);
+        ctx.reset();
+        assert(tracked.use_count() == 1);
+        assert(!ctx.has(Shared));
+
+        ctx.set(Shared, tracked);
+        assert(tracked.use_count() == 2);
+    }
+    assert(tracked.use_count() == 1);
+}
+
+void test_same_name_shares_slot() {
+    Gecko::ContextKey<int> again{"tenant_shard"};
+    assert(again.index() == TenantShard.index());
+
+    bool threw = false;
+    try {
+        Gecko::ContextKey<double> conflicting{"tenant_shard"};
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main() {
+    test_typed_slots();
+    test_string_api_shares_typed_slots();
+    test_reset_destroys_slot_values();
+    test_same_name_shares_slot();
+    std::cout << "[PASS] context key tests" << std::endl;
+    return 0;
+}
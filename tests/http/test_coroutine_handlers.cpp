@@ -0,0 +1,143 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "context.hpp"
+#include "coroutine_task.hpp"
+#include "timer_service.hpp"
+
+using namespace std::chrono_literals;
+
+Gecko::Task<int> answer(int base) {
+    co_return base + 1;
+}
+
+Gecko::Task<int> twice(int base) {
+    int first = co_await answer(base);
+    int second = co_await answer(first);
+    co_return second;
+}
+
+Gecko::Task<> failing() {
+    throw std::runtime_error("boom");
+    co_return;
+}
+
+Gecko::Task<> outer(int& result, bool& caught) {
+    result = co_await twice(40);
+    try {
+        co_await failing();
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+}
+
+void test_task_chain() {
+    int result = 0;
+    bool caught = false;
+    auto request = Gecko::HttpRequest(Gecko::HttpMethod::GET, "/", Gecko::HttpVersion::HTTP_1_1, {}, "");
+    Gecko::Context ctx(request);
+    /* No pool: nothing suspends, so the whole chain runs inside the call */
+    Gecko::asyncHandler([&](Gecko::Context&) { return outer(result, caught); })(ctx);
+    assert(result == 42);
+    assert(caught);
+    assert(ctx.isDeferred());
+
+    bool finished = false;
+    ctx.onComplete([&finished] { finished = true; });
+    assert(finished);
+}
+
+void test_timer_service() {
+    Gecko::TimerService timers;
+    std::promise<std::vector<int>> fired;
+    auto order = std::make_shared<std::vector<int>>();
+    auto now = Gecko::TimerService::Clock::now();
+    timers.schedule(now + 30ms, [order] { order->push_back(3); });
+    timers.schedule(now + 10ms, [order] { order->push_back(1); });
+    auto cancelled = timers.schedule(now + 20ms, [order] { order->push_back(2); });
+    timers.schedule(now + 40ms, [order, &fired]() mutable { fired.set_value(*order); });
+    bool removed = timers.cancel(cancelled);
+    assert(removed);
+    removed = timers.cancel(cancelled);
+    assert(!removed);
+
+    auto result = fired.get_future();
+    auto status = result.wait_for(2s);
+    assert(status == std::future_status::ready);
+    auto seen = result.get();
+    assert((seen == std::vector<int>{1, 3}));
+}
+
+Gecko::Task<> slowHandler(Gecko::Context& ctx) {
+    co_await Gecko::sleepFor(50ms);
+    co_await Gecko::yield();
+    ctx.status(201).string(ctx.request().getUrl());
+}
+
+void test_handlers_do_not_hold_workers() {
+    constexpr int REQUESTS = 40;
+    Gecko::ThreadPool pool(1);
+    auto handler = Gecko::asyncHandler(slowHandler);
+
+    std::vector<std::unique_ptr<Gecko::HttpRequest>> requests;
+    std::vector<std::unique_ptr<Gecko::Context>> contexts;
+    std::atomic<int> completed{0};
+    std::atomic<int> matched{0};
+    for (int i = 0; i < REQUESTS; ++i) {
+        std::string url = "/slow/" + std::to_string(i);
+        requests.push_back(std::make_unique<Gecko::HttpRequest>(
+            Gecko::HttpMethod::GET, url, Gecko::HttpVersion::HTTP_1_1, Gecko::HttpHeaderMap{}, ""));
+        contexts.push_back(std::make_unique<Gecko::Context>(*requests.back()));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REQUESTS; ++i) {
+        Gecko::Context* ctx = contexts[i].get();
+        pool.post([&, ctx, i] {
+            handler(*ctx);
+            assert(ctx->isDeferred());
+            /* What the server does: the response is written once the coroutine completes */
+            ctx->onComplete([&, ctx, i] {
+                if (ctx->response().getStatusCode() == 201 &&
+                    ctx->response().getBody() == "/slow/" + std::to_string(i)) {
+                    matched++;
+                }
+                completed++;
+            });
+        });
+    }
+
+    auto deadline = start + 10s;
+    while (completed.load() < REQUESTS && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(completed.load() == REQUESTS);
+    assert(matched.load() == REQUESTS);
+    /* One worker, forty 50ms sleeps: they overlap instead of queueing behind each other */
+    assert(elapsed < 1500ms);
+}
+
+void test_frame_pool_reuse() {
+    void* first = Gecko::FramePool::allocate(300);
+    Gecko::FramePool::deallocate(first, 300);
+    void* second = Gecko::FramePool::allocate(400);
+    assert(second == first);
+    Gecko::FramePool::deallocate(second, 400);
+}
+
+int main() {
+    test_task_chain();
+    test_timer_service();
+    test_handlers_do_not_hold_workers();
+    test_frame_pool_reuse();
+    std::cout << "[PASS] coroutine handler tests" << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <sched.h>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "http/cpu_affinity.hpp"
+#include "http/server_config.hpp"
+#include "http/thread_pool.hpp"
+
+void test_parse_cpu_list() {
+    std::vector<int> cpus = Gecko::parse_cpu_list("0-3,8, 10-11");
+    assert((cpus == std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    cpus = Gecko::parse_cpu_list("5");
+    assert((cpus == std::vector<int>{5}));
+
+    for (const char* bad : {"", "a", "3-1", "1,,2", "-1", "2-"}) {
+        bool threw = false;
+        try {
+            Gecko::parse_cpu_list(bad);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    Gecko::ServerConfig config;
+    config.setIOThreadAffinity("0-1").setWorkerAffinity("2-5");
+    assert((config.io_cpus == std::vector<int>{0, 1}));
+    assert(config.worker_cpus.size() == 4);
+}
+
+/* Two nodes of eight CPUs: worker i lands on the node of reactor i % reactors */
+void test_pair_with_reactors() {
+    auto node_of = [](int cpu) { return cpu / 8; };
+    std::vector<int> io = {0, 8};
+    std::vector<int> workers = {1, 2, 3, 9, 10, 11};
+    std::vector<int> paired = Gecko::pair_with_reactors(workers, io, node_of);
+    assert((paired == std::vector<int>{1, 9, 2, 10, 3, 11}));
+
+    /* Uneven split: once node 1 runs out, the rest come from node 0 */
+    workers = {1, 2, 3, 9};
+    paired = Gecko::pair_with_reactors(workers, io, node_of);
+    assert((paired == std::vector<int>{1, 9, 2, 3}));
+
+    /* Without reactor CPUs the order is kept */
+    paired = Gecko::pair_with_reactors(workers, {}, node_of);
+    assert(paired == workers);
+}
+
+void test_pinned_pools() {
+    int cpu = sched_getcpu();
+    assert(cpu >= 0);
+
+    bool pinned = Gecko::pin_current_thread(cpu);
+    assert(pinned);
+    bool refused = Gecko::pin_current_thread(-1);
+    assert(!refused);
+
+    Gecko::ThreadPool pool(2, false, std::chrono::milliseconds(2), Gecko::ThreadPool::ElasticConfig(), {cpu});
+    for (int i = 0; i < 4; ++i) {
+        auto result = pool.enqueue([] { return sched_getcpu(); });
+        int ran_on = result.get();
+        assert(ran_on == cpu);
+    }
+
+    /* A submitter placed on the pool's node, or on a node without workers, still gets served */
+    for (int node : {Gecko::numa_node_of(cpu), 4096}) {
+        Gecko::ThreadPool::set_submitter_node(node);
+        auto result = pool.enqueue([] { return sched_getcpu(); });
+        int ran_on = result.get();
+        assert(ran_on == cpu);
+    }
+    Gecko::ThreadPool::set_submitter_node(-1);
+}
+
+int main() {
+    test_parse_cpu_list();
+    std::cout << "[PASS] CPU lists parse and reject malformed input" << std::endl;
+    test_pair_with_reactors();
+    std::cout << "[PASS] workers pair with reactors on the same node" << std::endl;
+    test_pinned_pools();
+    std::cout << "[PASS] pinned workers run on their CPU" << std::endl;
+    return 0;
+}
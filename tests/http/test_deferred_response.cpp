@@ -0,0 +1,111 @@
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "context.hpp"
+
+Gecko::HttpRequest makeRequest() {
+    return Gecko::HttpRequest(Gecko::HttpMethod::GET, "/deferred", Gecko::HttpVersion::HTTP_1_1, {}, "");
+}
+
+void test_send_from_another_thread() {
+    auto request = makeRequest();
+    Gecko::Context ctx(request);
+    Gecko::Responder responder = ctx.defer();
+    assert(responder);
+    assert(ctx.isDeferred());
+
+    std::atomic<int> finished{0};
+    ctx.onComplete([&finished] { finished++; });
+    assert(finished.load() == 0);
+
+    std::thread upstream([responder = std::move(responder)]() mutable {
+        responder.context().status(202).string("later");
+        responder.send();
+        assert(!responder);
+    });
+    upstream.join();
+    assert(finished.load() == 1);
+    assert(ctx.response().getStatusCode() == 202);
+    assert(ctx.response().getBody() == "later");
+}
+
+void test_send_before_server_arms() {
+    auto request = makeRequest();
+    Gecko::Context ctx(request);
+    {
+        Gecko::Responder responder = ctx.defer();
+        responder.response().setStatusCode(200);
+        responder.send();
+    }
+    bool finished = false;
+    ctx.onComplete([&finished] { finished = true; });
+    assert(finished);
+}
+
+/* Post-processing waits for the deferred response, innermost hook first, before completion */
+void test_before_send_runs_on_send() {
+    auto request = makeRequest();
+    Gecko::Context ctx(request);
+    std::string order;
+    ctx.beforeSend([&ctx, &order] { order += "outer:" + std::string(ctx.response().getBody()) + ";"; });
+    ctx.beforeSend([&order] { order += "inner;"; });
+    Gecko::Responder responder = ctx.defer();
+    bool finished = false;
+    ctx.onComplete([&finished, &order] {
+        finished = true;
+        order += "complete";
+    });
+    assert(order.empty());
+
+    responder.context().string("late");
+    responder.send();
+    assert(finished);
+    assert(order == "inner;outer:late;complete");
+}
+
+void test_abandoned_responder_answers_500() {
+    auto request = makeRequest();
+    Gecko::Context ctx(request);
+    bool finished = false;
+    {
+        Gecko::Responder responder = ctx.defer();
+        ctx.onComplete([&finished] { finished = true; });
+        ctx.string("partial");
+    }
+    assert(finished);
+    assert(ctx.response().getStatusCode() == 500);
+}
+
+void test_defer_once_and_reset() {
+    auto request = makeRequest();
+    Gecko::Context ctx(request);
+    Gecko::Responder responder = ctx.defer();
+    bool threw = false;
+    try {
+        ctx.defer();
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+    responder.send();
+
+    /* A recycled context starts out immediate again */
+    ctx.reset();
+    assert(!ctx.isDeferred());
+    Gecko::Responder again = ctx.defer();
+    assert(again);
+    again.send();
+}
+
+int main() {
+    test_send_from_another_thread();
+    test_send_before_server_arms();
+    test_before_send_runs_on_send();
+    test_abandoned_responder_answers_500();
+    test_defer_once_and_reset();
+    std::cout << "[PASS] deferred response tests" << std::endl;
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "engine.hpp"
+#include "middlewares.hpp"
+
+using namespace std::chrono_literals;
+
+Gecko::HttpRequest makeRequest(const std::string& url, Gecko::HttpHeaderMap headers = {}) {
+    return Gecko::HttpRequest(Gecko::HttpMethod::GET, url, Gecko::HttpVersion::HTTP_1_1, std::move(headers), "");
+}
+
+/* Serve url and wait for the answer, as the server would */
+struct Exchange {
+    Gecko::HttpRequest request;
+    Gecko::Context ctx;
+    std::promise<void> done;
+
+    explicit Exchange(const std::string& url, Gecko::HttpHeaderMap headers = {})
+        : request(makeRequest(url, std::move(headers))), ctx(request) {}
+
+    void serve(Gecko::Engine& app) {
+        app.Serve(ctx);
+        if (!ctx.isDeferred()) {
+            done.set_value();
+            return;
+        }
+        ctx.onComplete([this] { done.set_value(); });
+    }
+
+    bool wait() { return done.get_future().wait_for(2s) == std::future_status::ready; }
+};
+
+void test_handler_runs_on_named_pool() {
+    Gecko::Engine app;
+    app.Executor("reports", 1).Executor("search", 1);
+    std::atomic<Gecko::ThreadPool*> reports{nullptr};
+    std::atomic<Gecko::ThreadPool*> search{nullptr};
+    app.Group("/reports").Executor("reports").GET("/daily", [&](Gecko::Context& ctx) {
+        reports = Gecko::ThreadPool::current();
+        ctx.string("daily");
+    });
+    app.Group("/search").Executor("search").GET("/q", [&](Gecko::Context& ctx) {
+        search = Gecko::ThreadPool::current();
+        ctx.string("found");
+    });
+
+    Exchange daily("/reports/daily");
+    daily.serve(app);
+    bool answered = daily.wait();
+    assert(answered);
+    assert(daily.ctx.response().getBody() == "daily");
+
+    Exchange query("/search/q");
+    query.serve(app);
+    answered = query.wait();
+    assert(answered);
+    assert(reports.load() != nullptr && search.load() != nullptr);
+    assert(reports.load() != search.load());
+}
+
+void test_queue_limit_answers_503() {
+    Gecko::Engine app;
+    app.Executor("tiny", 1, 1);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> running{false};
+    app.Group("/slow").Executor("tiny").GET("/job", [&](Gecko::Context& ctx) {
+        running = true;
+        released.wait();
+        ctx.string("done");
+    });
+
+    Exchange busy("/slow/job");
+    busy.serve(app);
+    while (!running) {
+        std::this_thread::sleep_for(1ms);
+    }
+    Exchange queued("/slow/job");
+    queued.serve(app);
+    assert(queued.ctx.isDeferred());
+
+    Exchange refused("/slow/job");
+    refused.serve(app);
+    assert(!refused.ctx.isDeferred());
+    assert(refused.ctx.response().getStatusCode() == 503);
+    assert(refused.ctx.response().getHeaders().at("Retry-After") == "1");
+
+    release.set_value();
+    bool answered = busy.wait() && queued.wait();
+    assert(answered);
+    assert(queued.ctx.response().getBody() == "done");
+}
+
+void test_nested_group_inherits_executor() {
+    Gecko::Engine app;
+    app.Executor("api", 1);
+    std::atomic<Gecko::ThreadPool*> ran_on{nullptr};
+    Gecko::RouteGroup api = app.Group("/api");
+    api.Executor("api");
+    api.Group("/v1").GET("/users", [&](Gecko::Context& ctx) {
+        ran_on = Gecko::ThreadPool::current();
+        ctx.string("users");
+    });
+
+    Exchange users("/api/v1/users");
+    users.serve(app);
+    assert(users.ctx.isDeferred());
+    bool answered = users.wait();
+    assert(answered);
+    assert(ran_on.load() != nullptr);
+}
+
+void test_handler_on_executor_may_defer() {
+    Gecko::Engine app;
+    app.Executor("upstream", 1);
+    app.Group("/proxy").Executor("upstream").GET("/call", [](Gecko::Context& ctx) {
+        Gecko::Responder responder = ctx.defer();
+        std::thread([responder = std::move(responder)]() mutable {
+            std::this_thread::sleep_for(10ms);
+            responder.context().status(202).string("later");
+            responder.send();
+        }).detach();
+    });
+
+    Exchange call("/proxy/call");
+    call.serve(app);
+    bool answered = call.wait();
+    assert(answered);
+    assert(call.ctx.response().getStatusCode() == 202);
+    assert(call.ctx.response().getBody() == "later");
+}
+
+/* Compress touches a deferred response only once its responder sends it */
+void test_compress_waits_for_deferred_response() {
+    Gecko::Engine app;
+    app.Use(Gecko::GeckoMiddleware::Compress());
+    std::string body(8192, 'a');
+    app.GET("/later", [&body](Gecko::Context& ctx) {
+        Gecko::Responder responder = ctx.defer();
+        std::thread([&body, responder = std::move(responder)]() mutable {
+            std::this_thread::sleep_for(10ms);
+            responder.context().header("Content-Type", "text/plain").string(body);
+            responder.send();
+        }).detach();
+    });
+
+    Exchange later("/later", {{"Accept-Encoding", "gzip"}});
+    later.serve(app);
+    assert(later.ctx.isDeferred());
+    assert(later.ctx.response().getHeaders().count("Content-Encoding") == 0);
+    bool answered = later.wait();
+    assert(answered);
+    assert(later.ctx.response().getHeaders().at("Content-Encoding") == "gzip");
+    assert(later.ctx.response().getBodyLength() < body.size());
+}
+
+int main() {
+    test_handler_runs_on_named_pool();
+    test_queue_limit_answers_503();
+    test_nested_group_inherits_executor();
+    test_handler_on_executor_may_defer();
+    test_compress_waits_for_deferred_response();
+    std::cout << "[PASS] engine tests" << std::endl;
+    return 0;
+}
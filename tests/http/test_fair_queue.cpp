@@ -0,0 +1,112 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include "fair_queue.hpp"
+
+using Gecko::FairQueue;
+using Gecko::RequestView;
+
+const char* RAW = "GET /api/orders/42?page=2 HTTP/1.1\r\n"
+                  "Host: localhost\r\n"
+                  "x-api-key:  tenant-a \r\n"
+                  "\r\n";
+
+void test_request_view() {
+    RequestView request(RAW, "10.0.0.7:51234");
+    assert(request.method() == "GET");
+    assert(request.path() == "/api/orders/42");
+    assert(request.version() == "HTTP/1.1");
+    assert(request.peer() == "10.0.0.7");
+    assert(request.header("X-API-Key") == "tenant-a");
+    assert(request.header("Host") == "localhost");
+    assert(request.header("Authorization").empty());
+
+    RequestView bare("GET / HTTP/1.1\r\n\r\n", "");
+    assert(bare.path() == "/");
+    assert(bare.header("Host").empty());
+
+    RequestView no_version("GET /\r\n\r\n", "");
+    assert(no_version.version().empty());
+}
+
+void test_classifiers() {
+    RequestView request(RAW, "10.0.0.7:51234");
+    auto by_key = Gecko::Classifiers::byHeader("X-Api-Key");
+    assert(by_key(request) == "tenant-a");
+    auto by_service = Gecko::Classifiers::byPath(2);
+    assert(by_service(request) == "/api/orders");
+    auto by_root = Gecko::Classifiers::byPath(1);
+    assert(by_root(request) == "/api");
+    auto by_peer = Gecko::Classifiers::byPeerAddress();
+    assert(by_peer(request) == "10.0.0.7");
+}
+
+void test_round_robin_with_weights() {
+    FairQueue queue;
+    queue.setWeight("gold", 3);
+    std::string order;
+
+    /* The noisy tenant queues everything first */
+    for (int i = 0; i < 12; ++i) {
+        bool queued = queue.push("noisy", [&order] { order += 'n'; });
+        assert(queued);
+    }
+    for (int i = 0; i < 6; ++i) {
+        queue.push("gold", [&order] { order += 'g'; });
+    }
+    for (int i = 0; i < 2; ++i) {
+        queue.push("quiet", [&order] { order += 'q'; });
+    }
+    assert(queue.size() == 20);
+    assert(queue.size("gold") == 6);
+
+    while (Gecko::TaskSlot task = queue.pop()) {
+        task();
+    }
+    assert(order == "ngggqngggqnnnnnnnnnn");
+    assert(queue.size() == 0);
+}
+
+void test_per_class_limit() {
+    FairQueue queue(1, 2);
+    int ran = 0;
+    bool first = queue.push("a", [&ran] { ++ran; });
+    bool second = queue.push("a", [&ran] { ++ran; });
+    bool third = queue.push("a", [&ran] { ++ran; });
+    bool other = queue.push("b", [&ran] { ++ran; });
+    assert(first && second && !third && other);
+
+    while (Gecko::TaskSlot task = queue.pop()) {
+        task();
+    }
+    assert(ran == 3);
+    /* Unweighted classes are forgotten once idle */
+    assert(queue.size("a") == 0);
+    Gecko::TaskSlot none = queue.pop();
+    assert(!none);
+}
+
+void test_costs_use_deficit() {
+    FairQueue queue(4);
+    std::string order;
+    queue.push("big", [&order] { order += 'B'; }, 8);
+    queue.push("big", [&order] { order += 'B'; }, 8);
+    for (int i = 0; i < 8; ++i) {
+        queue.push("small", [&order] { order += 's'; }, 1);
+    }
+    while (Gecko::TaskSlot task = queue.pop()) {
+        task();
+    }
+    /* Expensive tasks wait until their class has saved up enough credit */
+    assert(order == "ssssBssssB");
+}
+
+int main() {
+    test_request_view();
+    test_classifiers();
+    test_round_robin_with_weights();
+    test_per_class_limit();
+    test_costs_use_deficit();
+    std::cout << "[PASS] fair queue tests" << std::endl;
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "context.hpp"
+#include "file_response.hpp"
+
+using Outcome = Gecko::ConditionalResult::Outcome;
+
+Gecko::HttpRequest makeRequest(Gecko::HttpMethod method, Gecko::HttpHeaderMap headers) {
+    return Gecko::HttpRequest(method, "/file", Gecko::HttpVersion::HTTP_1_1, std::move(headers), "");
+}
+
+std::string header(const Gecko::HttpResponse& response, const std::string& key) {
+    auto it = response.getHeaders().find(key);
+    return it == response.getHeaders().end() ? std::string() : std::string(it->second);
+}
+
+void test_parse_range_header() {
+    auto single = Gecko::parseRangeHeader("bytes=0-99", 1000);
+    assert(single.outcome == Outcome::PARTIAL);
+    assert(single.ranges.size() == 1 && single.ranges[0].offset == 0 && single.ranges[0].length == 100);
+
+    auto open_ended = Gecko::parseRangeHeader("bytes=900-", 1000);
+    assert(open_ended.ranges[0].offset == 900 && open_ended.ranges[0].length == 100);
+
+    auto suffix = Gecko::parseRangeHeader("bytes=-300", 1000);
+    assert(suffix.ranges[0].offset == 700 && suffix.ranges[0].length == 300);
+
+    auto clamped = Gecko::parseRangeHeader("bytes=990-5000", 1000);
+    assert(clamped.ranges[0].length == 10);
+
+    /* Sorted and coalesced */
+    auto multi = Gecko::parseRangeHeader("bytes=500-599, 0-9, 5-19", 1000);
+    assert(multi.ranges.size() == 2);
+    assert(multi.ranges[0].offset == 0 && multi.ranges[0].length == 20);
+    assert(multi.ranges[1].offset == 500);
+
+    assert(Gecko::parseRangeHeader("bytes=1000-", 1000).outcome == Outcome::UNSATISFIABLE);
+    assert(Gecko::parseRangeHeader("bytes=-0", 1000).outcome == Outcome::UNSATISFIABLE);
+    assert(Gecko::parseRangeHeader("bytes=5-1", 1000).outcome == Outcome::FULL);
+    assert(Gecko::parseRangeHeader("items=0-1", 1000).outcome == Outcome::FULL);
+    assert(Gecko::parseRangeHeader("bytes=abc", 1000).outcome == Outcome::FULL);
+}
+
+void test_conditionals() {
+    const std::string etag = "\"abc-10\"";
+    const time_t modified = 1700000000;
+    std::string date = Gecko::httpDate(modified);
+    assert(Gecko::parseHttpDate(date) == modified);
+
+    Gecko::HttpHeaderMap headers;
+    headers["If-None-Match"] = "\"zzz\", W/\"abc-10\"";
+    auto result = Gecko::evaluateConditional(makeRequest(Gecko::HttpMethod::GET, headers), etag, modified, 10);
+    assert(result.outcome == Outcome::NOT_MODIFIED);
+
+    Gecko::HttpHeaderMap since;
+    since["If-Modified-Since"] = date;
+    result = Gecko::evaluateConditional(makeRequest(Gecko::HttpMethod::GET, since), etag, modified, 10);
+    assert(result.outcome == Outcome::NOT_MODIFIED);
+    result = Gecko::evaluateConditional(makeRequest(Gecko::HttpMethod::GET, since), etag, modified + 1, 10);
+    assert(result.outcome == Outcome::FULL);
+
+    /* If-Range: a stale validator means the whole body */
+    Gecko::HttpHeaderMap ranged;
+    ranged["Range"] = "bytes=2-4";
+    ranged["If-Range"] = etag;
+    result = Gecko::evaluateConditional(makeRequest(Gecko::HttpMethod::GET, ranged), etag, modified, 10);
+    assert(result.outcome == Outcome::PARTIAL);
+    ranged["If-Range"] = "\"old\"";
+    result = Gecko::evaluateConditional(makeRequest(Gecko::HttpMethod::GET, ranged), etag, modified, 10);
+    assert(result.outcome == Outcome::FULL);
+    ranged["If-Range"] = date;
+    result = Gecko::evaluateConditional(makeRequest(Gecko::HttpMethod::GET, ranged), etag, modified, 10);
+    assert(result.outcome == Outcome::PARTIAL);
+
+    /* Range is ignored for HEAD */
+    ranged.erase("If-Range");
+    result = Gecko::evaluateConditional(makeRequest(Gecko::HttpMethod::HEAD, ranged), etag, modified, 10);
+    assert(result.outcome == Outcome::FULL);
+}
+
+void test_context_file_ranges() {
+    char path[] = "/tmp/gecko_file_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    std::string contents;
+    for (int i = 0; i < 1000; ++i) {
+        contents += static_cast<char>('a' + i % 26);
+    }
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << contents;
+    }
+
+    Gecko::HttpHeaderMap headers;
+    headers["Range"] = "bytes=100-199";
+    auto request = makeRequest(Gecko::HttpMethod::GET, headers);
+    Gecko::Context ctx(request);
+    ctx.file(path);
+    assert(ctx.response().getStatusCode() == 206);
+    assert(header(ctx.response(), "Content-Range") == "bytes 100-199/1000");
+    assert(header(ctx.response(), "Accept-Ranges") == "bytes");
+    const auto& segments = ctx.response().getBodySegments();
+    assert(segments.size() == 1 && Gecko::isFileSegment(segments[0]));
+    assert(std::get<Gecko::FileSegment>(segments[0]).offset == 100);
+    std::string_view range_body = ctx.response().flattenBody();
+    assert(range_body == contents.substr(100, 100));
+
+    headers["Range"] = "bytes=0-1,-2";
+    auto multi_request = makeRequest(Gecko::HttpMethod::GET, headers);
+    Gecko::Context multi(multi_request);
+    multi.file(path);
+    assert(multi.response().getStatusCode() == 206);
+    std::string type = header(multi.response(), "Content-Type");
+    assert(type.rfind("multipart/byteranges; boundary=", 0) == 0);
+    std::string boundary = type.substr(type.find('=') + 1);
+    std::string body(multi.response().flattenBody());
+    assert(body.rfind("--" + boundary + "\r\n", 0) == 0);
+    assert(body.find("Content-Range: bytes 0-1/1000\r\n\r\nab\r\n--" + boundary) != std::string::npos);
+    assert(body.find("Content-Range: bytes 998-999/1000\r\n\r\n" + contents.substr(998)) != std::string::npos);
+    assert(body.size() >= boundary.size() + 8);
+    assert(body.substr(body.size() - boundary.size() - 8) == "\r\n--" + boundary + "--\r\n");
+
+    headers["Range"] = "bytes=5000-";
+    auto bad_request = makeRequest(Gecko::HttpMethod::GET, headers);
+    Gecko::Context unsatisfiable(bad_request);
+    unsatisfiable.file(path);
+    assert(unsatisfiable.response().getStatusCode() == 416);
+    assert(header(unsatisfiable.response(), "Content-Range") == "bytes */1000");
+
+    Gecko::HttpHeaderMap revalidate;
+    revalidate["If-None-Match"] = header(ctx.response(), "ETag");
+    auto revalidate_request = makeRequest(Gecko::HttpMethod::GET, revalidate);
+    Gecko::Context not_modified(revalidate_request);
+    not_modified.file(path);
+    assert(not_modified.response().getStatusCode() == 304);
+    assert(not_modified.response().getBodyLength() == 0);
+
+    auto missing_request = makeRequest(Gecko::HttpMethod::GET, {});
+    Gecko::Context missing(missing_request);
+    missing.file(std::string(path) + ".missing");
+    assert(missing.response().getStatusCode() == 404);
+
+    unlink(path);
+}
+
+int main() {
+    test_parse_range_header();
+    test_conditionals();
+    test_context_file_ranges();
+    std::cout << "[PASS] file response tests" << std::endl;
+    return 0;
+}
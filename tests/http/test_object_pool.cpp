@@ -0,0 +1,139 @@
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "context.hpp"
+#include "object_pool.hpp"
+
+void test_context_reset_on_release() {
+    Gecko::HttpRequest request(Gecko::HttpMethod::GET, "/users/1?x=1", Gecko::HttpVersion::HTTP_1_1,
+                               {{"Host", "example.com"}}, "");
+    Gecko::Context* raw = nullptr;
+    {
+        auto ctx = Gecko::ObjectPool<Gecko::Context>::local().acquire();
+        raw = ctx.get();
+        ctx->setRequest(request);
+        ctx->setParams({{"id", "1"}});
+        ctx->set("user", std::string("alice"));
+        ctx->status(404).string("missing");
+        assert(ctx->query("x") == "1");
+    }
+
+    auto reused = Gecko::ObjectPool<Gecko::Context>::local().acquire();
+    assert(reused.get() == raw);
+    assert(reused->param("id").empty());
+    assert(!reused->has("user"));
+    assert(reused->response().getStatusCode() == 200);
+    assert(reused->response().getReasonPhrase() == "OK");
+    assert(reused->response().getBody().empty());
+    assert(reused->response().getHeaders().empty());
+}
+
+void test_request_reset_keeps_capacity() {
+    auto& pool = Gecko::ObjectPool<Gecko::HttpRequest>::local();
+    Gecko::HttpRequest* raw = nullptr;
+    {
+        auto request = pool.acquire();
+        raw = request.get();
+        request->setBody(std::string(4096, 'x'));
+        request->setUrl("/search?q=gecko");
+    }
+    auto request = pool.acquire();
+    assert(request.get() == raw);
+    assert(request->getBody().empty());
+    assert(request->getBody().capacity() >= 4096);
+    assert(request->getUrl().empty());
+    assert(request->getQueryParams().empty());
+    assert(request->getMethod() == Gecko::HttpMethod::UNKNOWN);
+}
+
+/* A context finished on another thread goes back to the pool that handed it out */
+void test_release_returns_to_owner() {
+    auto& pool = Gecko::ObjectPool<Gecko::Context>::local();
+    auto ctx = pool.acquire();
+    Gecko::Context* raw = ctx.get();
+    ctx->status(500);
+    std::thread([ctx = std::move(ctx)]() mutable {
+        auto foreign = Gecko::ObjectPool<Gecko::Context>::local().acquire();
+        ctx.reset();
+        assert(Gecko::ObjectPool<Gecko::Context>::local().available_count() == 0);
+    }).join();
+
+    std::vector<Gecko::ObjectPool<Gecko::Context>::Handle> taken;
+    bool found = false;
+    while (!found && pool.available_count() > 0) {
+        taken.push_back(pool.acquire());
+        found = taken.back().get() == raw;
+    }
+    assert(found);
+    assert(taken.back()->response().getStatusCode() == 200);
+}
+
+void test_context_arena_rewinds_on_reset() {
+    Gecko::Context ctx;
+    void* first = ctx.arena()->allocate(64);
+    Gecko::HttpRequest& request = ctx.requestStorage();
+    request.setUrl("/items?page=2");
+    ctx.setRequest(request);
+    assert(ctx.request().getQueryParam("page") == "2");
+    assert(ctx.request().getQueryParams().get_allocator().resource() == ctx.arena());
+    assert(ctx.response().getHeaders().get_allocator().resource() == ctx.arena());
+
+    ctx.reset();
+    assert(ctx.requestStorage().getQueryParams().empty());
+    /* Monotonic arena restarts from its initial block */
+    void* again = ctx.arena()->allocate(64);
+    assert(again == first);
+}
+
+/* Keys and values sit on the arena too; a request moved out of the context survives its reset */
+void test_request_leaves_arena_on_move() {
+    Gecko::Context ctx;
+    Gecko::HttpRequest& request = ctx.requestStorage();
+    Gecko::HttpHeaderMap headers(ctx.arena());
+    headers.emplace("X-Long-Header-Name-Beyond-SSO", "a value long enough to need its own allocation");
+    request.setHeaders(std::move(headers));
+    request.setUrl("/items?category=a-query-value-long-enough-to-allocate");
+
+    const auto& stored = request.getHeaders().begin()->second;
+    assert(stored.get_allocator().resource() == ctx.arena());
+    assert(request.getQueryParams().begin()->first.get_allocator().resource() == ctx.arena());
+    auto found = request.getHeaders().find(std::string_view("x-long-header-name-beyond-sso"));
+    assert(found != request.getHeaders().end());
+
+    Gecko::HttpRequest moved(std::move(request));
+    Gecko::HttpRequest copied(moved);
+    assert(moved.resource() == std::pmr::get_default_resource());
+    assert(moved.getHeaders().begin()->second.get_allocator().resource() == std::pmr::get_default_resource());
+    ctx.reset();
+    assert(moved.getHeaders().begin()->second == "a value long enough to need its own allocation");
+    assert(moved.getQueryParam("category") == "a-query-value-long-enough-to-allocate");
+
+    /* Assignment keeps the target on its own arena */
+    Gecko::HttpRequest& target = ctx.requestStorage();
+    target = copied;
+    assert(target.resource() == ctx.arena());
+    assert(target.getHeaders().begin()->second.get_allocator().resource() == ctx.arena());
+    assert(target.getQueryParam("category") == "a-query-value-long-enough-to-allocate");
+    target.reset();
+}
+
+void test_moved_response_leaves_arena() {
+    Gecko::Context ctx;
+    ctx.header("X-Test", "1");
+    Gecko::HttpResponse moved(std::move(ctx.response()));
+    assert(moved.getHeaders().get_allocator().resource() == std::pmr::get_default_resource());
+    Gecko::HttpResponse copied(moved);
+    assert(copied.getHeaders().size() == 1);
+}
+
+int main() {
+    test_context_reset_on_release();
+    test_request_reset_keeps_capacity();
+    test_release_returns_to_owner();
+    test_context_arena_rewinds_on_reset();
+    test_moved_response_leaves_arena();
+    test_request_leaves_arena_on_move();
+    std::cout << "[PASS] object pool tests" << std::endl;
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+#include "response_cache.hpp"
+
+std::string flatten(const Gecko::PooledBuffer& head, const std::vector<Gecko::BodySegment>& segments) {
+    std::string out(head.view());
+    for (const auto& segment : segments) {
+        out.append(Gecko::segmentView(segment));
+    }
+    return out;
+}
+
+void test_match_and_serialize() {
+    Gecko::ResponseCache cache;
+    Gecko::HttpResponse response;
+    response.addHeader("Content-Type", "application/json");
+    response.addHeader("Connection", "close");  /* Replaced per connection */
+    response.setBody("{\"ok\":true}");
+    cache.put(Gecko::HttpMethod::GET, "/healthz", response);
+
+    auto hit = cache.match("GET /healthz?probe=1 HTTP/1.1\r\nHost: x\r\n\r\n");
+    assert(hit.entry && hit.keep_alive);
+
+    std::vector<Gecko::BodySegment> segments;
+    auto head = Gecko::ResponseCache::serialize(*hit.entry, Gecko::ConnectionHeader::KEEP_ALIVE, segments);
+    std::string out = flatten(head, segments);
+    assert(out.rfind("HTTP/1.1 200 OK\r\nDate: ", 0) == 0);
+    assert(out.find("Content-Type: application/json\r\n") != std::string::npos);
+    assert(out.find("Content-Length: 11\r\n") != std::string::npos);
+    assert(out.find("Connection: keep-alive\r\n") != std::string::npos);
+    assert(out.find("Connection: close") == std::string::npos);
+    assert(out.substr(out.size() - 15) == "\r\n\r\n{\"ok\":true}");
+
+    /* Shared buffers are the entry's own, not copies */
+    assert(std::get<std::shared_ptr<const std::string>>(segments[0]) == hit.entry->fields);
+
+    head = Gecko::ResponseCache::serialize(*hit.entry, Gecko::ConnectionHeader::CLOSE, segments);
+    assert(flatten(head, segments).find("Connection: close\r\n\r\n{") != std::string::npos);
+}
+
+void test_connection_preference_and_misses() {
+    Gecko::ResponseCache cache;
+    cache.put(Gecko::HttpMethod::GET, "/flags", Gecko::HttpResponse());
+
+    assert(!cache.match("GET /flags HTTP/1.1\r\nConnection: close\r\n\r\n").keep_alive);
+    assert(!cache.match("GET /flags HTTP/1.0\r\n\r\n").keep_alive);
+    assert(cache.match("GET /flags HTTP/1.0\r\nconnection: Keep-Alive\r\n\r\n").keep_alive);
+
+    assert(!cache.match("POST /flags HTTP/1.1\r\n\r\n").entry);
+    assert(!cache.match("GET /flags/x HTTP/1.1\r\n\r\n").entry);
+    assert(!cache.match("GET /flags HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc").entry);
+    assert(!cache.match("garbage").entry);
+}
+
+void test_refresh_publishes_new_version() {
+    Gecko::ResponseCache cache;
+    int generation = 0;
+    cache.put(Gecko::HttpMethod::GET, "/config", [&generation]() {
+        Gecko::HttpResponse response;
+        response.setBody("v" + std::to_string(++generation));
+        return response;
+    });
+
+    auto first = cache.find(Gecko::HttpMethod::GET, "/config");
+    assert(first->version == 1);
+    assert(cache.refresh(Gecko::HttpMethod::GET, "/config"));
+
+    auto second = cache.find(Gecko::HttpMethod::GET, "/config");
+    assert(second->version == 2);
+    assert(second->source.getBody() == "v2");
+    assert(first->source.getBody() == "v1");  /* In-flight snapshots stay intact */
+
+    cache.put(Gecko::HttpMethod::GET, "/static", Gecko::HttpResponse());
+    assert(!cache.refresh(Gecko::HttpMethod::GET, "/static"));
+    cache.remove(Gecko::HttpMethod::GET, "/config");
+    assert(!cache.find(Gecko::HttpMethod::GET, "/config"));
+}
+
+int main() {
+    test_match_and_serialize();
+    test_connection_preference_and_misses();
+    test_refresh_publishes_new_version();
+    std::cout << "[PASS] response cache tests" << std::endl;
+    return 0;
+}
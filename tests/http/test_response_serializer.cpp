@@ -0,0 +1,142 @@
+#include <cassert>
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "http_response.hpp"
+
+void test_status_line_follows_code() {
+    Gecko::HttpResponse response;
+    response.setStatusCode(404);
+    response.setBody("missing");
+    std::string out;
+    response.serializeTo(out);
+    assert(out.rfind("HTTP/1.1 404 Not Found\r\n", 0) == 0);
+    assert(out.find("Content-Length: 7\r\n") != std::string::npos);
+    assert(out.find("\r\nDate: ") != std::string::npos);
+    assert(out.size() == response.estimateSerializedSize());
+    assert(out.substr(out.size() - 11) == "\r\n\r\nmissing");
+}
+
+void test_custom_reason_and_unknown_code() {
+    Gecko::HttpResponse response;
+    response.setStatusCode(299);
+    std::string out;
+    response.serializeTo(out);
+    assert(out.rfind("HTTP/1.1 299 Unknown\r\n", 0) == 0);
+
+    response.setStatusCode(200);
+    response.setReasonPhrase("Fine");
+    response.setVersion(Gecko::HttpVersion::HTTP_1_0);
+    response.serializeTo(out);
+    assert(out.rfind("HTTP/1.0 200 Fine\r\n", 0) == 0);
+}
+
+void test_connection_directive_replaces_map_headers() {
+    Gecko::HttpResponse response;
+    response.addHeader("Connection", "upgrade");
+    response.addHeader("Date", "Thu, 01 Jan 1970 00:00:00 GMT");
+    response.setBody("ok");
+
+    std::string out;
+    response.serializeTo(out, Gecko::ConnectionHeader::KEEP_ALIVE);
+    assert(out.find("Connection: upgrade") == std::string::npos);
+    assert(out.find("Connection: keep-alive\r\nKeep-Alive: timeout=30, max=100\r\n") != std::string::npos);
+    assert(out.find("Date: Thu, 01 Jan 1970 00:00:00 GMT\r\n") != std::string::npos);
+    assert(out.find("Date: ", out.find("1970")) == std::string::npos);
+    assert(out.size() == response.estimateSerializedSize(Gecko::ConnectionHeader::KEEP_ALIVE));
+    assert(response.getHeaders().size() == 2);
+
+    response.serializeTo(out, Gecko::ConnectionHeader::CLOSE);
+    assert(out.find("Connection: close\r\n") != std::string::npos);
+    assert(out.find("Keep-Alive") == std::string::npos);
+}
+
+void test_buffer_serializer_matches_string() {
+    Gecko::HttpResponse response = Gecko::HttpResponse::stockResponse(201);
+    response.addHeader("Content-Type", "application/json");
+    response.setBody("{}");
+    std::string expected = Gecko::HttpResponseSerializer::serialize(response);
+
+    char buffer[512];
+    size_t written = Gecko::HttpResponseSerializer::serializeToBuffer(response, buffer, sizeof(buffer));
+    assert(std::string(buffer, written) == expected);
+    assert(Gecko::HttpResponseSerializer::serializeToBuffer(response, buffer, 16) == 0);
+}
+
+void test_body_segments_share_and_flatten() {
+    char path[] = "/tmp/gecko_segment_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    ssize_t written = write(fd, "0123456789", 10);
+    assert(written == 10);
+    close(fd);
+
+    auto shared = std::make_shared<const std::string>("{\"cached\":true}");
+    auto file = Gecko::FileHandle::open(path);
+    unlink(path);
+    assert(file->size() == 10);
+
+    Gecko::HttpResponse response;
+    response.setBody("[");
+    response.appendBody(shared);
+    response.appendFile(file, 2, 5);
+    response.appendBody(std::string("]"));
+    assert(response.getBodyLength() == 1 + shared->size() + 5 + 1);
+
+    /* Inline part carries the full Content-Length but only the inline body */
+    std::string head(response.estimateInlineSize(), '\0');
+    response.writeInlineTo(head.data());
+    assert(head.find("Content-Length: 22\r\n") != std::string::npos);
+    assert(head.back() == '[');
+
+    std::string out;
+    response.serializeTo(out);
+    assert(out.size() == response.estimateSerializedSize());
+    assert(out.substr(out.size() - 22) == "[{\"cached\":true}23456]");
+    assert(response.getBodySegments().size() == 3);
+    assert(response.getBody() == "[");
+    assert(response.getBodySegments().size() == 3);
+
+    std::string_view flat_body = response.flattenBody();
+    assert(flat_body == "[{\"cached\":true}23456]");
+    assert(response.getBodySegments().empty());
+    assert(shared.use_count() == 1);
+}
+
+/* One Head sizes and writes; custom reason phrases point into its scratch */
+void test_head_computed_once() {
+    Gecko::HttpResponse response;
+    response.setStatusCode(299);
+    response.setBody("ok");
+    response.addHeader("X-\xC4\xD6", "\xFF");
+    response.addHeader("Content-Length", "2");
+
+    Gecko::HttpResponse::Head head(response, Gecko::ConnectionHeader::CLOSE);
+    assert(head.has_content_length);
+    assert(!head.has_date);
+    assert(head.body_length == 2);
+    assert(head.size == head.inline_size);
+
+    std::string out(head.size, '\0');
+    char* end = response.writeTo(out.data(), head);
+    assert(end == out.data() + out.size());
+    assert(out.rfind("HTTP/1.1 299 ", 0) == 0);
+    assert(out.find("Content-Length: 2\r\n") == out.rfind("Content-Length"));
+    assert(out.find("Connection: close\r\n") != std::string::npos);
+
+    std::string direct;
+    response.serializeTo(direct, Gecko::ConnectionHeader::CLOSE);
+    assert(direct.size() == out.size());
+}
+
+int main() {
+    test_status_line_follows_code();
+    test_custom_reason_and_unknown_code();
+    test_connection_directive_replaces_map_headers();
+    test_buffer_serializer_matches_string();
+    test_body_segments_share_and_flatten();
+    test_head_computed_once();
+    std::cout << "[PASS] response serializer tests" << std::endl;
+    return 0;
+}
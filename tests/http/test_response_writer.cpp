@@ -0,0 +1,204 @@
+#include <cassert>
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include "fiber.hpp"
+#include "response_writer.hpp"
+#include "server.hpp"
+#include "thread_pool.hpp"
+
+/* Decode a chunked body; returns false on malformed framing */
+bool decode_chunked(const std::string& wire, std::string& body) {
+    size_t pos = wire.find("\r\n\r\n");
+    if (pos == std::string::npos) return false;
+    pos += 4;
+    while (true) {
+        size_t line_end = wire.find("\r\n", pos);
+        if (line_end == std::string::npos) return false;
+        size_t size = std::stoul(wire.substr(pos, line_end - pos), nullptr, 16);
+        pos = line_end + 2;
+        if (size == 0) return wire.compare(pos, 2, "\r\n") == 0;
+        body.append(wire, pos, size);
+        pos += size;
+        if (wire.compare(pos, 2, "\r\n") != 0) return false;
+        pos += 2;
+    }
+}
+
+void test_buffering_writer_appends_to_body() {
+    Gecko::HttpResponse response;
+    {
+        Gecko::ResponseWriter writer(response);
+        assert(!writer.streaming());
+        writer.write("hello ");
+        writer.write(std::make_shared<const std::string>("world"));
+    }
+    std::string_view flat_body = response.flattenBody();
+    assert(flat_body == "hello world");
+}
+
+void test_chunked_stream_with_backpressure() {
+    int fds[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(paired == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    int sndbuf = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    Gecko::IOThreadPool io_pool(1);
+    auto conn = std::make_shared<Gecko::ConnectionInfo>(fds[0], "peer", "local");
+    io_pool.register_read(conn, [](std::shared_ptr<Gecko::ConnectionInfo>, const std::string&) {});
+
+    constexpr size_t HIGH = 8192;
+    constexpr size_t CHUNK = 1000;
+    constexpr int CHUNKS = 200;
+    std::atomic<bool> completed{false};
+    size_t max_queued = 0;
+
+    std::thread producer([&]() {
+        Gecko::HttpResponse response;
+        response.addHeader("Content-Type", "text/plain");
+        Gecko::ResponseWriter writer(io_pool, conn, response, Gecko::ConnectionHeader::CLOSE,
+            [&completed](std::shared_ptr<Gecko::ConnectionInfo>, bool success) { completed = success; },
+            HIGH, 2048);
+        for (int i = 0; i < CHUNKS; ++i) {
+            bool written = writer.write(std::string(CHUNK, static_cast<char>('a' + i % 26)));
+            assert(written);
+            max_queued = std::max(max_queued, writer.queued_bytes());
+        }
+    });
+
+    /* Slow reader */
+    std::string wire;
+    char buffer[2048];
+    while (wire.size() < 5 || wire.compare(wire.size() - 5, 5, "0\r\n\r\n") != 0) {
+        ssize_t n = read(fds[1], buffer, sizeof(buffer));
+        assert(n > 0);
+        wire.append(buffer, n);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    producer.join();
+
+    assert(wire.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    assert(wire.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+    assert(wire.find("Content-Length") == std::string::npos);
+    std::string body;
+    assert(decode_chunked(wire, body));
+    assert(body.size() == CHUNK * CHUNKS);
+    assert(body.substr(CHUNK, 3) == "bbb");
+    assert(max_queued <= HIGH + 2 * CHUNK);  /* Producer was held back */
+
+    for (int i = 0; i < 100 && !completed; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(completed);
+    io_pool.stop();
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/* On a fiber, backpressure parks the producer and the only worker keeps serving */
+void test_backpressure_parks_fiber() {
+    int fds[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(paired == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    int sndbuf = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    Gecko::IOThreadPool io_pool(1);
+    Gecko::ThreadPool workers(1);
+    auto conn = std::make_shared<Gecko::ConnectionInfo>(fds[0], "peer", "local");
+    io_pool.register_read(conn, [](std::shared_ptr<Gecko::ConnectionInfo>, const std::string&) {});
+
+    constexpr size_t CHUNK = 1000;
+    constexpr int CHUNKS = 100;
+    std::atomic<bool> completed{false};
+    std::atomic<int> written{0};
+    Gecko::HttpResponse response;
+    workers.post([&] {
+        Gecko::Fiber::start([&] {
+            Gecko::ResponseWriter writer(io_pool, conn, response, Gecko::ConnectionHeader::CLOSE,
+                [&completed](std::shared_ptr<Gecko::ConnectionInfo>, bool success) { completed = success; },
+                8192, 2048);
+            for (int i = 0; i < CHUNKS; ++i) {
+                writer.write(std::string(CHUNK, 'x'));
+                written++;
+            }
+        });
+    });
+
+    /* Nobody reads yet: the producer stalls early, but the worker is free */
+    auto other = workers.enqueue([] { return 7; });
+    bool served = other.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+    assert(served);
+    assert(written.load() < CHUNKS);
+
+    std::string wire;
+    char buffer[4096];
+    while (wire.size() < 5 || wire.compare(wire.size() - 5, 5, "0\r\n\r\n") != 0) {
+        ssize_t n = read(fds[1], buffer, sizeof(buffer));
+        assert(n > 0);
+        wire.append(buffer, n);
+    }
+    std::string body;
+    assert(decode_chunked(wire, body));
+    assert(body.size() == CHUNK * CHUNKS);
+    for (int i = 0; i < 100 && !completed; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(completed);
+    io_pool.stop();
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_head_only_sends_no_body() {
+    int fds[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(paired == 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    Gecko::IOThreadPool io_pool(1);
+    auto conn = std::make_shared<Gecko::ConnectionInfo>(fds[0], "peer", "local");
+    io_pool.register_read(conn, [](std::shared_ptr<Gecko::ConnectionInfo>, const std::string&) {});
+
+    std::atomic<bool> completed{false};
+    Gecko::HttpResponse response;
+    response.setBody("already buffered");
+    {
+        Gecko::ResponseWriter writer(io_pool, conn, response, Gecko::ConnectionHeader::CLOSE,
+            [&completed](std::shared_ptr<Gecko::ConnectionInfo>, bool success) { completed = success; });
+        writer.end_head_only();
+        bool refused = writer.write("late");
+        assert(!refused);
+    }
+    for (int i = 0; i < 100 && !completed; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(completed);
+
+    std::string wire;
+    char buffer[4096];
+    ssize_t n = read(fds[1], buffer, sizeof(buffer));
+    assert(n > 0);
+    wire.append(buffer, n);
+    assert(wire.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+    assert(wire.size() == wire.find("\r\n\r\n") + 4);
+    io_pool.stop();
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main() {
+    test_buffering_writer_appends_to_body();
+    test_chunked_stream_with_backpressure();
+    test_backpressure_parks_fiber();
+    test_head_only_sends_no_body();
+    std::cout << "[PASS] response writer tests" << std::endl;
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <cassert>
 #include "http/http_request.hpp"
+#include "http/fast_http_parser.hpp"
 
 void test_whitespace_trimming() {
     std::string raw_request = 
@@ -98,6 +99,29 @@ void test_multiple_header_values() {
     }
 }
 
+/* The server's parser keeps the same last-value-wins rule, whatever the case of the name */
+void test_multiple_header_values_fast_path() {
+    std::string raw_request =
+        "GET /api/data HTTP/1.1\r\n"
+        "Host: api.example.com\r\n"
+        "Accept: application/json\r\n"
+        "accept: text/html\r\n"
+        "X-Custom: value1\r\n"
+        "X-Custom: value2\r\n"
+        "\r\n";
+
+    Gecko::FastHttpRequest fast_request;
+    bool parsed = Gecko::FastHttpParser::parse(raw_request, fast_request);
+    assert(parsed);
+    Gecko::HttpRequest request;
+    Gecko::HttpRequestAdapter::convert(fast_request, request);
+
+    const auto& headers = request.getHeaders();
+    assert(headers.size() == 3);
+    assert(headers.find(std::string_view("Accept"))->second == "text/html");
+    assert(headers.find(std::string_view("X-Custom"))->second == "value2");
+}
+
 void test_empty_header_value() {
     std::string raw_request = 
         "GET /api/test HTTP/1.0\r\n"
@@ -196,6 +220,7 @@ int main() {
     test_long_url();
     test_unicode_in_headers();
     test_multiple_header_values();
+    test_multiple_header_values_fast_path();
     test_empty_header_value();
     test_large_body();
     test_zero_content_length();
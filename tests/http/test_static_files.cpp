@@ -0,0 +1,303 @@
+#include <cassert>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/time.h>
+#include <thread>
+#include "compression.hpp"
+#include "static_files.hpp"
+
+namespace fs = std::filesystem;
+
+void writeFile(const fs::path& path, const std::string& contents) {
+    fs::create_directories(path.parent_path());
+    std::ofstream out(path, std::ios::binary);
+    out << contents;
+}
+
+/* Precompressed siblings are only trusted when at least as new as the source */
+void setMtime(const fs::path& path, time_t seconds) {
+    struct timeval times[2] = {{seconds, 0}, {seconds, 0}};
+    utimes(path.c_str(), times);
+}
+
+Gecko::HttpRequest makeRequest(Gecko::HttpMethod method, const std::string& accept_encoding) {
+    Gecko::HttpHeaderMap headers;
+    if (!accept_encoding.empty()) {
+        headers["Accept-Encoding"] = accept_encoding;
+    }
+    return Gecko::HttpRequest(method, "/", Gecko::HttpVersion::HTTP_1_1, std::move(headers), "");
+}
+
+std::string header(const Gecko::HttpResponse& response, const std::string& key) {
+    auto it = response.getHeaders().find(key);
+    return it == response.getHeaders().end() ? std::string() : std::string(it->second);
+}
+
+struct TempRoot {
+    fs::path path;
+    TempRoot() {
+        char pattern[] = "/tmp/gecko_static_XXXXXX";
+        path = mkdtemp(pattern);
+    }
+    ~TempRoot() { fs::remove_all(path); }
+};
+
+void test_resolve_rejects_traversal() {
+    Gecko::StaticFiles files("/srv/www/");
+    assert(files.resolve("css/site.css") == std::optional<std::string>("/srv/www/css/site.css"));
+    assert(files.resolve("") == std::optional<std::string>("/srv/www/index.html"));
+    assert(files.resolve("docs/") == std::optional<std::string>("/srv/www/docs/index.html"));
+    assert(files.resolve("a%20b+c.txt?v=2") == std::optional<std::string>("/srv/www/a b+c.txt"));
+    assert(!files.resolve("../etc/passwd"));
+    assert(!files.resolve("css/%2e%2e/%2e%2e/etc/passwd"));
+}
+
+void test_precompressed_negotiation() {
+    TempRoot root;
+    writeFile(root.path / "app.js", std::string(4096, 'a'));
+    writeFile(root.path / "app.js.gz", "gzip-bytes");
+    writeFile(root.path / "app.js.br", "br");
+    setMtime(root.path / "app.js", 1000);
+    setMtime(root.path / "app.js.gz", 2000);
+    setMtime(root.path / "app.js.br", 2000);
+    Gecko::StaticFiles files(root.path.string());
+
+    auto request = makeRequest(Gecko::HttpMethod::GET, "gzip, deflate, br");
+    Gecko::Context ctx(request);
+    files.serve(ctx, "app.js");
+    assert(ctx.response().getStatusCode() == 200);
+    assert(header(ctx.response(), "Content-Encoding") == "br");
+    assert(header(ctx.response(), "Vary") == "Accept-Encoding");
+    assert(header(ctx.response(), "Content-Type") == "text/javascript; charset=utf-8");
+    assert(ctx.response().getBodySegments().size() == 1);
+    assert(Gecko::isFileSegment(ctx.response().getBodySegments()[0]));
+    std::string_view flat_body = ctx.response().flattenBody();
+    assert(flat_body == "br");
+
+    /* q-values outrank server preference */
+    auto gzip_request = makeRequest(Gecko::HttpMethod::GET, "br;q=0.5, gzip");
+    Gecko::Context gzip_ctx(gzip_request);
+    files.serve(gzip_ctx, "app.js");
+    assert(header(gzip_ctx.response(), "Content-Encoding") == "gzip");
+    std::string_view gzip_body = gzip_ctx.response().flattenBody();
+    assert(gzip_body == "gzip-bytes");
+    assert(header(gzip_ctx.response(), "ETag") != header(ctx.response(), "ETag"));
+
+    auto plain_request = makeRequest(Gecko::HttpMethod::GET, "");
+    Gecko::Context plain_ctx(plain_request);
+    files.serve(plain_ctx, "app.js");
+    assert(header(plain_ctx.response(), "Content-Encoding").empty());
+    assert(plain_ctx.response().getBodyLength() == 4096);
+
+    /* Stale sibling is ignored */
+    setMtime(root.path / "app.js.br", 500);
+    Gecko::Context stale_ctx(request);
+    files.serve(stale_ctx, "app.js");
+    assert(header(stale_ctx.response(), "Content-Encoding") == "gzip");
+
+    auto head_request = makeRequest(Gecko::HttpMethod::HEAD, "gzip");
+    Gecko::Context head_ctx(head_request);
+    files.serve(head_ctx, "app.js");
+    assert(header(head_ctx.response(), "Content-Length") == "10");
+    assert(head_ctx.response().getBodyLength() == 0);
+
+    Gecko::Context missing_ctx(request);
+    files.serve(missing_ctx, "missing.js");
+    assert(missing_ctx.response().getStatusCode() == 404);
+}
+
+/* Sibling probes are remembered per source and redone when it changes */
+void test_sibling_memo() {
+    TempRoot root;
+    writeFile(root.path / "big.js", std::string(4096, 'a'));
+    writeFile(root.path / "big.js.br", "br-v1");
+    setMtime(root.path / "big.js", 1000);
+    setMtime(root.path / "big.js.br", 2000);
+    Gecko::StaticFiles files(root.path.string());
+    auto request = makeRequest(Gecko::HttpMethod::GET, "br, gzip");
+
+    Gecko::Context first(request);
+    files.serve(first, "big.js");
+    assert(header(first.response(), "Content-Encoding") == "br");
+
+    /* Removed behind the memo's back: served as identity, not an error */
+    fs::remove(root.path / "big.js.br");
+    Gecko::Context removed(request);
+    files.serve(removed, "big.js");
+    assert(removed.response().getStatusCode() == 200);
+    assert(header(removed.response(), "Content-Encoding").empty());
+
+    /* A new source version is probed again */
+    writeFile(root.path / "big.js.gz", "gz-v2");
+    writeFile(root.path / "big.js", std::string(4097, 'b'));
+    setMtime(root.path / "big.js", 3000);
+    setMtime(root.path / "big.js.gz", 4000);
+    Gecko::Context updated(request);
+    files.serve(updated, "big.js");
+    assert(header(updated.response(), "Content-Encoding") == "gzip");
+    std::string_view updated_body = updated.response().flattenBody();
+    assert(updated_body == "gz-v2");
+}
+
+void test_compress_at_startup() {
+    if (!Gecko::compressionAvailable()) {
+        return;
+    }
+    TempRoot root;
+    std::string css;
+    for (int i = 0; i < 200; ++i) {
+        css += ".rule-" + std::to_string(i) + " { color: red; }\n";
+    }
+    writeFile(root.path / "css" / "site.css", css);
+    writeFile(root.path / "logo.png", std::string(4096, 'x'));
+
+    Gecko::StaticOptions options;
+    options.compress_at_startup = true;
+    Gecko::StaticFiles files(root.path.string(), options);
+    assert(files.generated_variants() == 1);
+
+    auto request = makeRequest(Gecko::HttpMethod::GET, "gzip");
+    Gecko::Context ctx(request);
+    files.serve(ctx, "css/site.css");
+    assert(header(ctx.response(), "Content-Encoding") == "gzip");
+    assert(ctx.response().getBodyLength() < css.size());
+    assert(!Gecko::isFileSegment(ctx.response().getBodySegments()[0]));
+
+    Gecko::Context png_ctx(request);
+    files.serve(png_ctx, "logo.png");
+    assert(header(png_ctx.response(), "Content-Encoding").empty());
+}
+
+/* Wait for the inotify watcher to drop an entry */
+bool waitForEviction(const Gecko::AssetCache& cache, size_t expected_entries) {
+    for (int i = 0; i < 300 && cache.entry_count() != expected_entries; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return cache.entry_count() == expected_entries;
+}
+
+void test_asset_cache_hits_and_invalidation() {
+    TempRoot root;
+    writeFile(root.path / "site.css", "body { color: red; }");
+    writeFile(root.path / "site.css.gz", "gz-v1");
+    setMtime(root.path / "site.css", 1000);
+    setMtime(root.path / "site.css.gz", 2000);
+
+    Gecko::StaticOptions options;
+    options.cache_budget = 1024 * 1024;
+    Gecko::StaticFiles files(root.path.string(), options);
+    Gecko::AssetCache* cache = files.cache();
+    if (!cache) {
+        return;  /* No inotify in this environment */
+    }
+
+    auto plain = makeRequest(Gecko::HttpMethod::GET, "");
+    Gecko::Context first(plain);
+    files.serve(first, "site.css");
+    assert(cache->entry_count() == 1);
+    assert(cache->misses() == 1);
+
+    Gecko::Context second(plain);
+    files.serve(second, "site.css");
+    assert(cache->hits() == 1);
+    std::string_view second_body = second.response().flattenBody();
+    assert(second_body == "body { color: red; }");
+    /* Body and headers are the cached buffers themselves */
+    assert(second.response().getHeaderBlock() == first.response().getHeaderBlock());
+
+    std::string wire;
+    second.response().serializeTo(wire);
+    assert(wire.find("Content-Type: text/css; charset=utf-8\r\n") != std::string::npos);
+    assert(wire.find("ETag: \"") != std::string::npos);
+    assert(wire.find("Content-Length: 20\r\n") != std::string::npos);
+
+    auto gzip = makeRequest(Gecko::HttpMethod::GET, "gzip");
+    Gecko::Context encoded(gzip);
+    files.serve(encoded, "site.css");
+    std::string_view encoded_body = encoded.response().flattenBody();
+    assert(encoded_body == "gz-v1");
+    assert(encoded.response().getHeaderBlock()->find("Content-Encoding: gzip\r\n") != std::string::npos);
+
+    /* Ranges and validators apply to cached variants too */
+    Gecko::HttpHeaderMap range_headers;
+    range_headers["Range"] = "bytes=0-3,-2";
+    Gecko::HttpRequest ranged(Gecko::HttpMethod::GET, "/", Gecko::HttpVersion::HTTP_1_1, range_headers, "");
+    Gecko::Context partial(ranged);
+    files.serve(partial, "site.css");
+    assert(partial.response().getStatusCode() == 206);
+    assert(header(partial.response(), "Content-Type").rfind("multipart/byteranges", 0) == 0);
+    assert(partial.response().getHeaderBlock()->find("Content-Type") == std::string::npos);
+    std::string_view partial_body = partial.response().flattenBody();
+    assert(partial_body.find("\r\n\r\nbody\r\n") != std::string::npos);
+
+    Gecko::HttpHeaderMap etag_headers;
+    etag_headers["If-None-Match"] = std::string(encoded.response().getHeaderBlock()->substr(
+        encoded.response().getHeaderBlock()->find("ETag: ") + 6));
+    etag_headers["If-None-Match"].resize(etag_headers["If-None-Match"].find('\r'));
+    etag_headers["Accept-Encoding"] = "gzip";
+    Gecko::HttpRequest revalidate(Gecko::HttpMethod::GET, "/", Gecko::HttpVersion::HTTP_1_1, etag_headers, "");
+    Gecko::Context not_modified(revalidate);
+    files.serve(not_modified, "site.css");
+    assert(not_modified.response().getStatusCode() == 304);
+
+    /* Rewriting a sibling drops the source's entry */
+    writeFile(root.path / "site.css.gz", "gz-v2");
+    assert(waitForEviction(*cache, 0));
+    Gecko::Context refreshed(gzip);
+    files.serve(refreshed, "site.css");
+    std::string_view refreshed_body = refreshed.response().flattenBody();
+    assert(refreshed_body == "gz-v2");
+}
+
+void test_asset_cache_clock_budget() {
+    Gecko::AssetCache cache(100);
+    if (!cache.enabled()) {
+        return;
+    }
+    TempRoot root;
+    auto make = [](size_t size) {
+        auto asset = std::make_shared<Gecko::CachedAsset>();
+        asset->variants.push_back({"", "\"x\"", std::make_shared<const std::string>(size, 'a'), nullptr});
+        return asset;
+    };
+    std::string a = (root.path / "a").string();
+    std::string b = (root.path / "b").string();
+    std::string c = (root.path / "c").string();
+    bool watching = cache.watch(a);
+    assert(watching);
+
+    bool inserted = cache.insert(a, make(40), cache.epoch());
+    assert(inserted);
+    inserted = cache.insert(b, make(40), cache.epoch());
+    assert(inserted);
+    auto touched = cache.find(a);  /* Sets a's referenced bit: the hand passes over it once */
+    assert(touched);
+    inserted = cache.insert(c, make(40), cache.epoch());
+    assert(inserted);
+    auto found_a = cache.find(a);
+    auto found_b = cache.find(b);
+    auto found_c = cache.find(c);
+    assert(found_a && found_c && !found_b);
+    assert(cache.size_bytes() == 80);
+
+    inserted = cache.insert(b, make(101), cache.epoch());  /* Larger than the budget */
+    assert(!inserted);
+    uint64_t stale = cache.epoch();
+    cache.invalidate(a);
+    inserted = cache.insert(a, make(10), stale);  /* Raced with an invalidation */
+    assert(!inserted);
+}
+
+int main() {
+    test_resolve_rejects_traversal();
+    test_precompressed_negotiation();
+    test_sibling_memo();
+    test_compress_at_startup();
+    test_asset_cache_hits_and_invalidation();
+    test_asset_cache_clock_budget();
+    std::cout << "[PASS] static files tests" << std::endl;
+    return 0;
+}
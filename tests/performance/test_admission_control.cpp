@@ -0,0 +1,125 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include "http/admission_controller.hpp"
+
+using namespace std::chrono_literals;
+using Gecko::AdmissionController;
+
+void test_burst_is_not_shed() {
+    AdmissionController controller(5ms, 100ms);
+    auto start = AdmissionController::Clock::now();
+
+    /* High delay, but for less than an interval */
+    for (int i = 0; i < 10; ++i) {
+        controller.record(20ms, start + std::chrono::milliseconds(i * 5));
+    }
+    bool admitted = controller.admit(100, start + 60ms);
+    assert(admitted);
+    assert(!controller.shedding(start + 60ms));
+
+    /* One good sample restarts the interval */
+    controller.record(1ms, start + 70ms);
+    controller.record(20ms, start + 150ms);
+    assert(!controller.shedding(start + 160ms));
+    assert(controller.rejected() == 0);
+}
+
+void test_standing_queue_is_shed() {
+    AdmissionController controller(5ms, 100ms);
+    auto start = AdmissionController::Clock::now();
+
+    for (int i = 0; i <= 12; ++i) {
+        controller.record(30ms, start + std::chrono::milliseconds(i * 10));
+    }
+    auto now = start + 125ms;
+    assert(controller.shedding(now));
+    bool admitted = controller.admit(50, now);
+    assert(!admitted);
+    assert(controller.rejected() == 1);
+
+    /* An empty queue is never shed */
+    admitted = controller.admit(0, now);
+    assert(admitted);
+
+    /* The queue drained: back under target admits at once */
+    controller.record(1ms, start + 130ms);
+    admitted = controller.admit(50, start + 131ms);
+    assert(admitted);
+}
+
+void test_shedding_lapses_without_samples() {
+    AdmissionController controller(5ms, 100ms);
+    auto start = AdmissionController::Clock::now();
+
+    controller.record(30ms, start);
+    controller.record(30ms, start + 100ms);
+    assert(controller.shedding(start + 150ms));
+    assert(!controller.shedding(start + 201ms));
+}
+
+/* Above-target samples every 10ms over [from, to] keep the episode going */
+void keepStanding(AdmissionController& controller, AdmissionController::Clock::time_point start, int from, int to) {
+    for (int ms = from; ms <= to; ms += 10) {
+        controller.record(30ms, start + std::chrono::milliseconds(ms));
+    }
+}
+
+bool admitAt(AdmissionController& controller, AdmissionController::Clock::time_point start, int ms) {
+    return controller.admit(50, start + std::chrono::milliseconds(ms));
+}
+
+void test_rejections_follow_control_law() {
+    AdmissionController controller(5ms, 100ms);
+    auto start = AdmissionController::Clock::now();
+
+    keepStanding(controller, start, 0, 100);
+    bool admitted = admitAt(controller, start, 100);  /* First rejection is immediate */
+    assert(!admitted);
+    admitted = admitAt(controller, start, 150);
+    assert(admitted);
+
+    keepStanding(controller, start, 110, 200);
+    admitted = admitAt(controller, start, 200);  /* interval / sqrt(1) later */
+    assert(!admitted);
+
+    keepStanding(controller, start, 210, 270);
+    admitted = admitAt(controller, start, 270);  /* interval / sqrt(2) is 70.7ms */
+    assert(admitted);
+    admitted = admitAt(controller, start, 271);
+    assert(!admitted);
+    assert(controller.rejected() == 3);
+}
+
+void test_recent_episode_resumes_rate() {
+    AdmissionController controller(5ms, 100ms);
+    auto start = AdmissionController::Clock::now();
+
+    keepStanding(controller, start, 0, 330);
+    int rejected_at[] = {100, 200, 271, 329};
+    for (int ms : rejected_at) {
+        bool admitted = admitAt(controller, start, ms);
+        assert(!admitted);
+    }
+    controller.record(1ms, start + 335ms);
+    assert(!controller.shedding(start + 336ms));
+
+    /* Back above target soon after: the new episode starts at count 3, not 1 */
+    keepStanding(controller, start, 340, 500);
+    bool admitted = admitAt(controller, start, 440);
+    assert(!admitted);
+    admitted = admitAt(controller, start, 497);  /* interval / sqrt(3) is 57.7ms */
+    assert(admitted);
+    admitted = admitAt(controller, start, 498);
+    assert(!admitted);
+}
+
+int main() {
+    test_burst_is_not_shed();
+    test_standing_queue_is_shed();
+    test_shedding_lapses_without_samples();
+    test_rejections_follow_control_law();
+    test_recent_episode_resumes_rate();
+    std::cout << "[PASS] admission control tests" << std::endl;
+    return 0;
+}
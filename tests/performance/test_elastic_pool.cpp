@@ -0,0 +1,118 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "http/thread_pool.hpp"
+
+using namespace std::chrono_literals;
+
+Gecko::ThreadPool::ElasticConfig elastic(size_t max_threads, std::chrono::milliseconds idle_timeout) {
+    Gecko::ThreadPool::ElasticConfig config;
+    config.max_threads = max_threads;
+    config.queue_delay = 5ms;
+    config.blocked_after = 20ms;
+    config.idle_timeout = idle_timeout;
+    return config;
+}
+
+template<typename Predicate>
+bool wait_for(Predicate predicate, std::chrono::milliseconds limit) {
+    auto until = std::chrono::steady_clock::now() + limit;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() >= until) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+void test_fixed_pool_stays_fixed() {
+    Gecko::ThreadPool pool(2);
+    assert(pool.thread_count() == 2);
+    assert(pool.core_threads() == 2);
+    assert(pool.max_threads() == 2);
+
+    auto result = pool.enqueue([] { return 42; });
+    int value = result.get();
+    assert(value == 42);
+    assert(pool.thread_count() == 2);
+}
+
+/* Blocked workers are replaced, so queued work still runs while they sleep */
+void test_grows_past_blocked_workers() {
+    Gecko::ThreadPool pool(2, false, 2ms, elastic(6, 10s));
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+
+    for (int i = 0; i < 2; ++i) {
+        pool.post([gate] { gate.wait(); });
+    }
+    std::atomic<int> quick{0};
+    for (int i = 0; i < 8; ++i) {
+        pool.post([&quick] { quick++; });
+    }
+
+    bool ran = wait_for([&] { return quick.load() == 8; }, 2000ms);
+    assert(ran);
+    assert(pool.thread_count() > 2);
+    assert(pool.thread_count() <= pool.max_threads());
+
+    release.set_value();
+}
+
+/* Sustained backlog adds workers one queue_delay at a time, never past max_threads */
+void test_grows_under_backlog_up_to_max() {
+    Gecko::ThreadPool pool(1, false, 2ms, elastic(3, 10s));
+    std::atomic<int> done{0};
+    for (int i = 0; i < 60; ++i) {
+        pool.post([&done] {
+            std::this_thread::sleep_for(5ms);
+            done++;
+        });
+    }
+    bool grew = wait_for([&] { return pool.thread_count() == 3; }, 2000ms);
+    assert(grew);
+    bool finished = wait_for([&] { return done.load() == 60; }, 5000ms);
+    assert(finished);
+    assert(pool.thread_count() <= 3);
+}
+
+/* Burst workers retire after idle_timeout; the core stays */
+void test_shrinks_when_idle() {
+    Gecko::ThreadPool pool(1, false, 2ms, elastic(4, 50ms));
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    pool.post([gate] { gate.wait(); });
+    std::atomic<int> quick{0};
+    for (int i = 0; i < 4; ++i) {
+        pool.post([&quick] { quick++; });
+    }
+    bool ran = wait_for([&] { return quick.load() == 4; }, 2000ms);
+    assert(ran);
+    assert(pool.thread_count() > 1);
+    release.set_value();
+
+    bool shrunk = wait_for([&] { return pool.thread_count() == 1; }, 2000ms);
+    assert(shrunk);
+
+    /* Retired slots are reused when load returns */
+    auto result = pool.enqueue([] { return 7; });
+    int value = result.get();
+    assert(value == 7);
+}
+
+int main() {
+    test_fixed_pool_stays_fixed();
+    std::cout << "[PASS] fixed pool keeps its size" << std::endl;
+    test_grows_past_blocked_workers();
+    std::cout << "[PASS] blocked workers are replaced" << std::endl;
+    test_grows_under_backlog_up_to_max();
+    std::cout << "[PASS] backlog grows the pool up to max_threads" << std::endl;
+    test_shrinks_when_idle();
+    std::cout << "[PASS] idle burst workers retire" << std::endl;
+    return 0;
+}
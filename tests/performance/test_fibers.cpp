@@ -0,0 +1,147 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "http/context.hpp"
+#include "http/fiber.hpp"
+
+using namespace std::chrono_literals;
+
+int recurse(int depth) {
+    volatile char frame[1024];
+    frame[0] = static_cast<char>(depth);
+    return depth + recurse(depth + 1) + frame[0];
+}
+
+void test_guard_page_catches_overflow() {
+    /* Runs before any other thread exists, so forking is safe */
+    pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        Gecko::Fiber::start([] { recurse(0); }, 16 * 1024);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+}
+
+void test_inline_run_and_stack_reuse() {
+    int value = 0;
+    Gecko::Fiber::start([&value] {
+        assert(Gecko::Fiber::current() != nullptr);
+        value = 42;
+    });
+    assert(value == 42);
+    assert(Gecko::Fiber::current() == nullptr);
+
+    size_t cached = Gecko::FiberStackPool::instance().cached();
+    assert(cached >= 1);
+    Gecko::Fiber::start([] {});
+    assert(Gecko::FiberStackPool::instance().cached() == cached);
+}
+
+void test_sleeping_fibers_share_one_worker() {
+    constexpr int FIBERS = 200;
+    Gecko::ThreadPool pool(1);
+    std::atomic<int> completed{0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FIBERS; ++i) {
+        pool.post([&completed] {
+            Gecko::Fiber::start([&completed] {
+                Gecko::this_fiber::sleepFor(50ms);
+                Gecko::this_fiber::yield();
+                Gecko::this_fiber::sleepFor(20ms);
+                completed++;
+            });
+        });
+    }
+    auto deadline = start + 10s;
+    while (completed.load() < FIBERS && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert(completed.load() == FIBERS);
+    /* Two hundred 70ms waits overlap on a single OS thread */
+    assert(elapsed < 2s);
+}
+
+void test_read_parks_until_data() {
+    int fds[2];
+    int piped = pipe2(fds, O_NONBLOCK);
+    assert(piped == 0);
+
+    Gecko::ThreadPool pool(1);
+    std::atomic<bool> done{false};
+    std::string received;
+    pool.post([&] {
+        Gecko::Fiber::start([&] {
+            char buffer[16];
+            ssize_t count = Gecko::this_fiber::read(fds[0], buffer, sizeof(buffer));
+            if (count > 0) {
+                received.assign(buffer, static_cast<size_t>(count));
+            }
+            done = true;
+        });
+    });
+
+    /* The worker is free while the fiber waits */
+    auto free_worker = pool.enqueue([] { return 1; });
+    int ran = free_worker.get();
+    assert(ran == 1);
+    assert(!done.load());
+
+    ssize_t written = write(fds[1], "ping", 4);
+    assert(written == 4);
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!done.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    assert(done.load());
+    assert(received == "ping");
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void test_fiber_handler_defers_response() {
+    Gecko::ThreadPool pool(1);
+    Gecko::HttpRequest request(Gecko::HttpMethod::GET, "/blocking", Gecko::HttpVersion::HTTP_1_1, {}, "");
+    Gecko::Context ctx(request);
+    auto handler = Gecko::fiberHandler([](Gecko::Context& c) {
+        Gecko::this_fiber::sleepFor(20ms);  /* Blocking style, but only the fiber waits */
+        c.status(202).string("done");
+    });
+
+    std::atomic<bool> finished{false};
+    pool.post([&] {
+        handler(ctx);
+        ctx.onComplete([&finished] { finished = true; });
+    });
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!finished.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    assert(finished.load());
+    assert(ctx.isDeferred());
+    assert(ctx.response().getStatusCode() == 202);
+    assert(ctx.response().getBody() == "done");
+}
+
+int main() {
+    test_guard_page_catches_overflow();
+    test_inline_run_and_stack_reuse();
+    test_sleeping_fibers_share_one_worker();
+    test_read_parks_until_data();
+    test_fiber_handler_defers_response();
+    std::cout << "[PASS] fiber tests" << std::endl;
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "http/task_slot.hpp"
+#include "http/thread_pool.hpp"
+
+using namespace std::chrono_literals;
+
+struct Counted {
+    static int live;
+    Counted() { ++live; }
+    Counted(const Counted&) { ++live; }
+    Counted(Counted&&) noexcept { ++live; }
+    ~Counted() { --live; }
+};
+int Counted::live = 0;
+
+void test_inline_and_heap_storage() {
+    /* What the server posts per request: this, a connection, the raw request and a timestamp */
+    struct RequestCapture {
+        void* server;
+        std::shared_ptr<int> connection;
+        std::string data;
+        std::chrono::steady_clock::time_point start;
+        void operator()() {}
+    };
+    static_assert(Gecko::TaskSlot::fits_inline<RequestCapture>, "request task must not allocate");
+
+    struct Large {
+        std::array<char, 128> bytes{};
+        void operator()() {}
+    };
+    static_assert(!Gecko::TaskSlot::fits_inline<Large>, "oversized callables go to the heap");
+
+    int calls = 0;
+    {
+        Counted counted;
+        Gecko::TaskSlot small([&calls, counted] { ++calls; });
+        Gecko::TaskSlot large([&calls, counted, padding = std::array<char, 256>{}] { calls += 10; });
+        assert(Counted::live == 3);
+        small();
+        large();
+        assert(calls == 11);
+
+        /* Moving transfers the callable without copying it */
+        Gecko::TaskSlot moved(std::move(small));
+        assert(!small && moved);
+        Gecko::TaskSlot assigned;
+        assigned = std::move(large);
+        assert(!large && assigned);
+        assert(Counted::live == 3);
+        moved();
+        assigned();
+        assert(calls == 22);
+
+        assigned.reset();
+        assert(!assigned);
+        assert(Counted::live == 2);
+    }
+    assert(Counted::live == 0);
+}
+
+void test_post_move_only() {
+    Gecko::ThreadPool pool(2);
+    std::promise<int> promise;
+    auto result = promise.get_future();
+    auto value = std::make_unique<int>(41);
+
+    pool.post([value = std::move(value), promise = std::move(promise)]() mutable {
+        promise.set_value(*value + 1);
+    });
+    auto status = result.wait_for(2s);
+    assert(status == std::future_status::ready);
+    assert(result.get() == 42);
+}
+
+void test_post_nested_and_throwing() {
+    constexpr int TASKS = 2000;
+    std::atomic<int> completed{0};
+    {
+        Gecko::ThreadPool pool(3);
+        for (int i = 0; i < TASKS; ++i) {
+            pool.post([&pool, &completed, i] {
+                if (i % 100 == 0) {
+                    throw std::runtime_error("task failure is logged, not fatal");
+                }
+                pool.post([&completed] { completed++; });
+            });
+        }
+        auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (completed.load() < TASKS - TASKS / 100 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    assert(completed.load() == TASKS - TASKS / 100);
+}
+
+int main() {
+    test_inline_and_heap_storage();
+    test_post_move_only();
+    test_post_nested_and_throwing();
+    std::cout << "[PASS] task slot tests" << std::endl;
+    return 0;
+}
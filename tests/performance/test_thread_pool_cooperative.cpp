@@ -2,7 +2,9 @@
 #include <cassert>
 #include <chrono>
 #include <future>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include "http/thread_pool.hpp"
 
 using namespace std::chrono_literals;
@@ -50,7 +52,55 @@ void test_cooperative_requeue_and_completion() {
     assert(runs2.load() >= 3);
 }
 
+void test_earliest_deadline_first() {
+    using Pool = Gecko::ThreadPool;
+    Pool pool(1, true, std::chrono::milliseconds(1));
+
+    /* Hold the only worker until everything is queued */
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    pool.enqueue_cooperative([gate](Pool::TaskContext&) {
+        gate.wait();
+        return true;
+    });
+    std::this_thread::sleep_for(20ms);
+
+    std::mutex order_mutex;
+    std::vector<int> order;
+    std::promise<void> done;
+    auto record = [&](int id) {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(id);
+        if (order.size() == 5) {
+            done.set_value();
+        }
+    };
+
+    auto base = std::chrono::steady_clock::now() + 10s;
+    int deadlines_ms[] = {40, 10, 30, 20};
+    for (int id = 0; id < 4; ++id) {
+        pool.enqueue_cooperative([&record, id](Pool::TaskContext& ctx) {
+            assert(!ctx.expired());
+            record(id);
+            return true;
+        }, Pool::TaskPriority::NORMAL, std::chrono::milliseconds(0),
+           base + std::chrono::milliseconds(deadlines_ms[id]));
+    }
+    /* Priority still dominates: a HIGH task without a deadline goes first */
+    pool.enqueue_cooperative([&record](Pool::TaskContext&) {
+        record(4);
+        return true;
+    }, Pool::TaskPriority::HIGH);
+
+    release.set_value();
+    auto status = done.get_future().wait_for(2s);
+    assert(status == std::future_status::ready);
+    std::vector<int> expected = {4, 1, 3, 2, 0};
+    assert(order == expected);
+}
+
 int main() {
     test_cooperative_requeue_and_completion();
+    test_earliest_deadline_first();
     return 0;
 }
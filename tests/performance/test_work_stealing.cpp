@@ -0,0 +1,141 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "http/thread_pool.hpp"
+#include "http/work_stealing_deque.hpp"
+
+using namespace std::chrono_literals;
+
+void test_deque_order() {
+    Gecko::WorkStealingDeque<int*> deque(2);
+    int values[5] = {0, 1, 2, 3, 4};
+    for (int& value : values) {
+        deque.push(&value); /* Grows past the initial capacity */
+    }
+    assert(deque.size() == 5);
+
+    int* oldest = deque.steal();
+    assert(oldest == &values[0]);
+    int* newest = deque.pop();
+    assert(newest == &values[4]);
+    int* next = deque.pop();
+    assert(next == &values[3]);
+    next = deque.steal();
+    assert(next == &values[1]);
+    next = deque.pop();
+    assert(next == &values[2]);
+
+    int* none = deque.pop();
+    assert(none == nullptr);
+    none = deque.steal();
+    assert(none == nullptr);
+    assert(deque.empty());
+}
+
+void test_deque_concurrent_steal() {
+    constexpr int ITEMS = 100000;
+    constexpr int THIEVES = 3;
+    Gecko::WorkStealingDeque<int*> deque(64);
+    std::vector<int> items(ITEMS, 0);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < THIEVES; ++t) {
+        thieves.emplace_back([&] {
+            while (!done.load() || !deque.empty()) {
+                if (int* item = deque.steal()) {
+                    taken[item - items.data()]++;
+                }
+            }
+        });
+    }
+
+    /* The owner interleaves pushes and pops while thieves drain the other end */
+    for (int i = 0; i < ITEMS; ++i) {
+        deque.push(&items[i]);
+        if (i % 3 == 0) {
+            if (int* item = deque.pop()) {
+                taken[item - items.data()]++;
+            }
+        }
+    }
+    while (int* item = deque.pop()) {
+        taken[item - items.data()]++;
+    }
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    for (int i = 0; i < ITEMS; ++i) {
+        assert(taken[i].load() == 1);
+    }
+}
+
+void test_pool_external_and_nested() {
+    Gecko::ThreadPool pool(4);
+    constexpr int OUTER = 200;
+    constexpr int INNER = 50;
+    std::atomic<int> completed{0};
+
+    std::vector<std::future<void>> outer;
+    for (int i = 0; i < OUTER; ++i) {
+        outer.push_back(pool.enqueue([&pool, &completed] {
+            /* Submitted from a worker: lands on its own deque and may be stolen */
+            assert(Gecko::ThreadPool::current() == &pool);
+            for (int j = 0; j < INNER; ++j) {
+                pool.enqueue([&completed] { completed++; });
+            }
+            completed++;
+        }));
+    }
+    for (auto& f : outer) {
+        f.get();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (completed.load() < OUTER * (INNER + 1) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    assert(completed.load() == OUTER * (INNER + 1));
+
+    auto answer = pool.enqueue([](int x) { return x * 2; }, 21);
+    assert(answer.get() == 42);
+}
+
+void test_pool_wakes_after_idle() {
+    Gecko::ThreadPool pool(2);
+    /* Let the workers exhaust their spin budget and park */
+    std::this_thread::sleep_for(50ms);
+    auto result = pool.enqueue([] { return 7; });
+    auto status = result.wait_for(2s);
+    assert(status == std::future_status::ready);
+    assert(result.get() == 7);
+    assert(pool.pending_tasks() == 0);
+}
+
+void test_pool_drains_on_destruction() {
+    std::atomic<int> completed{0};
+    {
+        Gecko::ThreadPool pool(2);
+        for (int i = 0; i < 1000; ++i) {
+            pool.enqueue([&completed] { completed++; });
+        }
+    }
+    assert(completed.load() == 1000);
+}
+
+int main() {
+    test_deque_order();
+    test_deque_concurrent_steal();
+    test_pool_external_and_nested();
+    test_pool_wakes_after_idle();
+    test_pool_drains_on_destruction();
+    std::cout << "[PASS] work stealing tests" << std::endl;
+    return 0;
+}
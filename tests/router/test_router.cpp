@@ -339,6 +339,48 @@ void test_handler_execution() {
     
 }
 
+void test_catch_all_routes() {
+    Gecko::Router router;
+    auto files = wrap_response_handler(handlerHome);
+    auto users = wrap_response_handler(handlerUsers);
+    router.insert(Gecko::HttpMethod::GET, "/static/*filepath", files);
+    router.insert(Gecko::HttpMethod::GET, "/static/api/users", users);
+
+    auto nested = router.find(Gecko::HttpMethod::GET, "/static/css/site.css");
+    assert(nested.has_value());
+    assert(nested->params["filepath"] == "css/site.css");
+
+    auto empty = router.find(Gecko::HttpMethod::GET, "/static/");
+    assert(empty.has_value());
+    assert(empty->params["filepath"].empty());
+
+    /* Exact routes win; dead ends under them fall back to the catch-all */
+    auto exact = router.find(Gecko::HttpMethod::GET, "/static/api/users");
+    assert(exact.has_value() && exact->params.empty());
+    auto fallback = router.find(Gecko::HttpMethod::GET, "/static/api/other.js");
+    assert(fallback.has_value());
+    assert(fallback->params["filepath"] == "api/other.js");
+
+    assert(!router.find(Gecko::HttpMethod::GET, "/assets/x.js").has_value());
+}
+
+void test_route_executors() {
+    Gecko::Router router;
+    auto home = wrap_response_handler(handlerHome);
+    router.insert(Gecko::HttpMethod::GET, "/fast", home);
+    router.insert(Gecko::HttpMethod::GET, "/reports/:id", home, 2);
+    router.insert(Gecko::HttpMethod::GET, "/images/*filepath", home, 1);
+
+    auto fast = router.find(Gecko::HttpMethod::GET, "/fast");
+    assert(fast.has_value() && fast->executor == 0);
+    auto report = router.find(Gecko::HttpMethod::GET, "/reports/7");
+    assert(report.has_value() && report->executor == 2);
+    auto image = router.find(Gecko::HttpMethod::GET, "/images/a/b.png");
+    assert(image.has_value() && image->executor == 1);
+    auto image_root = router.find(Gecko::HttpMethod::GET, "/images/");
+    assert(image_root.has_value() && image_root->executor == 1);
+}
+
 int main() {
     test_split_path();
     test_static_routes();
@@ -349,6 +391,8 @@ int main() {
     test_route_conflicts();
     test_edge_cases();
     test_handler_execution();
+    test_catch_all_routes();
+    test_route_executors();
     
     std::cout << "all tests passed" << std::endl;
     return 0;